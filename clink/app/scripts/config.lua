@@ -11,7 +11,7 @@ local function clinkprompt_loader(module)
     local lower_module = clink.lower(module)
     local ret = loaded_clinkprompts[lower_module]
     if not ret then
-        local func, loaderr = loadfile(module)
+        local func, loaderr = clink._loadfile(module)
         if func then
             local old = clinkprompt_wrapping_module
             clinkprompt_wrapping_module = lower_module
@@ -214,8 +214,22 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
         associations[suffix:lower()] = true
     end
     local include_associations = settings.get("exec.associations")
-    for _, dir in ipairs(paths) do
-        added = add_files_by_association(dir.."*", false, include_associations) or added
+    if include_associations then
+        for _, dir in ipairs(paths) do
+            added = add_files_by_association(dir.."*", false, true) or added
+        end
+    elseif paths[1] then
+        -- The executable index already lists the files with executable
+        -- extensions in local directories.  Relative and remote directories
+        -- aren't indexed, so they're still globbed.
+        local hidden = settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files")
+        local num = match_builder:addmatches(clink._get_path_executables(hidden, settings.get("files.system")))
+        added = (num > 0) or added
+        for _, dir in ipairs(paths) do
+            if not path.getdrive(dir) or os.getdrivetype(dir) == "remote" then
+                added = add_files_by_association(dir.."*", false, false) or added
+            end
+        end
     end
 
     -- Should we also consider the path referenced by 'text'?
@@ -226,7 +240,7 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
 
     -- Lastly we may wish to consider directories too.
     if match_dirs or not added then
-        match_builder:addmatches(clink.dirmatchesexact(endword.."*"))
+        clink._add_dir_matches(match_builder, endword.."*", true)
     end
 
     return true
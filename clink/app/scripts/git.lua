@@ -3,7 +3,7 @@
 
 --------------------------------------------------------------------------------
 -- luacheck: globals git
-git = {}
+git = git or {} -- The native git provider adds internal functions.
 
 
 
@@ -21,42 +21,6 @@ local function get_parent(dir)
     end
 end
 
-local function is_absolute(pathname)
-    local drive = path.getdrive(pathname)
-    if not drive then return false end
-
-    local dir = path.getdirectory(pathname)
-    if not dir then return false end
-
-    return dir:find("^[/\\]") and true or false
-end
-
-local function join_into_absolute(parent, child)
-    -- gitdir can (apparently) be absolute or relative, but everything
-    -- downstream wants absolute paths.  Process leading .. and . path
-    -- components in child.
-    while true do
-        if child:find('^%.%.[/\\]') or child == '..' then
-            parent = path.toparent(parent)
-            child = child:sub(4)
-        elseif child:find('^%.[/\\]') or child == '.' then
-            child = child:sub(3)
-        else
-            break
-        end
-    end
-
-    -- Join the remaining parent and child.
-    return path.join(parent, child)
-end
-
--- Function that takes (dir, subdir) and returns "dir\subdir" if the subdir
--- exists, otherwise it returns nil.
-local function has_dir(dir, subdir)
-    local test = path.join(dir, subdir)
-    return os.isdir(test) and test or nil
-end
-
 --[[
 -- Function that takes (dir, file) and returns "dir\file" if the file exists,
 -- otherwise it returns nil.
@@ -228,58 +192,10 @@ function git.isgitdir(dir)
         return git_dir, git_dir, dir
     end
 
-    local function has_git_file(dir) -- luacheck: ignore 432
-        local dotgit = path.join(dir, ".git")
-        local gitfile
-        if os.isfile(dotgit) then
-            gitfile = io.open(dotgit)
-        end
-        if not gitfile then return end
-
-        local git_dir = (gitfile:read() or ""):match("gitdir: (.*)")
-        gitfile:close()
-
-        if git_dir then
-            -- gitdir can (apparently) be absolute or relative, so a custom
-            -- join routine is needed to build an absolute path regardless.
-            local abs_dir = join_into_absolute(dir, git_dir)
-            if os.isdir(abs_dir) then
-                return abs_dir
-            end
-        end
-    end
-
-    -- Return if it's a git dir.
-    local gitdir = has_dir(dir, ".git")
-    if gitdir then
-        gitdir = path.normalise(gitdir)
-        return gitdir, gitdir, dir
-    end
-
-    -- Check if it has a .git file.
-    gitdir = has_git_file(dir)
-    if gitdir then
-        -- Check if it has a worktree.
-        local gitdir_file = path.join(gitdir, "gitdir")
-        local file = io.open(gitdir_file)
-        local wks
-        if file then
-            wks = file:read("*l")
-            file:close()
-        end
-        -- If no worktree, check if submodule inside a repo.
-        if not wks then
-            wks = scan_upwards(dir, function (x)
-                return has_dir(x, ".git")
-            end)
-            if not wks then
-                -- No worktree and not nested inside a repo, so give up!
-                return
-            end
-        end
-        gitdir = path.normalise(gitdir)
-        wks = path.normalise(wks)
-        return gitdir, wks, dir
+    -- The native lookup remembers the result for each directory.
+    local git_dir, wks_dir = git._findrepo(dir, true--[[no_walk]])
+    if git_dir then
+        return git_dir, wks_dir, dir
     end
 end
 
@@ -304,7 +220,16 @@ end
 --- See <a href="#git.isgitdir">git.isgitdir()</a> for examples (they return
 --- the same strings).
 function git.getgitdir(dir)
-    return scan_upwards(dir, git.isgitdir)
+    if git._fake then
+        return scan_upwards(dir, git.isgitdir)
+    end
+
+    -- The native lookup remembers the result for each directory, so repeated
+    -- lookups in the same tree don't need to probe the file system again.
+    local git_dir, wks_dir, top_dir = git._findrepo(dir)
+    if git_dir then
+        return git_dir, wks_dir, top_dir
+    end
 end
 
 --------------------------------------------------------------------------------
@@ -319,16 +244,11 @@ end
 --- When in a worktree, this returns the git dir for the main repo, rather
 --- than the git dir of the worktree itself.
 function git.getcommondir(start_dir)
-    local git_dir = git.getgitdir(start_dir)
-    if not git_dir then return end
-
-    local commondirfile = io.open(path.join(git_dir, "commondir"))
-    if not commondirfile then return git_dir end
+    if git._fake then return (git.getgitdir(start_dir)) end
 
-    -- If there's a commondir file, we're in a git worktree
-    local commondir = commondirfile:read()
-    commondirfile.close()
-    return path.normalise(is_absolute(commondir) and commondir or path.join(git_dir, commondir))
+    -- When in a git worktree, the common dir comes from its commondir file.
+    local _, _, _, commondir = git._findrepo(start_dir)
+    return commondir
 end
 
 --------------------------------------------------------------------------------
@@ -407,6 +327,21 @@ function git.getremote(git_dir)
     end
 end
 
+--------------------------------------------------------------------------------
+-- Runs a git command through the native provider.  Concurrent callers share one
+-- in-flight query, and the output is reused until the repo's index or refs
+-- change (or until it's older than max_age seconds, when given).  Coroutines
+-- yield while the query runs, except where io.popenyield() would also run
+-- synchronously.
+local function query(command, max_age)
+    local git_dir, _, top_dir = git.getgitdir()
+    if not git_dir then return end
+
+    local command_line = git.makecommand(command)
+    local wait = not clink._can_coroutine_async()
+    return git._query(git_dir, top_dir, command_line, max_age, wait)
+end
+
 --------------------------------------------------------------------------------
 --- -name:  git.getconflictstatus
 --- -ver:   1.7.0
@@ -418,16 +353,8 @@ end
 function git.getconflictstatus()
     if git._fake then return git._fake.status and git._fake.status.untracked end
 
-    local file = io.popen(git.makecommand("diff --name-only --diff-filter=U"))
-    if not file then return false end
-
-    local conflict = false
-    for _ in file:lines() do -- luacheck: ignore 512
-        conflict = true
-        break
-    end
-    file:close()
-    return conflict
+    local output = query("diff --name-only --diff-filter=U")
+    return (output and output:find("[^\r\n]")) and true or false
 end
 
 --------------------------------------------------------------------------------
@@ -450,13 +377,10 @@ function git.getaheadbehind()
         ahead = git._fake.status and git._fake.status.ahead
         behind = git._fake.status and git._fake.status.behind
     else
-        local file = io.popen(git.makecommand("rev-list --count --left-right @{upstream}...HEAD"))
-        if not file then return end
-
-        for line in file:lines() do
+        local output = query("rev-list --count --left-right @{upstream}...HEAD") or ""
+        for line in output:gmatch("[^\r\n]+") do
             ahead, behind = string.match(line, "(%d+)[^%d]+(%d+)")
         end
-        file:close()
     end
 
     return ahead or "0", behind or "0"
@@ -554,8 +478,10 @@ function git.getstatus(no_untracked, include_submodules)
         submodule = submodule and true or nil
     end
 
-    local file = io.popen(git.makecommand("status "..flags.." --branch --porcelain=v2"))
-    if not file then return end
+    -- Changes in the working tree don't change the index or refs, so the status
+    -- is only shared briefly, e.g. between prompt filters for the same prompt.
+    local output = query("status "..flags.." --branch --porcelain=v2", 1)
+    if not output then return end
 
     local w_add, w_mod, w_del, w_con, w_unt = 0, 0, 0, 0, 0
     local s_add, s_mod, s_del, s_ren = 0, 0, 0, 0
@@ -569,7 +495,7 @@ function git.getstatus(no_untracked, include_submodules)
 
     local tick = os.clock()
     local processed = 0
-    for line in file:lines() do
+    for line in output:gmatch("[^\r\n]+") do
         if line:find("^# ") then
             local k, v = line:match("^#%sbranch%.([^%s]+)%s(.*)$")
             if k then
@@ -644,7 +570,6 @@ function git.getstatus(no_untracked, include_submodules)
             end
         end
     end
-    file:close()
 
     if not hasheader then return end
 
@@ -797,11 +722,10 @@ end
 function git.hasstash()
     if git._fake then return (git._fake.stashes or 0) > 0 end
 
-    local file = io.popen(git.makecommand("rev-parse --verify refs/stash"))
-    if not file then return end
+    local git_dir = git.getgitdir()
+    if not git_dir then return false end
 
-    local line = file:read("*l") or ""
-    return line ~= ""
+    return git._hasstash(git_dir)
 end
 
 --------------------------------------------------------------------------------
@@ -813,11 +737,10 @@ end
 function git.getstashcount()
     if git._fake then return git._fake.stashes or 0 end
 
-    local file = io.popen(git.makecommand("rev-list --walk-reflogs --count refs/stash"))
-    if not file then return end
+    local git_dir = git.getgitdir()
+    if not git_dir then return 0 end
 
-    local line = file:read("*l") or "0"
-    return tonumber(line)
+    return git._getstashcount(git_dir)
 end
 
 
@@ -134,7 +134,9 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
             func = filter[filter_func_name]
             if func or #type == 0 then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter("prompt", func)
                 filtered, onwards = func(filter, prompt)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, filter, filter_func_name)
                 if filtered ~= nil then
                     prompt = filtered
@@ -149,7 +151,9 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
                 func = filter[right_filter_func_name]
                 if func then
                     local tick = os.clock()
+                    local pt = clink._profiling and clink._profile_enter("rprompt", func)
                     filtered, onwards = func(filter, rprompt)
+                    if pt then clink._profile_leave(pt) end
                     log_cost(tick, filter, right_filter_func_name)
                     if filtered ~= nil then
                         rprompt = filtered
@@ -204,7 +204,9 @@ local function _do_suggest(line, lines, matches) -- luacheck: no unused
                 if suggester then
                     local func = suggester.suggest
                     if func then
+                        local pt = clink._profiling and clink._profile_enter("suggester", func)
                         local s, o = func(suggester, line, matches, limit)
+                        if pt then clink._profile_leave(pt) end
                         if _cancel then
                             return
                         end
@@ -15,6 +15,7 @@
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_tokeniser.h>
+#include <core/work_pool.h>
 #include <lib/recognizer.h>
 #include <lua/lua_task_manager.h>
 
@@ -73,6 +74,7 @@ static void shutdown_clink()
 
     shutdown_task_manager(true/*final*/);
     shutdown_recognizer();
+    work_pool::get().shutdown(1000);
 
     if (logger* logger = logger::get())
         delete logger;
@@ -23,11 +23,13 @@
 #include <lib/line_editor_integration.h>
 #include <lib/rl_integration.h>
 #include <lib/intercept.h>
+#include <lib/recognizer.h>
 #include <lib/clink_ctrlevent.h>
 #include <lib/clink_rl_signal.h>
 #include <lib/errfile_reader.h>
 #include <lib/sticky_search.h>
 #include <lib/display_readline.h>
+#include <lua/lua_allocator.h>
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
 #include <lua/prompt.h>
@@ -813,6 +815,7 @@ bool host::edit_line(const char* prompt, const char* rprompt, str_base& out, boo
     app->get_default_settings_file(default_settings_file);
     app->get_state_dir(state_dir);
     settings::load(settings_file.c_str(), default_settings_file.c_str());
+    set_recognizer_cache_dir(state_dir.c_str());
     reset_keyseq_to_name_map();
 
     // Set up the string comparison mode.
@@ -1389,6 +1392,9 @@ force_reload_lua:
         clink_shutdown_ctrlevent();
     }
 
+    // Release the Lua allocator's spare memory between edit lines.
+    trim_lua_allocator();
+
     std::list<queued_line> queue;
 
     if (!resolved)
@@ -15,6 +15,7 @@
 #include <core/settings.h>
 #include <core/log.h>
 #include <lib/rl_integration.h>
+#include <lua/lua_script_cache.h>
 #include <terminal/terminal_helpers.h>
 
 #include <vector>
@@ -154,6 +155,17 @@ bool host_lua::load_scripts(const char* paths)
     unsigned num_loaded = 0;
     unsigned num_failed = 0;
 
+    // Compiled scripts are cached in the state directory.
+    {
+        str<280> cache_dir;
+        app_context::get()->get_state_dir(cache_dir);
+        path::append(cache_dir, "lua_cache");
+        set_lua_script_cache_dir(cache_dir.c_str());
+    }
+
+    uint32 hits_before, misses_before;
+    get_lua_script_cache_stats(hits_before, misses_before);
+
     bool first = true;
 
     std::vector<wstr_moveable> seen_strings;
@@ -202,10 +214,14 @@ bool host_lua::load_scripts(const char* paths)
         load_script(tmp.c_str(), num_loaded, num_failed);
     }
 
+    uint32 hits, misses;
+    get_lua_script_cache_stats(hits, misses);
+    hits -= hits_before;
+
     if (num_failed)
-        LOG("Loaded %u Lua scripts in %u ms (%u failed)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed);
+        LOG("Loaded %u Lua scripts in %u ms, %u from cache (%u failed)", num_loaded, unsigned(clock.elapsed() * 1000), hits, num_failed);
     else
-        LOG("Loaded %u Lua scripts in %u ms", num_loaded, unsigned(clock.elapsed() * 1000));
+        LOG("Loaded %u Lua scripts in %u ms, %u from cache", num_loaded, unsigned(clock.elapsed() * 1000), hits);
 
     return true;
 }
@@ -218,6 +234,7 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
 
     globber lua_globs(buffer.c_str());
     lua_globs.directories(false);
+    lua_globs.long_names(true);
 
     while (lua_globs.next(buffer))
     {
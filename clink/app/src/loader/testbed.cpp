@@ -8,6 +8,7 @@
 #include <core/os.h>
 #include <core/str_compare.h>
 #include <core/settings.h>
+#include <core/work_pool.h>
 #include <lib/line_editor.h>
 #include <lib/match_generator.h>
 #include <lib/recognizer.h>
@@ -223,6 +224,7 @@ static int32 editline()
 
     shutdown_recognizer();
     shutdown_task_manager(true/*final*/);
+    work_pool::get().shutdown(1000);
 
     return 0;
 }
@@ -0,0 +1,51 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+#include "str_unordered_set.h"
+
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// Remembers recent os::get_drive_type() and os::get_path_type() results, so
+// that the input line can ask the same questions on each keystroke without a
+// system call each time.  That matters most for network and removable drives.
+//
+// Drive types are remembered for a while, since they rarely change.  Path
+// types are remembered only briefly, and are forgotten when a new input line
+// begins, since the previous command may have created or deleted files.
+// Everything is forgotten when the current directory changes, because
+// relative paths then refer to something else.
+class fs_query_cache
+{
+public:
+    static fs_query_cache& get();
+
+    int32               get_drive_type(const char* path, uint32 len=-1);
+    int32               get_path_type(const char* path);
+
+    void                invalidate();
+    void                invalidate_paths();
+    void                get_stats(uint32& lookups, uint32& hits) const;
+
+private:
+    struct entry
+    {
+        str_moveable    key;
+        int32           type;
+        double          time;
+    };
+
+    typedef str_unordered_map<entry> map;
+
+    static bool         find(const map& m, const char* key, double ttl, int32& type);
+    static void         store(map& m, const char* key, int32 type, double time);
+
+    mutable std::mutex  m_mutex;
+    map                 m_drives;           // Keys are owned by the entries.
+    map                 m_paths;            // Keys are owned by the entries.
+    uint32              m_lookups = 0;
+    uint32              m_hits = 0;
+};
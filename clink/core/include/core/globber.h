@@ -5,6 +5,27 @@
 
 #include "str.h"
 
+#include <memory>
+
+namespace path { class wild_pattern; };
+
+//------------------------------------------------------------------------------
+// Where a globber gets its directory entries.  The default enumerates the
+// file system; tests can supply synthetic entries instead.
+class dir_enumerator
+{
+public:
+    virtual             ~dir_enumerator() = default;
+    // Starts enumerating the names that match pattern, and returns the first
+    // one in data.  Returns false if there are none.
+    virtual bool        first(const wchar_t* pattern, WIN32_FIND_DATAW& data) = 0;
+    // Returns the next name in data, or false if there are no more.
+    virtual bool        next(WIN32_FIND_DATAW& data) = 0;
+    virtual void        close() = 0;
+};
+
+std::unique_ptr<dir_enumerator> make_find_file_enumerator();
+
 //------------------------------------------------------------------------------
 class globber
 {
@@ -19,7 +40,7 @@ public:
         FILETIME            created;
     };
 
-                        globber(const char* pattern);
+                        globber(const char* pattern, std::unique_ptr<dir_enumerator> enumerator=nullptr);
                         ~globber();
     void                files(bool state)       { m_files = state; }
     void                directories(bool state) { m_directories = state; }
@@ -27,6 +48,7 @@ public:
     void                hidden(bool state)      { m_hidden = state; }
     void                system(bool state)      { m_system = state; }
     void                dots(bool state)        { m_dots = state; }
+    void                long_names(bool state);
     bool                older_than(int32 seconds);
     bool                next(str_base& out, bool rooted=true, extrainfo* extrainfo=nullptr);
     void                close();
@@ -35,8 +57,11 @@ private:
                         globber(const globber&) = delete;
     void                operator = (const globber&) = delete;
     void                next_file();
+    str_moveable        m_filter_name;
+    std::unique_ptr<path::wild_pattern> m_name_filter;
+    std::unique_ptr<dir_enumerator> m_enumerator;
     WIN32_FIND_DATAW    m_data;
-    HANDLE              m_handle;
+    bool                m_open = false;
     str<280>            m_root;
     bool                m_files;
     bool                m_directories;
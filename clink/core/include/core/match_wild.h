@@ -6,6 +6,9 @@
 #include <core/path.h>
 #include <core/str_compare.h>
 #include <core/str_iter.h>
+#include <core/str.h>
+
+#include <vector>
 
 class str_base;
 
@@ -244,4 +247,35 @@ bool match_wild(const str_impl<T>& pattern, const str_impl<T>& file, bool dot_pr
     return match_wild(pattern_iter, file_iter, dot_prefix, match_everything);
 }
 
+//------------------------------------------------------------------------------
+// A pattern that's parsed once and then matched against many names, for
+// example when selecting matches.  The literal text before the first wildcard
+// and after the last wildcard is compared first, and the first character is
+// checked against a bitmap of the bytes it can match, so that most names that
+// can't match are rejected without running match_wild.
+//
+// The str_compare_scope mode is captured when the pattern is constructed.
+class wild_pattern
+{
+public:
+                        wild_pattern(const char* pattern, int32 len=-1, bool dot_prefix=false);
+    bool                match(const char* file, int32 len=-1, star_matches_everything match_everything=no) const;
+    bool                has_wildcards() const { return m_has_wildcards; }
+    const char*         get_pattern() const { return m_pattern.c_str(); }
+
+private:
+    bool                match_char(int32 pc, int32 fc) const;
+    bool                match_literals(const char* file, int32 len) const;
+
+    str_moveable        m_pattern;
+    std::vector<int32>  m_prefix;           // Literal codepoints before the first wildcard or separator.
+    std::vector<int32>  m_suffix;           // Literal codepoints after the last wildcard or separator.
+    uint32              m_first[8];         // Bytes that can match the first prefix codepoint.
+    int32               m_mode;
+    bool                m_fuzzy_accents;
+    bool                m_dot_prefix;
+    bool                m_has_wildcards = false;
+    bool                m_only_prefix = false;  // Literal prefix followed only by '*'.
+};
+
 }; // namespace path
@@ -65,6 +65,9 @@ DWORD   get_file_attributes(const wchar_t* path, bool* symlink=nullptr);
 DWORD   get_file_attributes(const char* path, bool* symlink=nullptr);
 int32   get_path_type(const char* path);
 int32   get_drive_type(const char* path, uint32 len=-1);
+bool    is_local_drive(const char* path);
+bool    get_file_system_name(const char* path, str_base& out);
+bool    get_dir_mtime(const char* dir, uint64& mtime);
 int32   get_file_size(const char* path);
 bool    is_hidden(const char* path);
 bool    get_current_dir(str_base& out);
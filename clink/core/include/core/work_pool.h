@@ -0,0 +1,111 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Each category has its own concurrency limit, so that for example slow
+// io.popenyield commands can't starve the recognizer.  Yield work has no limit,
+// since each command may run for a long time and commands must not queue
+// behind one another.
+enum class work_category : uint8
+{
+    yield,              // yield_thread (io.popenyield, os.executeyield, etc).
+    task,               // async_lua_task.
+    recognizer,         // Command word recognizer.
+    prefetch,           // Directory listing prefetch.
+    max
+};
+
+//------------------------------------------------------------------------------
+// A unit of work for the work_pool.  The item is also its own cancellation
+// token:  run() implementations should poll is_canceled() during long work,
+// and an item canceled before it starts gets skip() instead of run().
+class work_item
+{
+    friend class work_pool;
+
+public:
+    virtual         ~work_item() = default;
+    void            cancel() { m_canceled = true; }
+    bool            is_canceled() const { return m_canceled; }
+
+protected:
+    virtual void    run() = 0;
+    virtual void    skip() {}
+
+private:
+    std::atomic<bool> m_canceled { false };
+    bool            m_submitted = false;    // Guarded by the pool's mutex.
+    bool            m_finished = false;     // Guarded by the pool's mutex.
+    double          m_queued_clock = 0;
+};
+
+//------------------------------------------------------------------------------
+struct work_stats
+{
+    uint32          limit = 0;          // Max concurrently running items, or 0 for no limit.
+    uint32          queued = 0;         // Items currently waiting to run.
+    uint32          running = 0;        // Items currently running.
+    uint32          peak_queued = 0;
+    uint32          submitted = 0;
+    uint32          completed = 0;      // Includes canceled items.
+    uint32          canceled = 0;       // Items skipped because of cancel().
+    double          wait_time = 0;      // Total seconds items spent queued.
+    double          max_wait = 0;
+    double          run_time = 0;       // Total seconds items spent running.
+    double          max_run = 0;
+};
+
+//------------------------------------------------------------------------------
+// A pool of worker threads shared by the whole process.  Threads are created
+// on demand, up to the sum of the category limits, and are reused instead of
+// exiting when their work item finishes.
+class work_pool
+{
+public:
+    static work_pool& get();
+
+                    work_pool();
+                    ~work_pool();
+
+    void            set_limit(work_category category, uint32 limit);
+    bool            submit(work_category category, const std::shared_ptr<work_item>& item);
+    void            wait(const work_item* item);
+    void            shutdown(DWORD timeout=INFINITE);
+
+    void            get_stats(work_category category, work_stats& stats) const;
+    uint32          get_thread_count() const;
+    uint32          get_peak_thread_count() const;
+
+private:
+    struct category_state
+    {
+        std::deque<std::shared_ptr<work_item>> queue;
+        work_stats  stats;
+    };
+
+    static bool     can_run(const category_state& state);
+    uint32          count_runnable() const;
+    uint32          get_max_threads() const;
+    void            spawn();
+    void            proc();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work_cv;      // Signaled when work can run.
+    std::condition_variable m_finished_cv;  // Signaled when an item finishes.
+    category_state  m_categories[size_t(work_category::max)];
+    std::vector<std::thread> m_threads;
+    uint32          m_idle = 0;
+    uint32          m_next = 0;             // Category to check first.
+    uint32          m_peak_threads = 0;
+    bool            m_shutdown = false;
+};
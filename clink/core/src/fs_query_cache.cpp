@@ -0,0 +1,133 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_query_cache.h"
+#include "os.h"
+#include "str_transform.h"
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_entries = 256;
+static const double c_drive_ttl = 30.0;         // Seconds.
+static const double c_path_ttl = 2.0;           // Seconds.
+
+
+
+//------------------------------------------------------------------------------
+fs_query_cache& fs_query_cache::get()
+{
+    static fs_query_cache s_cache;
+    return s_cache;
+}
+
+//------------------------------------------------------------------------------
+int32 fs_query_cache::get_drive_type(const char* path, uint32 len)
+{
+    if (len == uint32(-1))
+        len = uint32(strlen(path));
+
+    // Paths are compared case insensitively.
+    str<> key;
+    str_transform(path, len, key, transform_mode::lower);
+
+    int32 type;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_lookups;
+        if (find(m_drives, key.c_str(), c_drive_ttl, type))
+        {
+            ++m_hits;
+            return type;
+        }
+    }
+
+    type = os::get_drive_type(path, len);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    store(m_drives, key.c_str(), type, os::clock());
+    return type;
+}
+
+//------------------------------------------------------------------------------
+int32 fs_query_cache::get_path_type(const char* path)
+{
+    // Paths are compared case insensitively.
+    str<> key;
+    str_transform(path, uint32(strlen(path)), key, transform_mode::lower);
+
+    int32 type;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_lookups;
+        if (find(m_paths, key.c_str(), c_path_ttl, type))
+        {
+            ++m_hits;
+            return type;
+        }
+    }
+
+    type = os::get_path_type(path);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    store(m_paths, key.c_str(), type, os::clock());
+    return type;
+}
+
+//------------------------------------------------------------------------------
+void fs_query_cache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_drives.clear();
+    m_paths.clear();
+}
+
+//------------------------------------------------------------------------------
+void fs_query_cache::invalidate_paths()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paths.clear();
+}
+
+//------------------------------------------------------------------------------
+void fs_query_cache::get_stats(uint32& lookups, uint32& hits) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    lookups = m_lookups;
+    hits = m_hits;
+}
+
+//------------------------------------------------------------------------------
+bool fs_query_cache::find(const map& m, const char* key, double ttl, int32& type)
+{
+    auto iter = m.find(key);
+    if (iter == m.end())
+        return false;
+    if (os::clock() - iter->second.time >= ttl)
+        return false;
+
+    type = iter->second.type;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void fs_query_cache::store(map& m, const char* key, int32 type, double time)
+{
+    auto iter = m.find(key);
+    if (iter != m.end())
+    {
+        iter->second.type = type;
+        iter->second.time = time;
+        return;
+    }
+
+    // The entries are cheap to recreate, so simply start over when full.
+    if (m.size() >= c_max_entries)
+        m.clear();
+
+    entry e;
+    e.key = key;
+    e.type = type;
+    e.time = time;
+    const char* k = e.key.c_str();
+    m.emplace(k, std::move(e));
+}
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "globber.h"
+#include "match_wild.h"
 #include "os.h"
 #include "path.h"
 #include "str.h"
@@ -10,8 +11,83 @@
 #include <sys/stat.h>
 
 //------------------------------------------------------------------------------
-globber::globber(const char* pattern)
-: m_files(true)
+static bool can_filter_long_names(const char* name)
+{
+    // FindFirstFileW also matches against short 8.3 names, so for example
+    // "*.htm" finds "page.html" through its short name "PAGE~1.HTM".  Check
+    // the long names against the pattern, except for patterns whose meaning
+    // differs from path::match_wild:  "*.*", a trailing ".", DOS wildcards,
+    // or patterns that look like they're intended to match a short name.
+    if (!strpbrk(name, "*?"))
+        return false;
+    if (strpbrk(name, "<>\"~"))
+        return false;
+    if (strcmp(name, "*") == 0 || strcmp(name, "*.*") == 0)
+        return false;
+    const size_t len = strlen(name);
+    return name[len - 1] != '.';
+}
+
+
+
+//------------------------------------------------------------------------------
+class find_file_enumerator : public dir_enumerator
+{
+public:
+                        ~find_file_enumerator() override { close(); }
+    bool                first(const wchar_t* pattern, WIN32_FIND_DATAW& data) override;
+    bool                next(WIN32_FIND_DATAW& data) override;
+    void                close() override;
+
+private:
+    HANDLE              m_handle = nullptr;
+};
+
+//------------------------------------------------------------------------------
+bool find_file_enumerator::first(const wchar_t* pattern, WIN32_FIND_DATAW& data)
+{
+    close();
+
+    // Basic info skips looking up the short 8.3 names, which are never used,
+    // and large fetch lets the file system return more entries per request,
+    // which matters most in large directories.
+    m_handle = FindFirstFileExW(pattern, FindExInfoBasic, &data, FindExSearchNameMatch,
+                                nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (m_handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER)
+        m_handle = FindFirstFileW(pattern, &data);
+    if (m_handle == INVALID_HANDLE_VALUE)
+        m_handle = nullptr;
+    return !!m_handle;
+}
+
+//------------------------------------------------------------------------------
+bool find_file_enumerator::next(WIN32_FIND_DATAW& data)
+{
+    return m_handle && FindNextFileW(m_handle, &data);
+}
+
+//------------------------------------------------------------------------------
+void find_file_enumerator::close()
+{
+    if (m_handle)
+    {
+        FindClose(m_handle);
+        m_handle = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+std::unique_ptr<dir_enumerator> make_find_file_enumerator()
+{
+    return std::make_unique<find_file_enumerator>();
+}
+
+
+
+//------------------------------------------------------------------------------
+globber::globber(const char* pattern, std::unique_ptr<dir_enumerator> enumerator)
+: m_enumerator(enumerator ? std::move(enumerator) : make_find_file_enumerator())
+, m_files(true)
 , m_directories(true)
 , m_dir_suffix(true)
 , m_hidden(false)
@@ -26,10 +102,7 @@ globber::globber(const char* pattern)
     // Don't bother trying to complete a UNC path that doesn't have at least
     // both a server and share component.
     if (path::is_incomplete_unc(pattern))
-    {
-        m_handle = nullptr;
         return;
-    }
 
     // Windows: Expand if the path to complete is drive relative (e.g. 'c:foobar')
     // Drive X's current path is stored in the environment variable "=X:"
@@ -60,12 +133,15 @@ globber::globber(const char* pattern)
             if (name[index] == '\0')
                 dots(true);
         }
+
+        // Remember the name part in case long_names() is used.  Not when
+        // including `.` and `..`, which are special cases anyway.
+        if (name && !m_dots && can_filter_long_names(name))
+            m_filter_name = name;
     }
 
     wstr<280> wglob(pattern);
-    m_handle = FindFirstFileW(wglob.c_str(), &m_data);
-    if (m_handle == INVALID_HANDLE_VALUE)
-        m_handle = nullptr;
+    m_open = m_enumerator->first(wglob.c_str(), m_data);
 
     path::get_directory(pattern, m_root);
     path::normalise_separators(m_root.data());
@@ -77,6 +153,24 @@ globber::~globber()
     close();
 }
 
+//------------------------------------------------------------------------------
+// Only returns names whose long names match the pattern; see
+// can_filter_long_names().  This differs from what CMD and FindFirstFileW
+// return, so it's only for internal callers; os.globfiles() and the other Lua
+// APIs keep the FindFirstFileW behavior.
+void globber::long_names(bool state)
+{
+    if (state && !m_filter_name.empty())
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+        m_name_filter = std::make_unique<path::wild_pattern>(m_filter_name.c_str());
+    }
+    else
+    {
+        m_name_filter.reset();
+    }
+}
+
 //------------------------------------------------------------------------------
 bool globber::older_than(int32 seconds)
 {
@@ -106,7 +200,7 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 {
     while (true)
     {
-        if (m_handle == nullptr)
+        if (!m_open)
             return false;
 
         bool again = false;
@@ -123,6 +217,12 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
         if (m_onlyolder)
             again |= !(CompareFileTime(&m_data.ftLastWriteTime, &m_olderthan) < 0);
 
+        if (!again && m_name_filter)
+        {
+            str<280> file_name(m_data.cFileName);
+            again |= !m_name_filter->match(file_name.c_str(), file_name.length());
+        }
+
         if (!again)
             break;
 
@@ -172,16 +272,16 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 //------------------------------------------------------------------------------
 void globber::close()
 {
-    if (m_handle)
+    if (m_open)
     {
-        FindClose(m_handle);
-        m_handle = nullptr;
+        m_enumerator->close();
+        m_open = false;
     }
 }
 
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
-    if (m_handle && !FindNextFileW(m_handle, &m_data))
+    if (m_open && !m_enumerator->next(m_data))
         close();
 }
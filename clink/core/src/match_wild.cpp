@@ -0,0 +1,155 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "match_wild.h"
+
+namespace path
+{
+
+//------------------------------------------------------------------------------
+static bool is_wild_or_separator(int32 c)
+{
+    return c == '*' || c == '?' || path::is_separator(c);
+}
+
+
+
+//------------------------------------------------------------------------------
+wild_pattern::wild_pattern(const char* pattern, int32 len, bool dot_prefix)
+: m_mode(str_compare_scope::current())
+, m_fuzzy_accents(str_compare_scope::current_fuzzy_accents())
+, m_dot_prefix(dot_prefix)
+{
+    if (len < 0)
+        len = int32(strlen(pattern));
+    m_pattern.concat(pattern, len);
+
+    std::vector<int32> codepoints;
+    str_iter iter(m_pattern.c_str(), m_pattern.length());
+    while (int32 c = iter.next())
+    {
+        codepoints.emplace_back(c);
+        if (c == '*' || c == '?')
+            m_has_wildcards = true;
+    }
+
+    memset(m_first, 0, sizeof(m_first));
+
+    // The dot_prefix mode can skip leading dots in the file name, so the
+    // literal text isn't necessarily at the start of the file name.
+    if (dot_prefix)
+        return;
+
+    size_t first = 0;
+    while (first < codepoints.size() && !is_wild_or_separator(codepoints[first]))
+        ++first;
+    m_prefix.assign(codepoints.begin(), codepoints.begin() + first);
+
+    size_t last = codepoints.size();
+    while (last > 0 && !is_wild_or_separator(codepoints[last - 1]))
+        --last;
+    m_suffix.assign(codepoints.begin() + last, codepoints.end());
+
+    m_only_prefix = (first < codepoints.size() && codepoints[first] == '*');
+    for (size_t i = first; m_only_prefix && i < codepoints.size(); ++i)
+        m_only_prefix = (codepoints[i] == '*');
+
+    if (!m_prefix.empty())
+    {
+        // Bytes 0x80 and higher are part of multibyte characters; those can
+        // only be decided by comparing the whole character.
+        for (int32 b = 1; b < 0x80; ++b)
+            if (match_char(m_prefix[0], b))
+                m_first[b >> 5] |= 1 << (b & 31);
+        for (int32 b = 0x80; b < 0x100; ++b)
+            m_first[b >> 5] |= 1 << (b & 31);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool wild_pattern::match(const char* file, int32 len, star_matches_everything match_everything) const
+{
+    if (len < 0)
+        len = int32(strlen(file));
+
+    if (!match_literals(file, len))
+        return false;
+    if (m_only_prefix && match_everything >= yes)
+        return true;
+
+    str_iter pattern_iter(m_pattern.c_str(), m_pattern.length());
+    str_iter file_iter(file, len);
+    switch (m_mode)
+    {
+    case str_compare_scope::relaxed:
+        if (m_fuzzy_accents)    return match_wild_impl<char, 2, true>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+        else                    return match_wild_impl<char, 2, false>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+    case str_compare_scope::caseless:
+        if (m_fuzzy_accents)    return match_wild_impl<char, 1, true>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+        else                    return match_wild_impl<char, 1, false>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+    default:
+        if (m_fuzzy_accents)    return match_wild_impl<char, 0, true>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+        else                    return match_wild_impl<char, 0, false>(pattern_iter, file_iter, m_dot_prefix, match_everything);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool wild_pattern::match_char(int32 pc, int32 fc) const
+{
+    switch (m_mode)
+    {
+    case str_compare_scope::relaxed:
+        if (m_fuzzy_accents)    return match_char_impl<char, 2, true>(pc, fc);
+        else                    return match_char_impl<char, 2, false>(pc, fc);
+    case str_compare_scope::caseless:
+        if (m_fuzzy_accents)    return match_char_impl<char, 1, true>(pc, fc);
+        else                    return match_char_impl<char, 1, false>(pc, fc);
+    default:
+        if (m_fuzzy_accents)    return match_char_impl<char, 0, true>(pc, fc);
+        else                    return match_char_impl<char, 0, false>(pc, fc);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool wild_pattern::match_literals(const char* file, int32 len) const
+{
+    // Literals match one character each, so the file must start with the
+    // prefix and end with the suffix.
+
+    if (!m_prefix.empty())
+    {
+        const uint8 b = uint8(len ? file[0] : 0);
+        if (!(m_first[b >> 5] & (1 << (b & 31))))
+            return false;
+
+        str_iter iter(file, len);
+        for (int32 pc : m_prefix)
+        {
+            const int32 fc = iter.next();
+            if (!fc || !match_char(pc, fc))
+                return false;
+        }
+    }
+
+    if (!m_suffix.empty())
+    {
+        const char* end = file + len;
+        for (size_t i = m_suffix.size(); i--;)
+        {
+            if (end <= file)
+                return false;
+            const char* p = end - 1;
+            while (p > file && (uint8(*p) & 0xc0) == 0x80)
+                --p;
+            str_iter iter(p, int32(end - p));
+            if (!match_char(m_suffix[i], iter.next()))
+                return false;
+            end = p;
+        }
+    }
+
+    return true;
+}
+
+}; // namespace path
@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "os.h"
 #include "cwd_restorer.h"
+#include "fs_query_cache.h"
 #include "path.h"
 #include "str.h"
 #include "str_iter.h"
@@ -465,6 +466,55 @@ int32 get_drive_type(const char* _path, uint32 len)
     }
 }
 
+//------------------------------------------------------------------------------
+// Returns whether the path begins with a drive letter for a removable, fixed,
+// or RAM disk drive.  UNC paths and drives that are unknown, invalid, or
+// remote aren't local; reading them in the background could stall for a long
+// time.  Drive types are cached by fs_query_cache.
+bool is_local_drive(const char* path)
+{
+    if (!path || !path[0] || path[1] != ':')
+        return false;
+
+    const char drive[] = { path[0], ':', '\\', '\0' };
+    return fs_query_cache::get().get_drive_type(drive) >= drive_type_removable;
+}
+
+//------------------------------------------------------------------------------
+// Gets the name of the file system (e.g. "NTFS", "FAT32", or "exFAT") of the
+// volume containing the path, which must begin with a drive letter.
+bool get_file_system_name(const char* path, str_base& out)
+{
+    out.clear();
+    if (!path || !path[0] || path[1] != ':')
+        return false;
+
+    const wchar_t root[] = { wchar_t(uint8(path[0])), ':', '\\', '\0' };
+    wchar_t name[MAX_PATH + 1];
+    if (!GetVolumeInformationW(root, nullptr, 0, nullptr, nullptr, nullptr, name, sizeof_array(name)))
+        return false;
+
+    to_utf8(out, name);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Gets the last write time of a directory.  Adding, removing, or renaming a
+// file in the directory updates it.  Returns false if the path doesn't exist
+// or isn't a directory.
+bool get_dir_mtime(const char* dir, uint64& mtime)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    mtime = (uint64(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 bool is_hidden(const char* path)
 {
@@ -527,7 +577,10 @@ bool set_current_dir(const char* dir)
 {
     wstr<280> wdir(dir);
     if (SetCurrentDirectoryW(wdir.c_str()))
+    {
+        fs_query_cache::get().invalidate();
         return true;
+    }
 
     map_errno();
     return false;
@@ -0,0 +1,266 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "work_pool.h"
+#include "os.h"
+#include "debugheap.h"
+
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+static const uint32 c_default_limits[] =
+{
+    0,      // yield:  commands can run for a long time, so no limit.
+    8,      // task.
+    1,      // recognizer:  the recognizer raises this per clink.recognizer_workers.
+    1,      // prefetch:  reading directories is disk bound, so one at a time.
+};
+static_assert(sizeof_array(c_default_limits) == size_t(work_category::max), "c_default_limits doesn't match work_category");
+
+
+
+//------------------------------------------------------------------------------
+work_pool& work_pool::get()
+{
+    // Intentionally never destroyed:  shutdown() joins the threads, but a
+    // thread still running a long item is left running while the process
+    // shuts down.
+    static work_pool* s_pool = nullptr;
+    if (!s_pool)
+    {
+        dbg_ignore_scope(snapshot, "Work pool");
+        s_pool = new work_pool;
+    }
+    return *s_pool;
+}
+
+//------------------------------------------------------------------------------
+work_pool::work_pool()
+{
+    for (size_t i = 0; i < sizeof_array(m_categories); ++i)
+        m_categories[i].stats.limit = c_default_limits[i];
+}
+
+//------------------------------------------------------------------------------
+work_pool::~work_pool()
+{
+    shutdown();
+}
+
+//------------------------------------------------------------------------------
+void work_pool::shutdown(DWORD timeout)
+{
+    std::vector<std::thread> threads;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        threads.swap(m_threads);
+    }
+    m_work_cv.notify_all();
+
+    // Threads finish the items that are already running, and skip the rest.
+    // Threads that don't finish in time are still running a long item, such
+    // as a command for io.popenyield; they're detached so shutdown can't hang.
+    const DWORD start = GetTickCount();
+    for (auto& thread : threads)
+    {
+        DWORD remaining = timeout;
+        if (timeout != INFINITE)
+        {
+            const DWORD elapsed = GetTickCount() - start;
+            remaining = (elapsed < timeout) ? timeout - elapsed : 0;
+        }
+
+        if (WaitForSingleObject(thread.native_handle(), remaining) == WAIT_OBJECT_0)
+            thread.join();
+        else
+            thread.detach();
+    }
+}
+
+//------------------------------------------------------------------------------
+void work_pool::set_limit(work_category category, uint32 limit)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_categories[size_t(category)].stats.limit = limit;
+        while (!m_shutdown && m_threads.size() < get_max_threads() && count_runnable() > m_idle)
+            spawn();
+    }
+    m_work_cv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+bool work_pool::submit(work_category category, const std::shared_ptr<work_item>& item)
+{
+    assert(category < work_category::max);
+    assert(item);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_shutdown || item->m_submitted)
+            return false;
+
+        category_state& state = m_categories[size_t(category)];
+        item->m_submitted = true;
+        item->m_queued_clock = os::clock();
+
+        {
+            dbg_ignore_scope(snapshot, "Work pool");
+            state.queue.push_back(item);
+        }
+
+        ++state.stats.submitted;
+        state.stats.queued = uint32(state.queue.size());
+        state.stats.peak_queued = max(state.stats.peak_queued, state.stats.queued);
+
+        if (can_run(state) && count_runnable() > m_idle && m_threads.size() < get_max_threads())
+            spawn();
+    }
+
+    m_work_cv.notify_one();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void work_pool::wait(const work_item* item)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (item->m_submitted)
+        m_finished_cv.wait(lock, [item] () { return item->m_finished; });
+}
+
+//------------------------------------------------------------------------------
+void work_pool::get_stats(work_category category, work_stats& stats) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats = m_categories[size_t(category)].stats;
+}
+
+//------------------------------------------------------------------------------
+uint32 work_pool::get_thread_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return uint32(m_threads.size());
+}
+
+//------------------------------------------------------------------------------
+uint32 work_pool::get_peak_thread_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_peak_threads;
+}
+
+//------------------------------------------------------------------------------
+bool work_pool::can_run(const category_state& state)
+{
+    return !state.queue.empty() && (!state.stats.limit || state.stats.running < state.stats.limit);
+}
+
+//------------------------------------------------------------------------------
+uint32 work_pool::count_runnable() const
+{
+    uint32 runnable = 0;
+    for (const auto& state : m_categories)
+    {
+        if (!state.stats.limit)
+            runnable += uint32(state.queue.size());
+        else if (state.stats.running < state.stats.limit)
+            runnable += min(uint32(state.queue.size()), state.stats.limit - state.stats.running);
+    }
+    return runnable;
+}
+
+//------------------------------------------------------------------------------
+uint32 work_pool::get_max_threads() const
+{
+    uint32 total = 0;
+    for (const auto& state : m_categories)
+    {
+        if (!state.stats.limit)
+            return uint32(-1);
+        total += state.stats.limit;
+    }
+    return total;
+}
+
+//------------------------------------------------------------------------------
+void work_pool::spawn()
+{
+    // The new thread counts as idle until it picks up an item, so that
+    // submitting several items at once doesn't overshoot.
+    dbg_ignore_scope(snapshot, "Work pool thread");
+    m_threads.emplace_back(&work_pool::proc, this);
+    ++m_idle;
+    m_peak_threads = max(m_peak_threads, uint32(m_threads.size()));
+}
+
+//------------------------------------------------------------------------------
+void work_pool::proc()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        // Find a category with work that's under its limit.  Rotate the
+        // starting category so one busy category can't monopolize the pool.
+        category_state* state = nullptr;
+        for (uint32 i = 0; i < sizeof_array(m_categories); ++i)
+        {
+            const uint32 index = (m_next + i) % sizeof_array(m_categories);
+            if (can_run(m_categories[index]))
+            {
+                state = &m_categories[index];
+                m_next = index + 1;
+                break;
+            }
+        }
+
+        if (!state)
+        {
+            if (m_shutdown)
+                break;
+            m_work_cv.wait(lock);
+            continue;
+        }
+
+        std::shared_ptr<work_item> item = std::move(state->queue.front());
+        state->queue.pop_front();
+        state->stats.queued = uint32(state->queue.size());
+        ++state->stats.running;
+        --m_idle;
+
+        const double start = os::clock();
+        const double waited = start - item->m_queued_clock;
+        state->stats.wait_time += waited;
+        state->stats.max_wait = max(state->stats.max_wait, waited);
+
+        const bool canceled = m_shutdown || item->is_canceled();
+
+        lock.unlock();
+        if (canceled)
+            item->skip();
+        else
+            item->run();
+        const double elapsed = os::clock() - start;
+        lock.lock();
+
+        --state->stats.running;
+        ++state->stats.completed;
+        if (canceled)
+            ++state->stats.canceled;
+        state->stats.run_time += elapsed;
+        state->stats.max_run = max(state->stats.max_run, elapsed);
+        item->m_finished = true;
+        ++m_idle;
+
+        // Release the item outside the lock, in case its destructor is slow.
+        lock.unlock();
+        m_finished_cv.notify_all();
+        item.reset();
+        lock.lock();
+    }
+}
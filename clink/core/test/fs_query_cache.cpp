@@ -0,0 +1,89 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/fs_query_cache.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("File system query cache")
+{
+    fs_fixture fs;
+
+    fs_query_cache& cache = fs_query_cache::get();
+    cache.invalidate();
+
+    str<> dir(fs.get_root());
+    path::append(dir, "dir1");
+    str<> file(fs.get_root());
+    path::append(file, "file1");
+    str<> added(fs.get_root());
+    path::append(added, "added");
+
+    SECTION("Path types")
+    {
+        uint32 lookups, hits;
+        uint32 prev_lookups, prev_hits;
+        cache.get_stats(prev_lookups, prev_hits);
+
+        REQUIRE(cache.get_path_type(dir.c_str()) == os::path_type_dir);
+        REQUIRE(cache.get_path_type(file.c_str()) == os::path_type_file);
+        REQUIRE(cache.get_path_type(added.c_str()) == os::path_type_invalid);
+
+        // Repeated queries are answered from the cache, regardless of case.
+        str<> upper(fs.get_root());
+        path::append(upper, "FILE1");
+        REQUIRE(cache.get_path_type(dir.c_str()) == os::path_type_dir);
+        REQUIRE(cache.get_path_type(upper.c_str()) == os::path_type_file);
+
+        cache.get_stats(lookups, hits);
+        REQUIRE(lookups - prev_lookups == 5);
+        REQUIRE(hits - prev_hits == 2);
+
+        // Creating a file is noticed once paths are invalidated, as happens
+        // when a new input line begins.
+        FILE* f = fopen(added.c_str(), "wt");
+        REQUIRE(f != nullptr);
+        fclose(f);
+        REQUIRE(cache.get_path_type(added.c_str()) == os::path_type_invalid);
+        cache.invalidate_paths();
+        REQUIRE(cache.get_path_type(added.c_str()) == os::path_type_file);
+    }
+
+    SECTION("Drive types")
+    {
+        str<> drive;
+        REQUIRE(path::get_drive(fs.get_root(), drive));
+        path::append(drive, "");
+
+        const int32 type = os::get_drive_type(drive.c_str());
+        REQUIRE(cache.get_drive_type(drive.c_str()) == type);
+
+        uint32 prev_lookups, prev_hits;
+        cache.get_stats(prev_lookups, prev_hits);
+
+        // Invalidating paths keeps drive types.
+        cache.invalidate_paths();
+        REQUIRE(cache.get_drive_type(drive.c_str()) == type);
+
+        uint32 lookups, hits;
+        cache.get_stats(lookups, hits);
+        REQUIRE(lookups - prev_lookups == 1);
+        REQUIRE(hits - prev_hits == 1);
+    }
+
+    SECTION("Changing directory")
+    {
+        REQUIRE(cache.get_path_type("dir1") == os::path_type_dir);
+
+        // Relative paths refer to something else after changing directory.
+        REQUIRE(os::set_current_dir("dir1"));
+        REQUIRE(cache.get_path_type("dir1") == os::path_type_invalid);
+        REQUIRE(os::set_current_dir(".."));
+        REQUIRE(cache.get_path_type("dir1") == os::path_type_dir);
+    }
+}
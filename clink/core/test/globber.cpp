@@ -0,0 +1,147 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/globber.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Returns synthetic entries regardless of the pattern, the same way the file
+// system can return names that only match through their short 8.3 names.
+class synthetic_enumerator : public dir_enumerator
+{
+public:
+                    synthetic_enumerator(const std::vector<WIN32_FIND_DATAW>& entries) : m_entries(entries) {}
+    bool            first(const wchar_t* pattern, WIN32_FIND_DATAW& data) override { m_index = 0; return next(data); }
+    bool            next(WIN32_FIND_DATAW& data) override
+                    {
+                        if (m_index >= m_entries.size())
+                            return false;
+                        data = m_entries[m_index++];
+                        return true;
+                    }
+    void            close() override { m_index = m_entries.size(); }
+
+private:
+    const std::vector<WIN32_FIND_DATAW>& m_entries;
+    size_t          m_index = 0;
+};
+
+//------------------------------------------------------------------------------
+static void add_entry(std::vector<WIN32_FIND_DATAW>& entries, const wchar_t* name, DWORD attr)
+{
+    WIN32_FIND_DATAW data = {};
+    wcscpy_s(data.cFileName, name);
+    data.dwFileAttributes = attr;
+    entries.emplace_back(data);
+}
+
+//------------------------------------------------------------------------------
+static uint32 count_matches(globber& g)
+{
+    uint32 count = 0;
+    str<> file;
+    while (g.next(file, false))
+        ++count;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("globber : large directory")
+{
+    // A directory with 100k entries:  every 10th is a directory, every 7th is
+    // hidden, and every 13th is a system file.
+    static const uint32 c_count = 100000;
+    std::vector<WIN32_FIND_DATAW> entries;
+    entries.reserve(c_count + 2);
+    add_entry(entries, L".", FILE_ATTRIBUTE_DIRECTORY);
+    add_entry(entries, L"..", FILE_ATTRIBUTE_DIRECTORY);
+
+    uint32 visible_files = 0, visible_dirs = 0, txt = 0;
+    for (uint32 i = 0; i < c_count; ++i)
+    {
+        const bool is_dir = !(i % 10);
+        const bool is_hidden = !(i % 7);
+        const bool is_system = !(i % 13);
+
+        DWORD attr = 0;
+        if (is_dir)     attr |= FILE_ATTRIBUTE_DIRECTORY;
+        if (is_hidden)  attr |= FILE_ATTRIBUTE_HIDDEN;
+        if (is_system)  attr |= FILE_ATTRIBUTE_SYSTEM;
+        if (!attr)      attr = FILE_ATTRIBUTE_NORMAL;
+
+        wchar_t name[32];
+        swprintf_s(name, is_dir ? L"dir%06u" : L"file%06u.%s", i, (i & 1) ? L"txt" : L"html");
+        add_entry(entries, name, attr);
+
+        if (!is_hidden && !is_system)
+        {
+            if (is_dir)
+                ++visible_dirs;
+            else
+            {
+                ++visible_files;
+                txt += (i & 1);
+            }
+        }
+    }
+
+    SECTION("Default filtering")
+    {
+        globber g("x:\\big\\*", std::make_unique<synthetic_enumerator>(entries));
+        REQUIRE(count_matches(g) == visible_files + visible_dirs);
+    }
+
+    SECTION("Directories only")
+    {
+        globber g("x:\\big\\*", std::make_unique<synthetic_enumerator>(entries));
+        g.files(false);
+        REQUIRE(count_matches(g) == visible_dirs);
+    }
+
+    SECTION("Everything")
+    {
+        globber g("x:\\big\\*", std::make_unique<synthetic_enumerator>(entries));
+        g.hidden(true);
+        g.system(true);
+        g.suffix_dirs(false);
+        REQUIRE(count_matches(g) == c_count);
+    }
+
+    SECTION("Dots")
+    {
+        globber g("x:\\big\\.*", std::make_unique<synthetic_enumerator>(entries));
+        g.hidden(true);
+        g.system(true);
+        REQUIRE(count_matches(g) == c_count + 2);
+    }
+
+    SECTION("Long names")
+    {
+        // The enumerator returns every name, like short name matches do, so
+        // the globber must check the long names against the pattern.
+        globber g("x:\\big\\*.txt", std::make_unique<synthetic_enumerator>(entries));
+        g.long_names(true);
+        REQUIRE(count_matches(g) == txt);
+    }
+
+    SECTION("Short names")
+    {
+        // By default names are returned the same as FindFirstFileW returns
+        // them, including names that only match through short names.
+        globber g("x:\\big\\*.txt", std::make_unique<synthetic_enumerator>(entries));
+        REQUIRE(count_matches(g) == visible_files + visible_dirs);
+    }
+
+    SECTION("Close")
+    {
+        globber g("x:\\big\\*", std::make_unique<synthetic_enumerator>(entries));
+        str<> file;
+        REQUIRE(g.next(file, false));
+        g.close();
+        REQUIRE(!g.next(file, false));
+    }
+}
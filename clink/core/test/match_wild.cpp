@@ -96,3 +96,63 @@ TEST_CASE("path::match_wild()")
         REQUIRE(!path::match_wild("*st*", "origin/master", false, path::star_matches_everything::at_end));
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("path::wild_pattern")
+{
+    static const char* const c_patterns[] = {
+        "*", "abc", "a*", "a*c", "*c", "a?c", "*foo*bar", "build*.log",
+        "abc/bu*", "a*/d?f/*i", "ori*", "or*st*", "*st*", ".bu*", "Foo-Bar*",
+    };
+    static const char* const c_files[] = {
+        "", "abc", "ABC", "ac", "abcd", "foobar", "build.foobar", "build.foo123bard",
+        "build.foo.bar.log", "wmbuild.foo.bar.log", "abc/build", "abc/.build",
+        "abc/def/ghi", "abc\\def\\ghi", "origin/master", ".build", "..build",
+        "foo_bar.txt", "foo-bar.txt",
+    };
+    static const path::star_matches_everything c_stars[] = {
+        path::star_matches_everything::no,
+        path::star_matches_everything::yes,
+        path::star_matches_everything::at_end,
+    };
+
+    // The compiled pattern must agree with path::match_wild() exactly.
+    for (int32 mode = 0; mode < str_compare_scope::num_scope_values; ++mode)
+    {
+        str_compare_scope _(mode, false);
+        for (const char* pattern : c_patterns)
+        {
+            for (bool dot_prefix : { false, true })
+            {
+                const path::wild_pattern compiled(pattern, -1, dot_prefix);
+                for (const char* file : c_files)
+                {
+                    for (auto star : c_stars)
+                    {
+                        const bool expected = path::match_wild(pattern, file, dot_prefix, star);
+                        REQUIRE(compiled.match(file, -1, star) == expected, [&] () {
+                            printf("pattern '%s', file '%s', mode %d, dot_prefix %d, star %d\n",
+                                   pattern, file, mode, dot_prefix, int32(star));
+                        });
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Literals")
+    {
+        const path::wild_pattern pattern("foo*.txt");
+        REQUIRE(pattern.has_wildcards());
+        REQUIRE(pattern.match("foo.txt"));
+        REQUIRE(pattern.match("foobar.txt"));
+        REQUIRE(!pattern.match("foobar.txt2"));
+        REQUIRE(!pattern.match("xfoo.txt"));
+        REQUIRE(!pattern.match("fo"));
+
+        const path::wild_pattern literal("foo");
+        REQUIRE(!literal.has_wildcards());
+        REQUIRE(literal.match("foo"));
+        REQUIRE(!literal.match("food"));
+    }
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/work_pool.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct test_work : public work_item
+{
+                    test_work(DWORD ms, std::atomic<int32>& current, std::atomic<int32>& peak, HANDLE gate=nullptr)
+                    : m_ms(ms), m_current(current), m_peak(peak), m_gate(gate) {}
+
+    void            run() override
+                    {
+                        const int32 current = ++m_current;
+                        for (int32 peak = m_peak; current > peak && !m_peak.compare_exchange_weak(peak, current);)
+                        {}
+                        if (m_gate)
+                            WaitForSingleObject(m_gate, INFINITE);
+                        else
+                            Sleep(m_ms);
+                        --m_current;
+                        m_ran = true;
+                    }
+    void            skip() override { m_skipped = true; }
+
+    const DWORD     m_ms;
+    std::atomic<int32>& m_current;
+    std::atomic<int32>& m_peak;
+    const HANDLE    m_gate;             // When set, run() waits for it instead of sleeping.
+    bool            m_ran = false;
+    bool            m_skipped = false;
+};
+
+//------------------------------------------------------------------------------
+struct test_gate
+{
+                    test_gate() : handle(CreateEvent(nullptr, true, false, nullptr)) {}
+                    ~test_gate() { open(); CloseHandle(handle); }
+    void            open() { SetEvent(handle); }
+    const HANDLE    handle;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("work_pool : category limit")
+{
+    std::atomic<int32> current { 0 };
+    std::atomic<int32> peak { 0 };
+
+    work_pool pool;
+    pool.set_limit(work_category::task, 3);
+
+    std::vector<std::shared_ptr<test_work>> items;
+    for (int32 i = 0; i < 12; ++i)
+    {
+        items.emplace_back(std::make_shared<test_work>(5, current, peak));
+        REQUIRE(pool.submit(work_category::task, items.back()));
+    }
+
+    // An item can only be submitted once.
+    REQUIRE(!pool.submit(work_category::task, items.front()));
+
+    for (const auto& item : items)
+        pool.wait(item.get());
+
+    REQUIRE(peak > 0);
+    REQUIRE(peak <= 3);
+    REQUIRE(pool.get_thread_count() <= 3);
+
+    work_stats stats;
+    pool.get_stats(work_category::task, stats);
+    REQUIRE(stats.submitted == 12);
+    REQUIRE(stats.completed == 12);
+    REQUIRE(stats.running == 0);
+    REQUIRE(stats.queued == 0);
+    REQUIRE(stats.peak_queued > 0);
+    REQUIRE(stats.run_time > 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("work_pool : cancel")
+{
+    std::atomic<int32> current { 0 };
+    std::atomic<int32> peak { 0 };
+
+    work_pool pool;
+    test_gate gate;                     // Opens before the pool is destroyed.
+    pool.set_limit(work_category::task, 1);
+
+    // The first item holds the only task slot until the gate opens, so the
+    // second item is still queued when it's canceled.
+    auto first = std::make_shared<test_work>(0, current, peak, gate.handle);
+    auto second = std::make_shared<test_work>(0, current, peak);
+    REQUIRE(pool.submit(work_category::task, first));
+    REQUIRE(pool.submit(work_category::task, second));
+    second->cancel();
+    gate.open();
+
+    pool.wait(second.get());
+    REQUIRE(first->m_ran);
+    REQUIRE(!second->m_ran);
+    REQUIRE(second->m_skipped);
+
+    work_stats stats;
+    pool.get_stats(work_category::task, stats);
+    REQUIRE(stats.completed == 2);
+    REQUIRE(stats.canceled == 1);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("work_pool : categories are independent")
+{
+    std::atomic<int32> current { 0 };
+    std::atomic<int32> peak { 0 };
+
+    work_pool pool;
+    test_gate gate;                     // Opens before the pool is destroyed.
+    pool.set_limit(work_category::yield, 1);
+
+    // A yield item that can't finish must not delay the recognizer.
+    auto slow = std::make_shared<test_work>(0, current, peak, gate.handle);
+    auto fast = std::make_shared<test_work>(0, current, peak);
+    REQUIRE(pool.submit(work_category::yield, slow));
+    REQUIRE(pool.submit(work_category::recognizer, fast));
+
+    pool.wait(fast.get());
+    REQUIRE(fast->m_ran);
+
+    work_stats stats;
+    pool.get_stats(work_category::yield, stats);
+    REQUIRE(stats.completed == 0);
+
+    gate.open();
+    pool.wait(slow.get());
+    REQUIRE(slow->m_ran);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("work_pool : yield has no limit")
+{
+    std::atomic<int32> current { 0 };
+    std::atomic<int32> peak { 0 };
+
+    work_pool pool;
+    test_gate gate;                     // Opens before the pool is destroyed.
+
+    work_stats stats;
+    pool.get_stats(work_category::yield, stats);
+    REQUIRE(stats.limit == 0);
+
+    // Every yield item runs at once; none queue behind the others.
+    std::vector<std::shared_ptr<test_work>> items;
+    for (int32 i = 0; i < 20; ++i)
+    {
+        items.emplace_back(std::make_shared<test_work>(0, current, peak, gate.handle));
+        REQUIRE(pool.submit(work_category::yield, items.back()));
+    }
+
+    while (current < 20)
+        Sleep(1);
+    REQUIRE(pool.get_thread_count() == 20);
+
+    gate.open();
+    for (const auto& item : items)
+        pool.wait(item.get());
+    REQUIRE(peak == 20);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("work_pool : shutdown")
+{
+    std::atomic<int32> current { 0 };
+    std::atomic<int32> peak { 0 };
+
+    work_pool pool;
+    test_gate gate;                     // Opens before the pool is destroyed.
+    pool.set_limit(work_category::task, 1);
+
+    auto running = std::make_shared<test_work>(0, current, peak, gate.handle);
+    auto queued = std::make_shared<test_work>(0, current, peak);
+    REQUIRE(pool.submit(work_category::task, running));
+    REQUIRE(pool.submit(work_category::task, queued));
+    while (current < 1)
+        Sleep(1);
+
+    // Shutdown refuses new work, lets the running item finish, skips the
+    // queued item, and joins the threads.  The gate opens only once shutdown
+    // has begun, so the queued item can't start first.
+    std::thread closer([&pool] () { pool.shutdown(); });
+    while (pool.submit(work_category::task, std::make_shared<test_work>(0, current, peak)))
+        Sleep(1);
+    gate.open();
+    closer.join();
+
+    REQUIRE(running->m_ran);
+    REQUIRE(!queued->m_ran);
+    REQUIRE(queued->m_skipped);
+    REQUIRE(pool.get_thread_count() == 0);
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+#include <core/linear_allocator.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class work_item;
+
+//------------------------------------------------------------------------------
+// Caches directory listings, so that completing in a large directory doesn't
+// have to wait for the directory to be enumerated.  Listings are read ahead of
+// time on the work pool:  the current directory and recent current directories
+// when a line begins, and the directory part of the word being edited.
+//
+// A listing is used only while the directory's last write time is unchanged,
+// which covers files being added, removed, or renamed.  Attributes and sizes
+// can change without updating the directory's write time, so a listing that's
+// more than a few seconds old is also read again in the background.
+//
+// Only directories on local drives are cached, and not on FAT or exFAT volumes,
+// whose 2 second timestamps can miss a file added right after a listing.
+class dir_cache
+{
+public:
+    struct file
+    {
+        const char*     name;
+        const char*     lower;
+        int32           st_mode;
+        uint32          attr;
+        uint64          size;
+    };
+
+    struct listing
+    {
+                        listing() : store(16384) {}
+        str_moveable    dir;
+        linear_allocator store;
+        std::vector<file> files;
+        uint64          mtime = 0;
+        double          scanned = 0;
+    };
+
+    static dir_cache&   get();
+
+    // Reads the directory in the background, unless it's already cached and
+    // up to date.  Relative directories are relative to the current directory.
+    void                prefetch(const char* dir);
+
+    // Prefetches the current directory, and the recent current directories.
+    void                prefetch_cwd();
+
+    // Returns the listing if it's cached and up to date, otherwise nullptr.
+    // This never waits for the directory to be read.
+    std::shared_ptr<const listing> find(const char* dir);
+
+    // Matches a lowercase name against a lowercase FindFirstFile style
+    // pattern containing * and ? wildcards.
+    static bool         match_name(const char* pattern, const char* name);
+
+    void                clear();
+    void                get_stats(uint32& lookups, uint32& hits, uint32& scans) const;
+
+private:
+    friend class dir_cache_work;
+
+    struct entry
+    {
+        str_moveable    key;
+        std::shared_ptr<const listing> data;
+        double          used = 0;
+    };
+
+    void                submit(const char* dir, const char* key);
+    std::shared_ptr<listing> scan(const char* dir, const char* key, const work_item* item);
+    void                finish(const char* key, std::shared_ptr<const listing>&& data);
+
+    mutable std::mutex  m_mutex;
+    str_unordered_map<entry> m_map;     // Keys are owned by the entries.
+    std::vector<str_moveable> m_pending;
+    std::vector<str_moveable> m_recent; // Recent current directories.
+    uint32              m_lookups = 0;
+    uint32              m_hits = 0;
+    uint32              m_scans = 0;
+};
@@ -0,0 +1,92 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+#include <core/linear_allocator.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Indexes the executable files in the %PATH% directories, so that finding an
+// executable is a hash lookup instead of probing every directory for every
+// %PATHEXT% extension.  The index is rebuilt when %PATH% or %PATHEXT% change,
+// and a directory is rescanned when its last write time changes.
+//
+// The index is shared by the recognizer's background work and the main
+// thread, so it's synchronized.
+class exe_index
+{
+public:
+    struct executable
+    {
+        str_moveable    name;
+        uint32          attr;
+    };
+
+    static exe_index&   get();
+
+    // Returns 1 and the full path when found, 0 when not found, or -1 when
+    // the index can't answer and the caller must search the file system (for
+    // example a name with an extension that isn't in %PATHEXT%).
+    int32               find(const char* name, str_base& out);
+
+    // Copies each distinct file name with a %PATHEXT% extension, in %PATH%
+    // order.  The names are copied so that callers can use them (e.g. push
+    // them to Lua) without holding the index's lock.
+    void                get_executables(std::vector<executable>& out);
+
+    void                invalidate();
+    void                clear();
+    void                get_stats(uint32& lookups, uint32& hits, uint32& scans) const;
+
+private:
+    struct file_entry
+    {
+        const char*     name;           // Original case.
+        const char*     lower;
+        const char*     lower_base;     // Without the %PATHEXT% extension, or nullptr.
+        uint32          attr;
+        uint32          ext_rank;       // Position of the extension in %PATHEXT%.
+    };
+
+    struct dir_listing
+    {
+                        dir_listing() : store(4096) {}
+        str_moveable    dir;
+        linear_allocator store;
+        std::vector<file_entry> files;
+        uint64          mtime = 0;
+        bool            exists = false;
+        bool            scanned = false;
+    };
+
+    struct hit
+    {
+        uint32          dir;
+        uint32          rank;
+        const file_entry* file;
+    };
+
+    void                refresh();
+    void                refresh_dirs();
+    void                scan(dir_listing& listing);
+    void                rebuild_map();
+    int32               get_ext_rank(const char* ext) const;
+
+    mutable std::mutex  m_mutex;
+    str_moveable        m_path;
+    str_moveable        m_pathext;
+    std::vector<str_moveable> m_exts;   // Lowercase %PATHEXT% extensions.
+    std::vector<std::unique_ptr<dir_listing>> m_dirs;
+    str_unordered_map<hit> m_map;       // Keys are owned by the dir listings.
+    double              m_checked = 0;
+    bool                m_has_relative = false;
+    uint32              m_lookups = 0;
+    uint32              m_hits = 0;
+    uint32              m_scans = 0;
+};
@@ -191,6 +191,8 @@ public:
     virtual shadow_bool     get_match_suppress_append(uint32 index) const = 0;
     virtual bool            get_match_append_display(uint32 index) const = 0;
     virtual bool            get_match_custom_display(uint32 index) const = 0;
+    virtual uint32          get_match_display_cells(uint32 index) const = 0;
+    virtual uint32          get_match_description_cells(uint32 index) const = 0;
     virtual bool            is_suppress_append() const = 0;
     virtual shadow_bool     is_filename_completion_desired() const = 0;
     virtual shadow_bool     is_filename_display_desired() const = 0;
@@ -248,6 +250,7 @@ public:
                             match_builder(matches& matches);
     bool                    add_match(const char* match, match_type type, bool already_normalised=false);
     bool                    add_match(const match_desc& desc, bool already_normalised=false);
+    void                    reserve(uint32 count);
     bool                    is_empty();
     void                    set_append_character(char append);
     void                    set_suppress_append(bool suppress=true);
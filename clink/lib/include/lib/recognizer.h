@@ -7,9 +7,12 @@ class str_base;
 
 enum class recognition : char { unrecognized = -1, unknown, executable, navigate, max };
 
-recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file);
+// The offset of the word in the line determines the order in which queued
+// words are recognized; when it's -1 the word is recognized first.
+recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file, int32 offset=-1);
 
 HANDLE get_recognizer_event();
+void set_recognizer_cache_dir(const char* dir);
 bool check_recognizer_refresh();
 
 extern "C" void end_recognizer();
@@ -0,0 +1,394 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_cache.h"
+
+#include <core/debugheap.h>
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str_transform.h>
+#include <core/work_pool.h>
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_listings = 8;
+static const uint32 c_max_recent = 4;
+static const double c_refresh_age = 5.0;        // Seconds.
+static const double c_volume_age = 30.0;        // Seconds.
+
+
+
+//------------------------------------------------------------------------------
+static bool has_fine_timestamps(const char* full)
+{
+    // FAT and exFAT store last write times with 2 second resolution, so a file
+    // added right after a listing is read may not change the directory's last
+    // write time.  The answer is remembered per drive letter, since find() is
+    // called on the input thread.
+    struct volume
+    {
+        double          checked = -c_volume_age;
+        bool            fine = false;
+    };
+    static std::mutex s_mutex;
+    static volume s_volumes[26];
+
+    const char letter = full[0] | 0x20;
+    if (letter < 'a' || letter > 'z')
+        return false;
+
+    volume& v = s_volumes[letter - 'a'];
+    const double now = os::clock();
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (now - v.checked < c_volume_age)
+            return v.fine;
+    }
+
+    str<16> name;
+    const bool fine = (os::get_file_system_name(full, name) &&
+                       !name.iequals("FAT") &&
+                       !name.iequals("FAT32") &&
+                       !name.iequals("exFAT"));
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    v.checked = now;
+    v.fine = fine;
+    return fine;
+}
+
+//------------------------------------------------------------------------------
+static bool get_dir_key(const char* dir, str_base& full, str_base& key)
+{
+    if (!dir || !*dir)
+    {
+        if (!os::get_current_dir(full))
+            return false;
+    }
+    else if (!os::get_full_path_name(dir, full))
+    {
+        return false;
+    }
+
+    path::maybe_strip_last_separator(full);
+
+    // Skip UNC paths and drives that are unknown, invalid, or remote.  Reading
+    // them in the background could still tie up the worker for a long time.
+    if (!os::is_local_drive(full.c_str()))
+        return false;
+
+    // The directory's last write time must be precise enough to notice
+    // changes.
+    if (!has_fine_timestamps(full.c_str()))
+        return false;
+
+    // Directories are compared case insensitively.
+    str_transform(full.c_str(), full.length(), key, transform_mode::lower);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static const char* next_char(const char* s)
+{
+    ++s;
+    while ((*s & 0xc0) == 0x80)
+        ++s;
+    return s;
+}
+
+
+
+//------------------------------------------------------------------------------
+class dir_cache_work : public work_item
+{
+public:
+                            dir_cache_work(const char* dir, const char* key) : m_dir(dir), m_key(key) {}
+protected:
+    void                    run() override;
+    void                    skip() override;
+private:
+    const str_moveable      m_dir;
+    const str_moveable      m_key;
+};
+
+//------------------------------------------------------------------------------
+void dir_cache_work::run()
+{
+    dir_cache& cache = dir_cache::get();
+    cache.finish(m_key.c_str(), cache.scan(m_dir.c_str(), m_key.c_str(), this));
+}
+
+//------------------------------------------------------------------------------
+void dir_cache_work::skip()
+{
+    dir_cache::get().finish(m_key.c_str(), nullptr);
+}
+
+
+
+//------------------------------------------------------------------------------
+dir_cache& dir_cache::get()
+{
+    // Intentionally never destroyed:  prefetch work may still be running on
+    // the work pool while the process shuts down.
+    static dir_cache* s_cache = nullptr;
+    if (!s_cache)
+    {
+        dbg_ignore_scope(snapshot, "Directory cache");
+        s_cache = new dir_cache;
+    }
+    return *s_cache;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::prefetch(const char* dir)
+{
+    str<> full;
+    str<> key;
+    if (get_dir_key(dir, full, key))
+        submit(full.c_str(), key.c_str());
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::prefetch_cwd()
+{
+    str<> cwd;
+    if (!os::get_current_dir(cwd))
+        return;
+
+    // Remember recent current directories, since it's common to go back to
+    // them.  The current directory is first.
+    std::vector<str_moveable> dirs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto iter = m_recent.begin(); iter != m_recent.end(); ++iter)
+        {
+            if (iter->iequals(cwd.c_str()))
+            {
+                m_recent.erase(iter);
+                break;
+            }
+        }
+        m_recent.insert(m_recent.begin(), str_moveable(cwd.c_str()));
+        if (m_recent.size() > c_max_recent)
+            m_recent.resize(c_max_recent);
+
+        for (const auto& r : m_recent)
+            dirs.emplace_back(r.c_str());
+    }
+
+    for (const auto& d : dirs)
+        prefetch(d.c_str());
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const dir_cache::listing> dir_cache::find(const char* dir)
+{
+    str<> full;
+    str<> key;
+    if (!get_dir_key(dir, full, key))
+        return nullptr;
+
+    std::shared_ptr<const listing> data;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_lookups;
+        auto iter = m_map.find(key.c_str());
+        if (iter == m_map.end())
+            return nullptr;
+        iter->second.used = os::clock();
+        data = iter->second.data;
+    }
+
+    // Only use the listing if the directory hasn't changed since it was read.
+    uint64 mtime;
+    if (!os::get_dir_mtime(full.c_str(), mtime) || mtime != data->mtime)
+    {
+        submit(full.c_str(), key.c_str());
+        return nullptr;
+    }
+
+    if (os::clock() - data->scanned >= c_refresh_age)
+        submit(full.c_str(), key.c_str());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_hits;
+    return data;
+}
+
+//------------------------------------------------------------------------------
+bool dir_cache::match_name(const char* pattern, const char* name)
+{
+    // "*.*" also matches names without a dot, the same as FindFirstFile.
+    if (strcmp(pattern, "*.*") == 0)
+        return true;
+
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*name)
+    {
+        if (*pattern == '*')
+        {
+            star = ++pattern;
+            resume = name;
+        }
+        else if (*pattern == '?')
+        {
+            ++pattern;
+            name = next_char(name);
+        }
+        else if (*pattern == *name)
+        {
+            ++pattern;
+            ++name;
+        }
+        else if (star)
+        {
+            pattern = star;
+            resume = next_char(resume);
+            name = resume;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (*pattern == '*')
+        ++pattern;
+    return !*pattern;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_map.clear();
+    m_recent.clear();
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::get_stats(uint32& lookups, uint32& hits, uint32& scans) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    lookups = m_lookups;
+    hits = m_hits;
+    scans = m_scans;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::submit(const char* dir, const char* key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& p : m_pending)
+        if (p.equals(key))
+            return;
+
+    dbg_ignore_scope(snapshot, "Directory cache work");
+    auto work = std::make_shared<dir_cache_work>(dir, key);
+    if (work_pool::get().submit(work_category::prefetch, work))
+        m_pending.emplace_back(key);
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<dir_cache::listing> dir_cache::scan(const char* dir, const char* key, const work_item* item)
+{
+    uint64 mtime;
+    if (!os::get_dir_mtime(dir, mtime))
+        return nullptr;
+
+    // Nothing to do if the cached listing is still up to date.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_map.find(key);
+        if (iter != m_map.end())
+        {
+            const listing& data = *iter->second.data;
+            if (data.mtime == mtime && os::clock() - data.scanned < c_refresh_age)
+                return nullptr;
+        }
+        ++m_scans;
+    }
+
+    auto data = std::make_shared<listing>();
+    data->dir = dir;
+    data->mtime = mtime;
+    data->scanned = os::clock();
+
+    str<> pattern(dir);
+    path::append(pattern, "*");
+
+    globber files(pattern.c_str());
+    files.files(true);
+    files.directories(true);
+    files.suffix_dirs(false);
+    files.hidden(true);
+    files.system(true);
+    files.dots(false);
+
+    str<> file;
+    str<> lower;
+    globber::extrainfo info;
+    for (uint32 i = 1; files.next(file, false, &info); ++i)
+    {
+        if (!(i & 0x3f) && item && item->is_canceled())
+            return nullptr;
+
+        str_transform(file.c_str(), file.length(), lower, transform_mode::lower);
+
+        dir_cache::file entry;
+        entry.name = data->store.store(file.c_str());
+        entry.lower = data->store.store(lower.c_str());
+        entry.st_mode = info.st_mode;
+        entry.attr = info.attr;
+        entry.size = info.size;
+        if (entry.name && entry.lower)
+            data->files.emplace_back(entry);
+    }
+
+    return data;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::finish(const char* key, std::shared_ptr<const listing>&& data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto iter = m_pending.begin(); iter != m_pending.end(); ++iter)
+    {
+        if (iter->equals(key))
+        {
+            m_pending.erase(iter);
+            break;
+        }
+    }
+
+    if (!data)
+        return;
+
+    auto iter = m_map.find(key);
+    if (iter != m_map.end())
+    {
+        iter->second.data = std::move(data);
+        iter->second.used = os::clock();
+        return;
+    }
+
+    // Make room by evicting the least recently used listing.
+    if (m_map.size() >= c_max_listings)
+    {
+        auto oldest = m_map.begin();
+        for (auto i = m_map.begin(); i != m_map.end(); ++i)
+            if (i->second.used < oldest->second.used)
+                oldest = i;
+        m_map.erase(oldest);
+    }
+
+    entry e;
+    e.key = key;
+    e.data = std::move(data);
+    e.used = os::clock();
+    const char* k = e.key.c_str();
+    m_map.emplace(k, std::move(e));
+}
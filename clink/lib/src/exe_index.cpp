@@ -0,0 +1,338 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "exe_index.h"
+
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str_tokeniser.h>
+#include <core/str_transform.h>
+
+//------------------------------------------------------------------------------
+static const double c_recheck_interval = 2.0;   // Seconds.
+
+
+
+//------------------------------------------------------------------------------
+exe_index& exe_index::get()
+{
+    static exe_index s_index;
+    return s_index;
+}
+
+//------------------------------------------------------------------------------
+int32 exe_index::find(const char* name, str_base& out)
+{
+    if (!name || !*name || strpbrk(name, "/\\:"))
+        return -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refresh();
+
+    if (m_has_relative)
+        return -1;
+
+    str<> lower;
+    str_transform(name, uint32(strlen(name)), lower, transform_mode::lower);
+
+    // Files with other extensions may still be launchable through file
+    // associations, which the index doesn't cover.
+    const char* ext = path::get_extension(lower.c_str());
+    if (ext && strcmp(ext, ".lnk") != 0 && get_ext_rank(ext) < 0)
+        return -1;
+
+    ++m_lookups;
+    const auto iter = m_map.find(lower.c_str());
+    if (iter == m_map.end())
+        return 0;
+
+    ++m_hits;
+    out = m_dirs[iter->second.dir]->dir.c_str();
+    path::append(out, iter->second.file->name);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void exe_index::get_executables(std::vector<executable>& out)
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refresh();
+
+    for (const auto& listing : m_dirs)
+    {
+        for (const auto& file : listing->files)
+        {
+            // Only the first file by each name is reachable through %PATH%,
+            // and .lnk files only count when they're in %PATHEXT%.
+            if (!file.lower_base)
+                continue;
+            const auto iter = m_map.find(file.lower);
+            if (iter != m_map.end() && iter->second.file == &file)
+            {
+                out.emplace_back();
+                out.back().name = file.name;
+                out.back().attr = file.attr;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void exe_index::invalidate()
+{
+    // Check the directories again on the next query, even if they were
+    // checked only recently.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_checked = 0;
+}
+
+//------------------------------------------------------------------------------
+void exe_index::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_map.clear();
+    m_dirs.clear();
+    m_exts.clear();
+    m_path.clear();
+    m_pathext.clear();
+    m_checked = 0;
+    m_has_relative = false;
+}
+
+//------------------------------------------------------------------------------
+void exe_index::get_stats(uint32& lookups, uint32& hits, uint32& scans) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    lookups = m_lookups;
+    hits = m_hits;
+    scans = m_scans;
+}
+
+//------------------------------------------------------------------------------
+void exe_index::refresh()
+{
+    bool dirty = false;
+
+    str<> pathext;
+    os::get_env("pathext", pathext);
+    if (!pathext.equals(m_pathext.c_str()))
+    {
+        m_pathext = pathext.c_str();
+        m_exts.clear();
+
+        str<16> ext;
+        str_tokeniser tokens(pathext.c_str(), ";");
+        while (tokens.next(ext))
+        {
+            ext.trim();
+            if (ext.empty())
+                continue;
+            str_moveable lower;
+            str_transform(ext.c_str(), ext.length(), lower, transform_mode::lower);
+            m_exts.emplace_back(std::move(lower));
+        }
+
+        // The extension ranks changed, so every directory needs a rescan.
+        for (auto& listing : m_dirs)
+            listing->scanned = false;
+        dirty = true;
+    }
+
+    str<> env_path;
+    os::get_env("PATH", env_path);
+    if (!env_path.equals(m_path.c_str()))
+    {
+        m_path = env_path.c_str();
+        refresh_dirs();
+        dirty = true;
+    }
+
+    const double now = os::clock();
+    if (!m_checked || now - m_checked >= c_recheck_interval)
+    {
+        m_checked = now;
+        for (auto& listing : m_dirs)
+        {
+            uint64 mtime = 0;
+            const bool exists = os::get_dir_mtime(listing->dir.c_str(), mtime);
+            if (exists != listing->exists || mtime != listing->mtime)
+            {
+                listing->exists = exists;
+                listing->mtime = mtime;
+                listing->scanned = false;
+            }
+        }
+    }
+
+    for (auto& listing : m_dirs)
+    {
+        if (!listing->scanned)
+        {
+            scan(*listing);
+            dirty = true;
+        }
+    }
+
+    if (dirty)
+        rebuild_map();
+}
+
+//------------------------------------------------------------------------------
+void exe_index::refresh_dirs()
+{
+    // Reuse the listings for directories that are still in %PATH%.
+    std::vector<std::unique_ptr<dir_listing>> old;
+    old.swap(m_dirs);
+
+    m_has_relative = false;
+
+    str<280> token;
+    str<> full;
+    str_tokeniser tokens(m_path.c_str(), ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+        if (token.empty())
+            continue;
+
+        // Relative directories depend on the current directory, so the index
+        // can't answer for them.
+        if (!path::is_rooted(token.c_str()))
+        {
+            m_has_relative = true;
+            continue;
+        }
+
+        if (!os::get_full_path_name(token.c_str(), full, token.length()))
+            continue;
+        path::maybe_strip_last_separator(full);
+        if (!os::is_local_drive(full.c_str()))
+            continue;
+
+        // Only the first occurrence of a directory can matter.
+        bool dup = false;
+        for (const auto& d : m_dirs)
+            dup = dup || d->dir.iequals(full.c_str());
+        if (dup)
+            continue;
+
+        std::unique_ptr<dir_listing> listing;
+        for (auto& o : old)
+        {
+            if (o && o->dir.iequals(full.c_str()))
+            {
+                listing = std::move(o);
+                break;
+            }
+        }
+
+        if (!listing)
+        {
+            listing = std::make_unique<dir_listing>();
+            listing->dir = full.c_str();
+            listing->exists = os::get_dir_mtime(full.c_str(), listing->mtime);
+        }
+
+        m_dirs.emplace_back(std::move(listing));
+    }
+}
+
+//------------------------------------------------------------------------------
+void exe_index::scan(dir_listing& listing)
+{
+    listing.files.clear();
+    listing.store.clear();
+    listing.scanned = true;
+    if (!listing.exists)
+        return;
+
+    ++m_scans;
+
+    str<> pattern(listing.dir.c_str());
+    path::append(pattern, "*");
+
+    globber files(pattern.c_str());
+    files.files(true);
+    files.directories(false);
+    files.hidden(true);
+    files.system(true);
+
+    str<> file;
+    str<> lower;
+    globber::extrainfo info;
+    while (files.next(file, false, &info))
+    {
+        str_transform(file.c_str(), file.length(), lower, transform_mode::lower);
+
+        const char* ext = path::get_extension(lower.c_str());
+        if (!ext)
+            continue;
+
+        // Names are ranked the same way the recognizer searched:  a .lnk file
+        // first, then each %PATHEXT% extension in order.
+        const int32 rank = get_ext_rank(ext);
+        if (rank < 0 && strcmp(ext, ".lnk") != 0)
+            continue;
+
+        file_entry entry;
+        entry.name = listing.store.store(file.c_str());
+        entry.lower = listing.store.store(lower.c_str());
+        entry.lower_base = nullptr;
+        entry.attr = info.attr;
+        entry.ext_rank = (rank < 0) ? 0 : uint32(rank + 1) * 2;
+        if (!entry.name || !entry.lower)
+            continue;
+
+        if (rank >= 0 && ext > lower.c_str())
+        {
+            lower.truncate(uint32(ext - lower.c_str()));
+            entry.lower_base = listing.store.store(lower.c_str());
+        }
+
+        listing.files.emplace_back(entry);
+    }
+}
+
+//------------------------------------------------------------------------------
+void exe_index::rebuild_map()
+{
+    m_map.clear();
+
+    auto add = [this](const char* key, uint32 dir, uint32 rank, const file_entry* file)
+    {
+        auto iter = m_map.find(key);
+        if (iter == m_map.end())
+        {
+            m_map.emplace(key, hit { dir, rank, file });
+        }
+        else if (iter->second.dir == dir && rank < iter->second.rank)
+        {
+            // Within a directory the lowest ranked match wins; across
+            // directories the first directory wins.
+            iter->second = hit { dir, rank, file };
+        }
+    };
+
+    for (uint32 dir = 0; dir < m_dirs.size(); ++dir)
+    {
+        for (const auto& file : m_dirs[dir]->files)
+        {
+            add(file.lower, dir, file.ext_rank, &file);
+            if (file.lower_base)
+                add(file.lower_base, dir, file.ext_rank + 1, &file);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+int32 exe_index::get_ext_rank(const char* ext) const
+{
+    for (size_t i = 0; i < m_exts.size(); ++i)
+        if (strcmp(m_exts[i].c_str(), ext) == 0)
+            return int32(i);
+    return -1;
+}
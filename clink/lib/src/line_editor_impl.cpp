@@ -18,6 +18,7 @@
 #include "line_editor_integration.h"
 #include "suggestions.h"
 #include "recognizer.h"
+#include "dir_cache.h"
 #include "hinter.h"
 
 #ifdef DEBUG
@@ -26,6 +27,7 @@
 #endif
 
 #include <core/base.h>
+#include <core/fs_query_cache.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_iter.h>
@@ -69,6 +71,21 @@ inline char get_closing_quote(const char* quote_pair)
     return quote_pair[1] ? quote_pair[1] : quote_pair[0];
 }
 
+//------------------------------------------------------------------------------
+static void prefetch_word_dir(const char* word, uint32 len)
+{
+    // Start reading the directory part of the word in the background, so that
+    // completion can use the directory cache by the time it's needed.
+    str<> tmp;
+    concat_strip_quotes(tmp, word, len);
+    if (tmp.empty() || tmp[0] == '~' || strchr(tmp.c_str(), '%'))
+        return;
+
+    str<> dir;
+    if (path::get_directory(tmp.c_str(), dir) && !dir.empty())
+        dir_cache::get().prefetch(dir.c_str());
+}
+
 //------------------------------------------------------------------------------
 static bool rl_vi_insert_mode_esc_special_case(int32 key)
 {
@@ -310,6 +327,10 @@ void line_editor_impl::begin_line()
 
     set_active_line_editor(this, m_desc.callbacks);
 
+    // The previous command may have created or deleted files.
+    fs_query_cache::get().invalidate_paths();
+    dir_cache::get().prefetch_cwd();
+
     match_pipeline pipeline(m_matches);
     pipeline.reset();
 
@@ -1519,6 +1540,9 @@ void line_editor_impl::update_internal(bool force)
                 m_matches.set_word_break_position(line.get_end_word_offset());
             }
             update_prev_generate = len;
+
+            if (next_key.cursor_pos > next_key.word_offset)
+                prefetch_word_dir(m_buffer.get_buffer() + next_key.word_offset, next_key.cursor_pos - next_key.word_offset);
         }
     }
 
@@ -1608,7 +1632,7 @@ void line_editor_impl::try_suggest()
                     if (!drive.empty())
                     {
                         path::append(drive, ""); // Because get_drive_type() requires a trailing path separator.
-                        no_matches = (os::get_drive_type(drive.c_str()) < os::drive_type_removable);
+                        no_matches = (fs_query_cache::get().get_drive_type(drive.c_str()) < os::drive_type_removable);
                     }
                 }
                 if (no_matches)
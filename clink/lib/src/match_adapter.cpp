@@ -305,18 +305,19 @@ const char* match_adapter::get_match_display_raw(uint32 index) const
 //------------------------------------------------------------------------------
 uint32 match_adapter::get_match_visible_display(uint32 index) const
 {
+    const matches* matches = nullptr;
     const char* display;
     if (m_filtered_matches)
-        display = m_filtered_matches->get_match_display(index);
+        display = (matches = m_filtered_matches)->get_match_display(index);
     else if (m_alt_matches)
         display = lookup_match(m_alt_matches[index + 1]).get_display();
     else if (m_matches)
-        display = m_matches->get_match_display(index);
+        display = (matches = m_matches)->get_match_display(index);
     else
         return 0;
 
     if (display && *display)
-        return cell_count(display);
+        return matches ? matches->get_match_display_cells(index) : cell_count(display);
     const char* match = get_match(index);
     match_type type = get_match_type(index);
     return printable_len(match, type);
@@ -340,8 +341,16 @@ const char* match_adapter::get_match_description(uint32 index) const
 //------------------------------------------------------------------------------
 uint32 match_adapter::get_match_visible_description(uint32 index) const
 {
-    const char* description = get_match_description(index);
-    return description ? cell_count(description) : 0;
+    if (m_filtered_matches)
+        return m_filtered_matches->get_match_description_cells(index);
+    if (m_alt_matches)
+    {
+        const char* description = get_match_description(index);
+        return description ? cell_count(description) : 0;
+    }
+    if (m_matches)
+        return m_matches->get_match_description_cells(index);
+    return 0;
 }
 
 //------------------------------------------------------------------------------
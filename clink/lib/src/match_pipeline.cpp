@@ -105,7 +105,7 @@ static uint32 pattern_selector(
     int32 count,
     bool dot_prefix)
 {
-    const int32 needle_len = strlen(needle);
+    const path::wild_pattern pattern(needle, -1, dot_prefix);
     const bool include_hidden = (_rl_match_hidden_files || *path::get_name(needle) == '.');
     int32 select_count = 0;
     for (int32 i = 0; i < count; ++i)
@@ -119,7 +119,7 @@ static uint32 pattern_selector(
         const path::star_matches_everything flag = (is_pathish(info.type) ? path::at_end : path::yes);
         const bool select = ((include_hidden || !path::is_unix_hidden(match, true)) &&
                              include_match_type(info.type) &&
-                             path::match_wild(str_iter(needle, needle_len), str_iter(match, match_len), dot_prefix, flag));
+                             pattern.match(match, match_len, flag));
         info.select = select;
         if (select)
             ++select_count;
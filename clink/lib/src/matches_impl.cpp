@@ -16,6 +16,7 @@
 #include <core/str_tokeniser.h>
 #include <core/match_wild.h>
 #include <core/path.h>
+#include <terminal/ecma48_iter.h>
 #include <sys/stat.h>
 
 extern "C" {
@@ -276,6 +277,12 @@ bool match_builder::add_match(const match_desc& desc, bool already_normalized)
     return ((matches_impl&)m_matches).add_match(desc, already_normalized);
 }
 
+//------------------------------------------------------------------------------
+void match_builder::reserve(uint32 count)
+{
+    ((matches_impl&)m_matches).reserve(count);
+}
+
 //------------------------------------------------------------------------------
 bool match_builder::is_empty()
 {
@@ -717,6 +724,42 @@ bool matches_impl::get_match_custom_display(uint32 index) const
     return info.custom_display > 0;
 }
 
+//------------------------------------------------------------------------------
+uint32 matches_impl::get_match_display_cells(uint32 index) const
+{
+    if (index >= get_match_count())
+        return 0;
+
+    const match_info& info = m_infos[index];
+    if (info.display_cells < 0)
+        measure_cells(info);
+    return info.display_cells;
+}
+
+//------------------------------------------------------------------------------
+uint32 matches_impl::get_match_description_cells(uint32 index) const
+{
+    if (index >= get_match_count())
+        return 0;
+
+    const match_info& info = m_infos[index];
+    if (info.description_cells < 0)
+        measure_cells(info);
+    return info.description_cells;
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::measure_cells(const match_info& info) const
+{
+    // Display and description strings may contain ANSI escape codes, so
+    // measuring them is relatively expensive.  Layout, paging, and redrawing
+    // the selection grid query them repeatedly, so cache the cell counts.
+    if (info.display_cells < 0)
+        info.display_cells = info.display ? cell_count(info.display) : 0;
+    if (info.description_cells < 0)
+        info.description_cells = info.description ? cell_count(info.description) : 0;
+}
+
 //------------------------------------------------------------------------------
 const char* matches_impl::get_unfiltered_match(uint32 index) const
 {
@@ -972,6 +1015,8 @@ void matches_impl::copy(const matches_impl& from)
         add.append_display = info.append_display;
         add.custom_display = info.custom_display;
         add.select = false; // (Shouldn't matter.)
+        add.display_cells = info.display_cells;
+        add.description_cells = info.description_cells;
         m_infos.emplace_back(std::move(add));
     }
 
@@ -1200,6 +1245,8 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
     info.append_display = append_display;
     info.custom_display = (desc.missing_match ? true : (store_display ? -1 : false));
     info.select = false;
+    info.display_cells = -1;
+    info.description_cells = -1;
     m_infos.emplace_back(std::move(info));
     ++m_count;
 
@@ -1209,6 +1256,19 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
     return true;
 }
 
+//------------------------------------------------------------------------------
+void matches_impl::reserve(uint32 count)
+{
+    // Avoids repeatedly growing and rehashing while a generator adds a large
+    // batch of matches.
+    if (m_coalesced)
+        return;
+    m_infos.reserve(m_infos.size() + count);
+    if (!m_dedup)
+        m_dedup = new match_lookup_unordered_set;
+    m_dedup->reserve(m_dedup->size() + count);
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::set_generator(match_generator* generator)
 {
@@ -1269,6 +1329,9 @@ void matches_impl::done_building()
 
     delete m_dedup;
     m_dedup = nullptr;
+
+    for (const auto& info : m_infos)
+        measure_cells(info);
 }
 
 //------------------------------------------------------------------------------
@@ -23,6 +23,8 @@ struct match_info
     bool            append_display;
     char            custom_display;     // Negative means not calculated yet.
     bool            select;
+    mutable int32   display_cells;      // Negative means not calculated yet.
+    mutable int32   description_cells;  // Negative means not calculated yet.
 };
 
 //------------------------------------------------------------------------------
@@ -78,6 +80,8 @@ public:
     virtual shadow_bool     get_match_suppress_append(uint32 index) const override;
     virtual bool            get_match_append_display(uint32 index) const override;
     virtual bool            get_match_custom_display(uint32 index) const override;
+    virtual uint32          get_match_display_cells(uint32 index) const override;
+    virtual uint32          get_match_description_cells(uint32 index) const override;
     virtual bool            is_suppress_append() const override;
     virtual shadow_bool     is_filename_completion_desired() const override;
     virtual shadow_bool     is_filename_display_desired() const override;
@@ -130,11 +134,13 @@ private:
     void                    set_input_line(const char* text);
     bool                    is_from_current_input_line();
     bool                    add_match(const match_desc& desc, bool already_normalised=false);
+    void                    reserve(uint32 count);
     uint32                  get_info_count() const;
     const match_info*       get_infos() const;
     match_info*             get_infos();
     void                    reset();
     void                    coalesce(uint32 count_hint, bool restrict=false);
+    void                    measure_cells(const match_info& info) const;
 
 private:
     class store_impl : public linear_allocator
@@ -2,9 +2,11 @@
 // License: http://opensource.org/licenses/MIT
 
 #include "pch.h"
+#include "exe_index.h"
 #include "intercept.h"
 #include "reclassify.h"
 #include "recognizer.h"
+#include "recognizer_cache.h"
 
 #include <core/os.h>
 #include <core/path.h>
@@ -16,10 +18,12 @@
 #include <core/settings.h>
 #include <core/linear_allocator.h>
 #include <core/debugheap.h>
+#include <core/fs_query_cache.h>
+#include <core/work_pool.h>
 
 #include <memory>
-#include <thread>
 #include <mutex>
+#include <vector>
 #include <shlwapi.h>
 
 //#define USE_SHFETFILEINFOW_IN_RECOGNIZER
@@ -35,6 +39,19 @@ extern "C" {
 extern setting_color g_color_unrecognized;
 extern setting_color g_color_executable;
 
+static setting_int g_recognizer_workers(
+    "clink.recognizer_workers",
+    "Number of threads for recognizing commands",
+    "Recognizing whether command words are executable files happens on\n"
+    "background threads, so that typing stays responsive.  This is how many\n"
+    "threads may recognize words at the same time.",
+    2);
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_queue = 32;
+static const uint32 c_max_workers = 8;
+static const double c_max_batch_delay = 0.1;    // Seconds.
+
 //------------------------------------------------------------------------------
 static bool has_file_association(const char* name)
 {
@@ -42,7 +59,7 @@ static bool has_file_association(const char* name)
     if (!ext)
         return false;
 
-    if (os::get_path_type(name) != os::path_type_file)
+    if (fs_query_cache::get().get_path_type(name) != os::path_type_file)
         return false;
 
     wstr<32> wext(ext);
@@ -57,7 +74,7 @@ static bool has_file_association(const char* name)
 //------------------------------------------------------------------------------
 static bool file_exists(const char* full, str_base& out)
 {
-    if (os::get_path_type(full) == os::path_type_file)
+    if (fs_query_cache::get().get_path_type(full) == os::path_type_file)
     {
         os::get_full_path_name(full, out);
         return true;
@@ -144,6 +161,8 @@ static bool search_for_executable(const char* _word, const char* cwd, str_base&
     // Make list of paths to search.
     str<> tmp;
     str<> paths;
+    str<> indexed;
+    int32 index_result = -1;
     if (path::is_rooted(_word))
     {
         path::get_directory(_word, paths);
@@ -152,7 +171,11 @@ static bool search_for_executable(const char* _word, const char* cwd, str_base&
     {
         if (need_cwd)
             paths = cwd;
-        if (need_path && os::get_env("PATH", tmp))
+        // The executable index answers for %PATH% with a hash lookup, unless
+        // it can't (e.g. the name has an extension that isn't in %PATHEXT%).
+        if (need_path)
+            index_result = exe_index::get().find(_word, indexed);
+        if (need_path && index_result < 0 && os::get_env("PATH", tmp))
         {
             if (paths.length() > 0)
                 paths.concat(";", 1);
@@ -175,21 +198,20 @@ static bool search_for_executable(const char* _word, const char* cwd, str_base&
             continue;
 
         // Skip drives that are unknown, invalid, or remote.
-        {
-            char drive[4];
-            drive[0] = full.c_str()[0];
-            drive[1] = ':';
-            drive[2] = '\\';
-            drive[3] = '\0';
-            if (os::get_drive_type(drive) < os::drive_type_removable)
-                continue;
-        }
+        if (!os::is_local_drive(full.c_str()))
+            continue;
 
         // Try PATHEXT extensions.
         if (search_for_extension(full, _word, out))
             return true;
     }
 
+    if (index_result > 0)
+    {
+        out = indexed.c_str();
+        return true;
+    }
+
     return false;
 }
 
@@ -206,6 +228,7 @@ void set_noasync_recognizer()
 class recognizer
 {
     friend HANDLE get_recognizer_event();
+    friend class recognizer_work;
 
     struct cache_entry
     {
@@ -219,20 +242,19 @@ class recognizer
     struct entry
     {
                             entry() {}
-        bool                empty() const { return m_key.empty(); }
-        void                clear();
         str_moveable        m_key;
         str_moveable        m_word;
         str_moveable        m_cwd;
+        uint32              m_priority = 0; // Lower is more urgent.
     };
 
 public:
                             recognizer();
-                            ~recognizer() { assert(!m_thread); }
+                            ~recognizer() { assert(!m_work); }
     void                    shutdown();
     void                    clear();
     int32                   find(const char* key, recognition& cached, str_base* file) const;
-    bool                    enqueue(const char* key, const char* word, const char* cwd, const recognition* cached=nullptr);
+    bool                    enqueue(const char* key, const char* word, const char* cwd, uint32 priority, const recognition* cached=nullptr);
     bool                    need_refresh();
     void                    end_line();
 
@@ -241,20 +263,21 @@ public:
 private:
     bool                    usable() const;
     bool                    busy() const;
-    bool                    store(const char* word, const char* file, recognition cached, bool pending=false);
+    bool                    store(const char* word, const char* file, recognition cached, bool pending=false, bool outofdate=false);
     bool                    dequeue(entry& entry);
     bool                    set_result_available(bool available);
     void                    notify_ready(bool available);
-    static void             proc(recognizer* r);
+    void                    proc(const work_item* self);
 
 private:
     str_unordered_map<cache_entry> m_cache;
     str_unordered_map<cache_entry> m_pending;
-    entry                   m_queue;
+    std::vector<entry>      m_queue;    // Unordered; dequeue() picks the most urgent.
     mutable std::recursive_mutex m_mutex;
-    std::unique_ptr<std::thread> m_thread;
-    HANDLE                  m_event = nullptr;
-    bool                    m_processing = false;
+    std::vector<std::shared_ptr<work_item>> m_work; // Drain m_queue on the work pool.
+    uint32                  m_processing = 0;       // Workers recognizing a word.
+    uint32                  m_unsignaled = 0;       // Results not yet signaled.
+    double                  m_batch_clock = 0;
     bool                    m_result_available = false;
     volatile bool           m_zombie = false;
 
@@ -264,14 +287,18 @@ private:
 //------------------------------------------------------------------------------
 HANDLE recognizer::s_ready_event = nullptr;
 static recognizer s_recognizer;
+static recognizer_cache s_saved_cache;
 
 //------------------------------------------------------------------------------
-void recognizer::entry::clear()
+class recognizer_work : public work_item
 {
-    m_key.clear();
-    m_word.clear();
-    m_cwd.clear();
-}
+public:
+                            recognizer_work(recognizer* r) : m_recognizer(r) {}
+protected:
+    void                    run() override { m_recognizer->proc(this); }
+private:
+    recognizer* const       m_recognizer;
+};
 
 //------------------------------------------------------------------------------
 recognizer::recognizer()
@@ -292,6 +319,7 @@ void recognizer::clear()
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
     m_queue.clear();
+    m_unsignaled = 0;
 
     for (auto iter = m_pending.begin(); iter != m_pending.end();)
     {
@@ -365,7 +393,7 @@ int32 recognizer::find(const char* key, recognition& cached, str_base* file) con
 }
 
 //------------------------------------------------------------------------------
-bool recognizer::enqueue(const char* key, const char* word, const char* cwd, const recognition* cached)
+bool recognizer::enqueue(const char* key, const char* word, const char* cwd, uint32 priority, const recognition* cached)
 {
     if (!key || !*key || !word || !*word)
     {
@@ -381,29 +409,75 @@ bool recognizer::enqueue(const char* key, const char* word, const char* cwd, con
 
         assert(s_ready_event);
 
-        if (!m_event)
         {
-            m_event = CreateEvent(nullptr, false, false, nullptr);
-            if (!m_event)
-                return false;
-        }
+            dbg_ignore_scope(snapshot, "Recognizer queue");
 
-        if (!m_thread)
-        {
-            dbg_ignore_scope(snapshot, "Recognizer thread");
-            m_thread = std::make_unique<std::thread>(&proc, this);
-        }
+            entry* slot = nullptr;
+            for (auto& e : m_queue)
+            {
+                if (e.m_key.equals(key))
+                {
+                    slot = &e;
+                    priority = min(priority, e.m_priority);
+                    break;
+                }
+            }
 
-        {
-            dbg_ignore_scope(snapshot, "Recognizer queue");
-            m_queue.m_key = key;
-            m_queue.m_word = word;
-            m_queue.m_cwd = cwd;
+            if (!slot && m_queue.size() >= c_max_queue)
+            {
+                // The queue is full, so make room by dropping the least urgent
+                // word, unless the new word is even less urgent.  A dropped
+                // word gets enqueued again the next time it's classified.
+                entry* worst = &m_queue[0];
+                for (auto& e : m_queue)
+                {
+                    if (e.m_priority > worst->m_priority)
+                        worst = &e;
+                }
+                if (worst->m_priority <= priority)
+                    return false;
+
+                auto const iter = m_pending.find(worst->m_key.c_str());
+                if (iter != m_pending.end())
+                {
+                    char* pending_key = iter->second.m_key;
+                    m_pending.erase(iter);
+                    free(pending_key);
+                }
+                slot = worst;
+            }
+
+            if (!slot)
+            {
+                m_queue.emplace_back();
+                slot = &m_queue.back();
+            }
+
+            slot->m_key = key;
+            slot->m_word = word;
+            slot->m_cwd = cwd;
+            slot->m_priority = priority;
         }
 
         store(key, nullptr, cached ? *cached : recognition::unrecognized, true/*pending*/);
 
-        SetEvent(m_event);  // Signal thread there is work to do.
+        // Submit work to drain the queue, unless enough workers are already
+        // active; proc() removes a worker from m_work under the lock when it
+        // finds the queue empty.
+        const uint32 limit = min<uint32>(max<int32>(g_recognizer_workers.get(), 1), c_max_workers);
+        work_pool::get().set_limit(work_category::recognizer, limit);
+        while (m_work.size() < limit && m_work.size() - m_processing < m_queue.size())
+        {
+            dbg_ignore_scope(snapshot, "Recognizer work");
+            auto work = std::make_shared<recognizer_work>(this);
+            if (!work_pool::get().submit(work_category::recognizer, work))
+            {
+                if (m_work.empty())
+                    return false;
+                break;
+            }
+            m_work.emplace_back(std::move(work));
+        }
     }
 
     Sleep(0);           // Give up timeslice in case thread gets result quickly.
@@ -479,11 +553,11 @@ bool recognizer::usable() const
 //------------------------------------------------------------------------------
 bool recognizer::busy() const
 {
-    return m_processing || !m_pending.empty();
+    return m_processing > 0 || !m_pending.empty();
 }
 
 //------------------------------------------------------------------------------
-bool recognizer::store(const char* word, const char* file, recognition cached, bool pending)
+bool recognizer::store(const char* word, const char* file, recognition cached, bool pending, bool outofdate)
 {
     assert(*word);
     if (!*word)
@@ -496,13 +570,16 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
 
     auto& map = pending ? m_pending : m_cache;
 
+    // Finished results are signaled in batches by proc().
+    const bool signal = pending;
+
     dbg_ignore_scope(snapshot, "Recognizer");
 
     cache_entry entry;
     entry.m_file = file;
     entry.m_age = time(nullptr);
     entry.m_recognition = cached;
-    entry.m_outofdate = false;
+    entry.m_outofdate = outofdate;
 
     auto const iter = map.find(word);
     if (iter != map.end())
@@ -510,7 +587,8 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
         assert(iter->first == iter->second.m_key);
         entry.m_key = iter->second.m_key;
         map.insert_or_assign(iter->first, std::move(entry));
-        set_result_available(true);
+        if (signal)
+            set_result_available(true);
         return true;
     }
 
@@ -521,7 +599,8 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
     strcpy(key, word);
     entry.m_key = key;
     map.emplace(key, std::move(entry));
-    set_result_available(true);
+    if (signal)
+        set_result_available(true);
     return true;
 }
 
@@ -533,8 +612,19 @@ bool recognizer::dequeue(entry& entry)
     if (!usable() || m_queue.empty())
         return false;
 
-    entry = std::move(m_queue);
-    assert(m_queue.empty());
+    // The queue is small, so a linear search for the most urgent word is
+    // cheaper than keeping it sorted.
+    size_t best = 0;
+    for (size_t i = 1; i < m_queue.size(); ++i)
+    {
+        if (m_queue[i].m_priority < m_queue[best].m_priority)
+            best = i;
+    }
+
+    entry = std::move(m_queue[best]);
+    if (best + 1 < m_queue.size())
+        m_queue[best] = std::move(m_queue.back());
+    m_queue.pop_back();
     return true;
 }
 
@@ -578,7 +668,7 @@ void recognizer::notify_ready(bool available)
 //------------------------------------------------------------------------------
 void recognizer::shutdown()
 {
-    std::unique_ptr<std::thread> thread;
+    std::vector<std::shared_ptr<work_item>> work;
 
     {
         std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -586,61 +676,99 @@ void recognizer::shutdown()
         clear();
         m_zombie = true;
 
-        if (m_event)
-            SetEvent(m_event);
-
-        thread = std::move(m_thread);
+        work.swap(m_work);
     }
 
-    if (thread)
-        thread->join();
-
-    if (m_event)
-        CloseHandle(m_event);
+    for (auto& w : work)
+        w->cancel();
+    for (auto& w : work)
+        work_pool::get().wait(w.get());
 }
 
 //------------------------------------------------------------------------------
-void recognizer::proc(recognizer* r)
+void recognizer::proc(const work_item* self)
 {
     CoInitialize(0);
 
+    entry entry;
     while (true)
     {
-        if (WaitForSingleObject(r->m_event, INFINITE) != WAIT_OBJECT_0)
-        {
-            // Uh oh.
-            Sleep(5000);
-        }
-
-        entry entry;
-        while (true)
         {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            if (m_zombie || !dequeue(entry))
             {
-                std::lock_guard<std::recursive_mutex> lock(r->m_mutex);
-                if (r->m_zombie || !r->dequeue(entry))
+                if (!m_zombie)
                 {
-                    r->m_processing = false;
-                    r->m_pending.clear();
-                    if (!r->m_zombie)
-                        r->notify_ready(false);
-                    break;
+                    for (auto iter = m_work.begin(); iter != m_work.end(); ++iter)
+                    {
+                        if (iter->get() == self)
+                        {
+                            m_work.erase(iter);
+                            break;
+                        }
+                    }
+
+                    // Pending entries are only needed while words are being
+                    // recognized.
+                    if (!m_processing)
+                    {
+                        m_pending.clear();
+                        notify_ready(m_unsignaled > 0);
+                        m_unsignaled = 0;
+                    }
                 }
-                r->m_processing = true;
+                break;
             }
+            m_processing++;
+        }
 
-            // Search for executable file.
-            str<> found;
-            recognition result = recognition::unrecognized;
-            if (search_for_executable(entry.m_word.c_str(), entry.m_cwd.c_str(), found))
-                result = recognition::executable;
+        // A saved result is still correct if the directory containing the
+        // file hasn't changed; otherwise search for the executable file.
+        str<> found;
+        str<> saved_key;
+        recognition result = recognition::unrecognized;
+        const char* key = entry.m_key.c_str();
+        const bool saveable = recognizer_cache::make_key(key, entry.m_cwd.c_str(), saved_key);
+        if (saveable && s_saved_cache.is_fresh(saved_key.c_str()) &&
+            s_saved_cache.lookup(saved_key.c_str(), found))
+            result = recognition::executable;
+        else if (search_for_executable(entry.m_word.c_str(), entry.m_cwd.c_str(), found))
+            result = recognition::executable;
+
+        // Store result.
+        store(key, found.c_str(), result);
+
+        // Save results that other sessions can use, i.e. ones that don't
+        // depend on a relative path.  Names found in the current directory
+        // aren't saved, since they come and go with changing directories.
+        if (saveable)
+        {
+            str<> found_dir;
+            if (result != recognition::executable)
+                s_saved_cache.remove(saved_key.c_str());
+            else if (path::get_directory(found.c_str(), found_dir) &&
+                     (path::is_rooted(key) || !found_dir.iequals(entry.m_cwd.c_str())))
+                s_saved_cache.update(saved_key.c_str(), found.c_str());
+        }
 
-            // Store result.
-            r->store(entry.m_key.c_str(), found.c_str(), result);
-            r->notify_ready(true);
+        // Signal results in batches, so the input line gets reclassified once
+        // when the queue drains instead of once per word.  But don't hold back
+        // results for long if words keep arriving or take a while.
+        bool signal;
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            const double now = os::clock();
+            if (!m_unsignaled++)
+                m_batch_clock = now;
+            signal = ((m_queue.empty() && m_processing == 1) ||
+                      now - m_batch_clock >= c_max_batch_delay);
+            if (signal)
+                m_unsignaled = 0;
+            m_processing--;
         }
 
-        if (r->m_zombie)
-            break;
+        if (signal)
+            notify_ready(true);
     }
 
     CoUninitialize();
@@ -680,16 +808,31 @@ extern "C" void end_recognizer()
 {
     s_recognizer.end_line();
     s_recognizer.clear();
+    s_saved_cache.save();
+    exe_index::get().invalidate();
 }
 
 //------------------------------------------------------------------------------
 void shutdown_recognizer()
 {
     s_recognizer.shutdown();
+    s_saved_cache.save();
+}
+
+//------------------------------------------------------------------------------
+void set_recognizer_cache_dir(const char* dir)
+{
+    str<> file;
+    if (dir && *dir)
+    {
+        file = dir;
+        path::append(file, "recognizer_cache");
+    }
+    s_saved_cache.set_file(file.c_str());
 }
 
 //------------------------------------------------------------------------------
-recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file)
+recognition recognize_command(const char* line, const char* word, bool quoted, bool& ready, str_base* file, int32 offset)
 {
     assert(word);
 
@@ -745,7 +888,7 @@ recognition recognize_command(const char* line, const char* word, bool quoted, b
     // Check for drive letter.
     if (word[0] && word[1] == ':' && !word[2])
     {
-        int32 type = os::get_drive_type(word);
+        int32 type = fs_query_cache::get().get_drive_type(word);
         if (type > os::drive_type_invalid)
             return recognition::navigate;
     }
@@ -759,6 +902,25 @@ recognition recognize_command(const char* line, const char* word, bool quoted, b
         return cached;
     }
 
+    // Check for a result saved by an earlier session.  Use it until the
+    // recognizer verifies it in the background; checking whether it's still
+    // good would hit the file system, which mustn't delay input.
+    str<> cwd;
+    os::get_current_dir(cwd);
+    if (cached != recognition::executable)
+    {
+        str<> saved_key;
+        str<> saved_file;
+        if (recognizer_cache::make_key(word, cwd.c_str(), saved_key) &&
+            s_saved_cache.lookup(saved_key.c_str(), saved_file))
+        {
+            s_recognizer.store(word, saved_file.c_str(), recognition::executable, false/*pending*/, true/*outofdate*/);
+            cached = recognition::executable;
+            if (file)
+                *file = saved_file.c_str();
+        }
+    }
+
     // Expand environment variables.
     str<32> expanded;
     const char* orig_word = word;
@@ -773,10 +935,10 @@ recognition recognize_command(const char* line, const char* word, bool quoted, b
     if (strchr(word, '*') || strchr(word, '?'))
         return recognition::unrecognized;
 
-    // Queue for background thread processing.
-    str<> cwd;
-    os::get_current_dir(cwd);
-    if (!s_recognizer.enqueue(orig_word, word, cwd.c_str(), &cached))
+    // Queue for background thread processing.  Words nearer the cursor are
+    // more urgent, and words without a known offset come first.
+    const uint32 priority = (offset < 0) ? 0 : 1 + uint32(abs(offset - rl_point));
+    if (!s_recognizer.enqueue(orig_word, word, cwd.c_str(), priority, &cached))
         return recognition::unknown;
 
     ready = false;
@@ -0,0 +1,308 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "recognizer_cache.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str_tokeniser.h>
+#include <core/str_transform.h>
+
+#include <algorithm>
+#include <vector>
+
+//------------------------------------------------------------------------------
+static const char c_header[] = "clink_recognizer_cache 2";
+static const uint32 c_key_fields = 3;           // Word, path hash, cwd class.
+static const time_t c_used_granularity = 60 * 60 * 24;
+
+
+
+//------------------------------------------------------------------------------
+static bool get_file_dir_mtime(const char* file, uint64& mtime)
+{
+    str<> dir;
+    if (!path::get_directory(file, dir))
+        return false;
+    return os::get_dir_mtime(dir.c_str(), mtime);
+}
+
+//------------------------------------------------------------------------------
+static time_t clock_now()
+{
+    return time(nullptr);
+}
+
+//------------------------------------------------------------------------------
+static void hash_lower(const char* s, uint64& hash)
+{
+    for (; *s; ++s)
+    {
+        hash ^= uint8(tolower(uint8(*s)));
+        hash *= 0x100000001b3;
+    }
+    hash ^= ';';
+    hash *= 0x100000001b3;
+}
+
+
+
+//------------------------------------------------------------------------------
+recognizer_cache::recognizer_cache(uint32 max_entries)
+: m_clock(&clock_now)
+, m_max_entries(max_entries)
+{
+}
+
+//------------------------------------------------------------------------------
+// Builds the key for saving the result for a lowercase word.  Returns false
+// if the result depends on a relative path and can't be saved.
+bool recognizer_cache::make_key(const char* word, const char* cwd, str_base& key)
+{
+    const bool rooted = path::is_rooted(word);
+    if (!*word || (!rooted && strpbrk(word, "/\\")))
+        return false;
+
+    // %PATHEXT% affects how any word is resolved; %PATH% only affects names.
+    str<> tmp;
+    uint64 hash = 0xcbf29ce484222325;
+    if (os::get_env("PATHEXT", tmp))
+        hash_lower(tmp.c_str(), hash);
+    if (!rooted && os::get_env("PATH", tmp))
+        hash_lower(tmp.c_str(), hash);
+
+    // cmd looks for names in the current directory before %PATH%, unless
+    // NoDefaultCurrentDirectoryInExePath is set.
+    str<> cwd_class("*");
+    if (!rooted && cwd && *cwd)
+    {
+        wstr<32> wword(word);
+        if (NeedCurrentDirectoryForExePathW(wword.c_str()))
+            str_transform(cwd, -1, cwd_class, transform_mode::lower);
+    }
+
+    key.format("%s\t%016llx\t%s", word, hash, cwd_class.c_str());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void recognizer_cache::set_file(const char* file)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.equals(file ? file : ""))
+        return;
+
+    m_file = file ? file : "";
+    m_map.clear();
+    m_loaded = false;
+    m_dirty = false;
+}
+
+//------------------------------------------------------------------------------
+// Looks up a saved result without touching the file system (other than
+// loading the saved results the first time).  The result may be out of date;
+// is_fresh() can tell.
+bool recognizer_cache::lookup(const char* key, str_base& file)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    load();
+
+    auto iter = m_map.find(key);
+    if (iter == m_map.end())
+        return false;
+
+    entry& e = iter->second;
+    touch(e);
+    file = e.file.c_str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the directory containing the saved file hasn't changed since
+// the result was saved, in which case the result is still correct.  This hits
+// the file system, so it's for the recognizer's background thread.
+bool recognizer_cache::is_fresh(const char* key)
+{
+    str<> file;
+    uint64 saved_mtime;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        load();
+
+        auto iter = m_map.find(key);
+        if (iter == m_map.end())
+            return false;
+        file = iter->second.file.c_str();
+        saved_mtime = iter->second.dir_mtime;
+    }
+
+    uint64 mtime;
+    return get_file_dir_mtime(file.c_str(), mtime) && mtime == saved_mtime;
+}
+
+//------------------------------------------------------------------------------
+// The last used time only needs to be roughly right for choosing which entries
+// to keep, so it's only updated (and the file only rewritten) occasionally.
+void recognizer_cache::touch(entry& e)
+{
+    const time_t now = m_clock();
+    if (now - e.used >= c_used_granularity)
+    {
+        e.used = now;
+        m_dirty = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+void recognizer_cache::update(const char* key, const char* file)
+{
+    uint64 mtime;
+    if (!get_file_dir_mtime(file, mtime))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.empty())
+        return;
+    load();
+
+    auto iter = m_map.find(key);
+    if (iter != m_map.end())
+    {
+        entry& e = iter->second;
+        if (!e.file.equals(file) || e.dir_mtime != mtime)
+        {
+            e.file = file;
+            e.dir_mtime = mtime;
+            m_dirty = true;
+        }
+        touch(e);
+    }
+    else
+    {
+        entry e;
+        e.key = key;
+        e.file = file;
+        e.dir_mtime = mtime;
+        e.used = m_clock();
+        const char* k = e.key.c_str();
+        m_map.emplace(k, std::move(e));
+        m_dirty = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+void recognizer_cache::remove(const char* key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_loaded)
+        return;
+
+    auto iter = m_map.find(key);
+    if (iter != m_map.end())
+    {
+        m_map.erase(iter);
+        m_dirty = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+void recognizer_cache::save()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty || m_file.empty())
+        return;
+    m_dirty = false;
+
+    // Keep the most recently used entries.
+    std::vector<const entry*> entries;
+    entries.reserve(m_map.size());
+    for (const auto& iter : m_map)
+        entries.emplace_back(&iter.second);
+    if (entries.size() > m_max_entries)
+    {
+        std::nth_element(entries.begin(), entries.begin() + m_max_entries, entries.end(),
+                         [](const entry* a, const entry* b) { return a->used > b->used; });
+        for (size_t i = m_max_entries; i < entries.size(); ++i)
+            m_map.erase(entries[i]->key.c_str());
+        entries.resize(m_max_entries);
+    }
+
+    // Write to a temporary file and then move it into place, so that other
+    // Clink instances never see a partially written cache file.
+    str<> tmp;
+    tmp.format("%s.%u.tmp", m_file.c_str(), GetCurrentProcessId());
+    wstr<> wtmp(tmp.c_str());
+    FILE* file = _wfopen(wtmp.c_str(), L"wt");
+    if (!file)
+        return;
+
+    bool ok = (fprintf(file, "%s\n", c_header) > 0);
+    for (const entry* e : entries)
+    {
+        if (!ok)
+            break;
+        ok = (fprintf(file, "%s\t%s\t%llx\t%llu\n", e->key.c_str(), e->file.c_str(),
+                      e->dir_mtime, uint64(e->used)) > 0);
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    wstr<> wfile(m_file.c_str());
+    if (!ok || !MoveFileExW(wtmp.c_str(), wfile.c_str(), MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(wtmp.c_str());
+}
+
+//------------------------------------------------------------------------------
+void recognizer_cache::load()
+{
+    if (m_loaded || m_file.empty())
+        return;
+    m_loaded = true;
+
+    wstr<> wfile(m_file.c_str());
+    FILE* file = _wfopen(wfile.c_str(), L"rt");
+    if (!file)
+        return;
+
+    char line[1024];
+    if (fgets(line, sizeof(line), file) && strncmp(line, c_header, sizeof(c_header) - 1) == 0)
+    {
+        while (fgets(line, sizeof(line), file))
+        {
+            // Fields are the key (word, path hash, and cwd class), file,
+            // directory mtime (hex), and last used time.
+            char* fields[c_key_fields + 3];
+            uint32 count = 0;
+            char* p = line;
+            while (count < sizeof_array(fields))
+            {
+                fields[count++] = p;
+                p = strpbrk(p, "\t\r\n");
+                if (!p)
+                    break;
+                const bool last = (*p != '\t');
+                *(p++) = '\0';
+                if (last)
+                    break;
+            }
+            if (count < sizeof_array(fields) || !*fields[0] || !*fields[c_key_fields])
+                continue;
+
+            entry e;
+            for (uint32 i = 0; i < c_key_fields; ++i)
+            {
+                if (i)
+                    e.key.concat("\t", 1);
+                e.key.concat(fields[i]);
+            }
+            e.file = fields[c_key_fields];
+            e.dir_mtime = _strtoui64(fields[c_key_fields + 1], nullptr, 16);
+            e.used = time_t(_strtoui64(fields[c_key_fields + 2], nullptr, 10));
+            const char* k = e.key.c_str();
+            if (m_map.find(k) == m_map.end())
+                m_map.emplace(k, std::move(e));
+        }
+    }
+
+    fclose(file);
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// Remembers recognized executables across sessions, so that a new window can
+// color command words right away instead of waiting for the recognizer.
+//
+// Only words whose result doesn't depend on a relative path are saved, i.e.
+// names found through %PATH% and fully qualified paths.  The key includes a
+// hash of %PATH% and %PATHEXT%, and for names that cmd also looks for in the
+// current directory the key includes the current directory.  Each entry keeps
+// the last write time of the directory that contains the file; if that hasn't
+// changed then the entry is still valid without looking for the file.
+//
+// lookup() never touches the file system, so the input thread can use it;
+// is_fresh() checks the directory and belongs on the recognizer's thread.
+class recognizer_cache
+{
+public:
+                    recognizer_cache(uint32 max_entries=1000);
+
+    static bool     make_key(const char* word, const char* cwd, str_base& key);
+
+    void            set_file(const char* file);
+    bool            lookup(const char* key, str_base& file);
+    bool            is_fresh(const char* key);
+    void            update(const char* key, const char* file);
+    void            remove(const char* key);
+    void            save();
+
+    // For tests.
+    void            set_clock(time_t (*clock)()) { m_clock = clock; }
+
+private:
+    struct entry
+    {
+        str_moveable key;
+        str_moveable file;
+        uint64      dir_mtime = 0;
+        time_t      used = 0;
+    };
+
+    void            load();
+    void            touch(entry& e);
+
+    std::mutex      m_mutex;
+    str_moveable    m_file;
+    str_unordered_map<entry> m_map;     // Keys are owned by the entries.
+    time_t          (*m_clock)();
+    const uint32    m_max_entries;
+    bool            m_loaded = false;
+    bool            m_dirty = false;
+};
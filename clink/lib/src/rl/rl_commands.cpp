@@ -15,6 +15,8 @@
 #include "host_callbacks.h"
 #include "display_readline.h"
 #include "recognizer.h"
+#include "exe_index.h"
+#include "dir_cache.h"
 #include "wakeup_chars.h"
 #include "clink_rl_signal.h"
 #include "rl_integration.h"
@@ -26,6 +28,8 @@
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/debugheap.h>
+#include <core/fs_query_cache.h>
+#include <core/work_pool.h>
 #include <terminal/wcwidth.h>
 #include <terminal/printer.h>
 #include <terminal/scroll.h>
@@ -2708,6 +2712,9 @@ void terminal_file::write(const char* chars, int32 length)
 
 //------------------------------------------------------------------------------
 extern void task_manager_diagnostics();
+extern void lua_profiler_diagnostics();
+extern void lua_allocator_diagnostics();
+extern bool lua_profiler_dump(const char* file);
 static void do_clink_diagnostics(bool include_settings=false)
 {
     static char bold[] = "\x1b[1m";
@@ -2841,6 +2848,81 @@ static void do_clink_diagnostics(bool include_settings=false)
 
     task_manager_diagnostics();
 
+    lua_profiler_diagnostics();
+
+    if (rl_explicit_arg)
+        lua_allocator_diagnostics();
+
+    // Worker pool info.
+
+    if (rl_explicit_arg)
+    {
+        static const char* const c_category_names[] = { "yield", "async tasks", "recognizer", "prefetch" };
+        static_assert(sizeof_array(c_category_names) == size_t(work_category::max), "c_category_names doesn't match work_category");
+
+        const work_pool& pool = work_pool::get();
+        bool heading = false;
+        for (int32 i = 0; i < sizeof_array(c_category_names); ++i)
+        {
+            work_stats stats;
+            pool.get_stats(work_category(i), stats);
+            if (!stats.submitted)
+                continue;
+
+            if (!heading)
+            {
+                print_heading("worker pool");
+                t.format("%u (peak %u)", pool.get_thread_count(), pool.get_peak_thread_count());
+                print_value("threads", t.c_str());
+                heading = true;
+            }
+
+            const uint32 started = max<uint32>(stats.completed + stats.running, 1);
+            const uint32 completed = max<uint32>(stats.completed, 1);
+            str<16> limit;
+            if (stats.limit)
+                limit.format("/%u", stats.limit);
+            t.format("running %u%s, queued %u (peak %u), done %u, canceled %u",
+                     stats.running, limit.c_str(), stats.queued, stats.peak_queued,
+                     stats.completed, stats.canceled);
+            print_value(c_category_names[i], t.c_str());
+            t.format("wait avg %.1f ms (max %.1f ms), run avg %.1f ms (max %.1f ms)",
+                     stats.wait_time * 1000 / started, stats.max_wait * 1000,
+                     stats.run_time * 1000 / completed, stats.max_run * 1000);
+            print_value("", t.c_str());
+        }
+    }
+
+    // Executable index, directory cache, and file system query cache info.
+
+    if (rl_explicit_arg)
+    {
+        uint32 lookups, hits, scans;
+        exe_index::get().get_stats(lookups, hits, scans);
+        if (lookups || scans)
+        {
+            print_heading("executable index");
+            t.format("%u lookups, %u hits, %u directory scans", lookups, hits, scans);
+            print_value("path", t.c_str());
+        }
+
+        dir_cache::get().get_stats(lookups, hits, scans);
+        if (lookups || scans)
+        {
+            print_heading("directory cache");
+            t.format("%u lookups, %u hits, %u directory reads", lookups, hits, scans);
+            print_value("listings", t.c_str());
+        }
+
+        fs_query_cache::get().get_stats(lookups, hits);
+        if (lookups)
+        {
+            print_heading("file system query cache");
+            t.format("%u lookups, %u hits (%.0f%%)", lookups, hits, double(hits) * 100 / lookups);
+            print_value("types", t.c_str());
+        }
+    }
+
     // Check for known potential ambiguous character width issues.
 
     {
@@ -2950,6 +3032,10 @@ int32 clink_diagnostics_output(int32 count, int32 invoking_key)
 
     printf("Clink diagnostics output written to '%s'.\n", file.c_str());
 
+    path::join(context.profile.c_str(), "clink.profile.json", file);
+    if (lua_profiler_dump(file.c_str()))
+        printf("Lua profile written to '%s'.\n", file.c_str());
+
     rl_forced_update_display();
     return 0;
 }
@@ -102,6 +102,12 @@ static int32 s_old_default_popup_search_mode = -1;
 static int32 s_default_popup_search_mode = -1;
 const int32 min_screen_cols = 20;
 
+// Lists with more items than this are virtualized:  only the visible window
+// plus a sample of items are materialized and measured before the first paint,
+// and the rest are measured incrementally while waiting for input.
+const int32 c_virtualize_threshold = 2000;
+const int32 c_virtualize_sample = 500;
+
 //------------------------------------------------------------------------------
 static int32 make_item(const char* in, str_base& out)
 {
@@ -369,7 +375,13 @@ int32 textlist_impl::addl_columns::get_col_layout_width(int32 col) const
 }
 
 //------------------------------------------------------------------------------
-const char* textlist_impl::addl_columns::add_entry(const char* ptr)
+void textlist_impl::addl_columns::init_rows(int32 count)
+{
+    m_rows.resize(count);
+}
+
+//------------------------------------------------------------------------------
+const char* textlist_impl::addl_columns::add_entry(int32 row, const char* ptr)
 {
     size_t len_match = strlen(ptr);
     ptr += len_match + 1;
@@ -378,15 +390,16 @@ const char* textlist_impl::addl_columns::add_entry(const char* ptr)
     size_t len_display = strlen(ptr);
     ptr += len_display + 1;
 
-    add_columns(ptr);
+    add_columns(row, ptr);
 
     return display;
 }
 
 //------------------------------------------------------------------------------
-void textlist_impl::addl_columns::add_columns(const char* ptr)
+void textlist_impl::addl_columns::add_columns(int32 row, const char* ptr)
 {
-    column_text column_text = {};
+    assert(row >= 0 && row < m_rows.size());
+    column_text& column_text = m_rows[row];
     if (*ptr)
     {
         str<> tmp;
@@ -407,8 +420,6 @@ void textlist_impl::addl_columns::add_columns(const char* ptr)
         }
         m_any_tabs |= any_tabs;
     }
-
-    m_rows.emplace_back(std::move(column_text));
 }
 
 //------------------------------------------------------------------------------
@@ -581,11 +592,9 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
     const bool history_timestamps = (m_history_mode &&
         ((g_history_timestamp.get() == 2 && (!rl_explicit_arg || rl_numeric_arg)) ||
          (g_history_timestamp.get() == 1 && rl_explicit_arg && rl_numeric_arg)));
-    const HIST_ENTRY* const* const histlist = history_list();
     assertimplies(history_timestamps, !has_columns);
-    history_timeformatter timeformatter;
     if (history_timestamps)
-        timeformatter.set_timeformat(nullptr, true);
+        m_timeformatter.set_timeformat(nullptr, true);
 
 #ifdef USE_MEMORY_TRACKING
     sane_alloc_config sane = dbggetsaneallocconfig();
@@ -593,35 +602,13 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
         dbgsetsanealloc(max<int32>(count * (32 + (sizeof(void*)*3)), 256*1024), 1024*1024, nullptr);
 #endif
 
-    // Gather the items.
-    str<> tmp;
-    str<> tmp2;
-    for (int32 i = 0; i < count; i++)
-    {
-        const char* text;
-        if (has_columns)
-            text = m_columns.add_entry(m_entries[i]);
-        else
-        {
-            text = m_entries[i];
-            if (history_timestamps)
-            {
-                const int32 j = m_infos ? m_infos[i].index : i;
-                const char* timestamp = histlist[j]->timestamp;
-                tmp2.clear();
-                if (timestamp && *timestamp)
-                {
-                    const time_t tt = time_t(atoi(timestamp));
-                    timeformatter.format(tt, tmp);
-                    tmp2.format("%-*s\t", timeformatter.max_timelen(), tmp.c_str());
-                }
-                m_columns.add_columns(tmp2.c_str());
-            }
-        }
-        m_longest = max<int32>(m_longest, make_item(text, tmp));
-        m_items.push_back(m_store.add(tmp.c_str()));
-    }
+    // Prepare to gather the items.
+    m_entry_columns = has_columns;
+    m_history_timestamps = history_timestamps;
     m_has_columns = has_columns || history_timestamps;
+    m_items.resize(count);
+    if (m_has_columns)
+        m_columns.init_rows(count);
 
     if (title && *title)
         m_default_title = title;
@@ -638,6 +625,19 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
         m_top = max<int32>(0, min<int32>(m_index - (m_visible_rows / 2), m_count - m_visible_rows));
     }
 
+    // Gather the items.  Large lists only gather enough to estimate the
+    // layout; the rest are gathered by refine_widths() after the first paint.
+    if (count <= c_virtualize_threshold)
+    {
+        for (int32 i = 0; i < count; i++)
+            materialize(i);
+        m_refine_next = count;
+    }
+    else
+    {
+        materialize_sample();
+    }
+
     show_cursor(false);
     lock_cursor(true);
 
@@ -645,6 +645,7 @@ popup_results textlist_impl::activate(const char* title, const char** entries, i
     m_active = true;
     m_reset_history_index = false;
     update_display();
+    refine_widths();
 
     m_dispatcher.dispatch(m_bind_group);
 
@@ -939,7 +940,7 @@ find:
                 if (m_has_columns)
                 {
                     for (int32 col = 0; !match && col < max_columns; col++)
-                        match = strstr_compare(m_needle, m_columns.get_col_text(i, col));
+                        match = strstr_compare(m_needle, get_col_text(i, col));
                 }
 
                 if (match)
@@ -1009,6 +1010,8 @@ find:
             int32 move_count = (m_original_count - 1) - original_index;
             memmove(m_entries + original_index, m_entries + original_index + 1, move_count * sizeof(m_entries[0]));
             m_items.erase(m_items.begin() + original_index);
+            if (original_index < m_refine_next)
+                --m_refine_next;
             if (m_has_columns)
                 m_columns.erase_row(original_index);
             if (m_infos)
@@ -1357,6 +1360,10 @@ update_needle:
     if (set_input_clears_needle && !m_win_history)
         m_input_clears_needle = true;
 
+    // Continue measuring items in a virtualized list.
+    if (m_active)
+        refine_widths();
+
     // Keep dispatching input.
     result.loop();
 }
@@ -1997,6 +2004,10 @@ void textlist_impl::reset()
     m_longest = 0;
     m_columns.clear();
 
+    m_refine_next = 0;
+    m_entry_columns = false;
+    m_history_timestamps = false;
+
     m_filter_string.clear();
     m_filter_saved_index = -1;
     m_filter_saved_top = -1;
@@ -2026,6 +2037,94 @@ void textlist_impl::reset()
     m_store.clear();
 }
 
+//------------------------------------------------------------------------------
+void textlist_impl::materialize(int32 index) const
+{
+    assert(index >= 0 && index < m_items.size());
+    if (m_items[index])
+        return;
+
+    str<> tmp;
+    const char* text;
+    if (m_entry_columns)
+    {
+        text = m_columns.add_entry(index, m_entries[index]);
+    }
+    else
+    {
+        text = m_entries[index];
+        if (m_history_timestamps)
+        {
+            const int32 j = m_infos ? m_infos[index].index : index;
+            const char* timestamp = history_list()[j]->timestamp;
+            str<> tmp2;
+            if (timestamp && *timestamp)
+            {
+                const time_t tt = time_t(atoi(timestamp));
+                m_timeformatter.format(tt, tmp);
+                tmp2.format("%-*s\t", m_timeformatter.max_timelen(), tmp.c_str());
+            }
+            m_columns.add_columns(index, tmp2.c_str());
+        }
+    }
+
+    m_longest = max<int32>(m_longest, make_item(text, tmp));
+    m_items[index] = m_store.add(tmp.c_str());
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::materialize_sample()
+{
+    // Materialize the initially visible window plus a margin.
+    const int32 count = int32(m_items.size());
+    const int32 margin = max<int32>(m_visible_rows, 1);
+    const int32 first = max<int32>(0, m_top - margin);
+    const int32 last = min<int32>(count, m_top + m_visible_rows + margin);
+    for (int32 i = first; i < last; ++i)
+        materialize(i);
+
+    // Estimate the widths from items spread evenly across the list.
+    const int32 step = max<int32>(1, count / c_virtualize_sample);
+    for (int32 i = 0; i < count; i += step)
+        materialize(i);
+}
+
+//------------------------------------------------------------------------------
+void textlist_impl::refine_widths()
+{
+    const int32 count = int32(m_items.size());
+    if (m_refine_next >= count)
+        return;
+
+    const int32 longest = m_longest;
+    int32 longest_col[max_columns];
+    for (int32 col = 0; col < max_columns; ++col)
+        longest_col[col] = m_columns.get_col_longest(col);
+
+    // Measure the remaining items until all are measured or input arrives.
+    int32 defer_test = 0;
+    while (m_refine_next < count)
+    {
+        if (!defer_test--)
+        {
+            defer_test = 256;
+            if (m_dispatcher.available(0))
+                break;
+        }
+        materialize(m_refine_next++);
+    }
+
+    // Redraw if the estimated widths were too small.
+    bool changed = (longest != m_longest);
+    for (int32 col = 0; !changed && col < max_columns; ++col)
+        changed = (longest_col[col] != m_columns.get_col_longest(col));
+    if (changed && m_active)
+    {
+        m_prev_displayed = -1;
+        update_display();
+    }
+}
+
 //------------------------------------------------------------------------------
 int32 textlist_impl::get_original_index(int32 index) const
 {
@@ -2039,6 +2138,7 @@ const char* textlist_impl::get_item_text(int32 index) const
 {
     if (!m_filter_string.empty())
         index = m_filtered_items[index];
+    materialize(index);
     return m_items[index];
 }
 
@@ -2047,6 +2147,7 @@ const char* textlist_impl::get_col_text(int32 index, int32 col) const
 {
     if (!m_filter_string.empty())
         index = m_filtered_items[index];
+    materialize(index);
     return m_columns.get_col_text(index, col);
 }
 
@@ -2125,6 +2226,7 @@ bool textlist_impl::filter_items()
                 return false;
 
             const int32 original_index = m_filtered_items[i];
+            materialize(original_index);
 
             bool match = m_needle.empty() || strstr_compare(m_needle, m_items[original_index]);
             if (m_has_columns)
@@ -2145,6 +2247,7 @@ bool textlist_impl::filter_items()
             if (!defer_test-- && test_input())
                 return false;
 
+            materialize(int32(i));
             bool match = m_needle.empty() || strstr_compare(m_needle, m_items[i]);
             if (m_has_columns)
             {
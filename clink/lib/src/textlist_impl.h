@@ -4,6 +4,7 @@
 #pragma once
 
 #include "editor_module.h"
+#include "history_timeformatter.h"
 #include "input_dispatcher.h"
 #include "popup.h"
 #include "scroll_helper.h"
@@ -49,8 +50,9 @@ class textlist_impl
         const char* get_col_text(int32 row, int32 col) const;
         int32       get_col_longest(int32 col) const;
         int32       get_col_layout_width(int32 col) const;
-        const char* add_entry(const char* entry);
-        void        add_columns(const char* columns);
+        void        init_rows(int32 count);
+        const char* add_entry(int32 row, const char* entry);
+        void        add_columns(int32 row, const char* columns);
         void        erase_row(int32 row);
         int32       calc_widths(int32 available);
         bool        get_any_tabs() const;
@@ -92,6 +94,12 @@ private:
     void            init_colors(const popup_config* config);
     void            reset();
 
+    // Virtualization.  Items are materialized lazily, even by the const
+    // accessors, so the item storage and widths they update are mutable.
+    void            materialize(int32 original_index) const;
+    void            materialize_sample();
+    void            refine_widths();
+
     // Filtering.
     int32           get_original_index(int32 index) const;
     const char*     get_item_text(int32 index) const;
@@ -139,9 +147,15 @@ private:
     int32           m_count = 0;
     const char**    m_entries = nullptr;    // Original entries from caller.
     entry_info*     m_infos = nullptr;      // Original entry numbers/etc from caller.
-    std::vector<const char*> m_items;       // Escaped entries for display.
-    int32           m_longest = 0;
-    addl_columns    m_columns;
+    mutable std::vector<const char*> m_items; // Escaped entries for display; nullptr until materialized.
+    mutable int32   m_longest = 0;
+    mutable addl_columns m_columns;
+
+    // Virtualization.
+    int32           m_refine_next = 0;      // Next item to measure while refining widths.
+    bool            m_entry_columns = false;// Entries are packed with columns.
+    bool            m_history_timestamps = false;
+    mutable history_timeformatter m_timeformatter;
 
     // Filtering.
     str_moveable    m_filter_string;
@@ -199,5 +213,5 @@ private:
         unsigned    m_front = 0;
         unsigned    m_back = 0;
     };
-    item_store      m_store;
+    mutable item_store m_store;
 };
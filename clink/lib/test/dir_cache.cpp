@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lib/dir_cache.h>
+
+//------------------------------------------------------------------------------
+static std::shared_ptr<const dir_cache::listing> wait_for_listing(const char* dir)
+{
+    dir_cache& cache = dir_cache::get();
+    cache.prefetch(dir);
+
+    const double start = os::clock();
+    while (os::clock() - start < 5.0)
+    {
+        auto listing = cache.find(dir);
+        if (listing)
+            return listing;
+        Sleep(10);
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+static bool has_file(const dir_cache::listing& listing, const char* name)
+{
+    for (const auto& file : listing.files)
+        if (strcmp(file.name, name) == 0)
+            return true;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Directory cache")
+{
+    SECTION("Name patterns")
+    {
+        REQUIRE(dir_cache::match_name("*", "abc"));
+        REQUIRE(dir_cache::match_name("a*", "abc"));
+        REQUIRE(dir_cache::match_name("*c", "abc"));
+        REQUIRE(dir_cache::match_name("a?c", "abc"));
+        REQUIRE(dir_cache::match_name("*.txt", "notes.txt"));
+        REQUIRE(dir_cache::match_name("*.*", "noext"));
+        REQUIRE(dir_cache::match_name("a*b*c", "axxbyyc"));
+        REQUIRE(dir_cache::match_name("abc", "abc"));
+        REQUIRE(dir_cache::match_name("?x", "\xc3\xa9x"));
+
+        REQUIRE(!dir_cache::match_name("abc", "abcd"));
+        REQUIRE(!dir_cache::match_name("a?c", "ac"));
+        REQUIRE(!dir_cache::match_name("*.txt", "notes.md"));
+        REQUIRE(!dir_cache::match_name("b*", "abc"));
+    }
+
+    SECTION("Listing")
+    {
+        fs_fixture fs;
+
+        dir_cache& cache = dir_cache::get();
+        cache.clear();
+
+        auto listing = wait_for_listing(fs.get_root());
+        REQUIRE(listing != nullptr);
+        REQUIRE(has_file(*listing, "file1"));
+        REQUIRE(has_file(*listing, "dir1"));
+        REQUIRE(!has_file(*listing, "only"));
+
+        for (const auto& file : listing->files)
+        {
+            if (strcmp(file.name, "dir1") == 0)
+                REQUIRE(file.attr & FILE_ATTRIBUTE_DIRECTORY);
+            else if (strcmp(file.name, "file1") == 0)
+                REQUIRE(!(file.attr & FILE_ATTRIBUTE_DIRECTORY));
+        }
+
+        // Adding a file changes the directory's write time, so the old
+        // listing is no longer used.
+        str<> added(fs.get_root());
+        path::append(added, "added");
+        FILE* f = fopen(added.c_str(), "wt");
+        REQUIRE(f != nullptr);
+        fclose(f);
+
+        listing = wait_for_listing(fs.get_root());
+        REQUIRE(listing != nullptr);
+        REQUIRE(has_file(*listing, "added"));
+
+        uint32 lookups, hits, scans;
+        cache.get_stats(lookups, hits, scans);
+        REQUIRE(hits >= 2);
+        REQUIRE(scans >= 2);
+
+        cache.clear();
+        REQUIRE(!cache.find(fs.get_root()));
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "env_fixture.h"
+#include "fs_fixture.h"
+
+#include <core/path.h>
+#include <core/str.h>
+#include <lib/exe_index.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Executable index")
+{
+    static const char* index_fs[] = {
+        "first/git.exe",
+        "first/tool.bat",
+        "first/tool.cmd",
+        "first/notes.txt",
+        "first/short.lnk",
+        "second/git.cmd",
+        "second/Other.EXE",
+        "second/tool.com",
+        nullptr,
+    };
+
+    fs_fixture fs(index_fs);
+
+    str<> first(fs.get_root());
+    path::append(first, "first");
+    str<> second(fs.get_root());
+    path::append(second, "second");
+
+    str<> path_var;
+    path_var << first.c_str() << ";" << second.c_str() << ";" << first.c_str();
+    const char* env_desc[] = {
+        "path",     path_var.c_str(),
+        "pathext",  ".COM;.EXE;.BAT;.CMD",
+        nullptr,
+    };
+    env_fixture env(env_desc);
+
+    exe_index& index = exe_index::get();
+    index.clear();
+
+    str<> out;
+    str<> expected;
+
+    SECTION("First directory wins")
+    {
+        REQUIRE(index.find("git", out) == 1);
+        path::join(first.c_str(), "git.exe", expected);
+        REQUIRE(out.iequals(expected.c_str()));
+
+        REQUIRE(index.find("git.cmd", out) == 1);
+        path::join(second.c_str(), "git.cmd", expected);
+        REQUIRE(out.iequals(expected.c_str()));
+    }
+
+    SECTION("PATHEXT order within a directory")
+    {
+        REQUIRE(index.find("TOOL", out) == 1);
+        path::join(first.c_str(), "tool.bat", expected);
+        REQUIRE(out.iequals(expected.c_str()));
+
+        REQUIRE(index.find("other", out) == 1);
+        path::join(second.c_str(), "Other.EXE", expected);
+        REQUIRE(out.iequals(expected.c_str()));
+    }
+
+    SECTION("Not found")
+    {
+        REQUIRE(index.find("nope", out) == 0);
+        REQUIRE(index.find("notes", out) == 0);
+        REQUIRE(index.find("short.lnk", out) == 1);
+    }
+
+    SECTION("Can't answer")
+    {
+        REQUIRE(index.find("notes.txt", out) == -1);
+        REQUIRE(index.find("first\\git", out) == -1);
+    }
+
+    SECTION("Enumerate")
+    {
+        std::vector<exe_index::executable> names;
+        index.get_executables(names);
+
+        REQUIRE(names.size() == 6);
+        REQUIRE(names[0].name.iequals("git.exe"));
+        REQUIRE(names[5].name.iequals("tool.com"));
+    }
+
+    SECTION("Scanned once")
+    {
+        uint32 lookups, hits, scans;
+        REQUIRE(index.find("git", out) == 1);
+        index.get_stats(lookups, hits, scans);
+        const uint32 scans_before = scans;
+        for (int32 i = 0; i < 100; ++i)
+            REQUIRE(index.find("nope", out) == 0);
+        index.get_stats(lookups, hits, scans);
+        REQUIRE(scans == scans_before);
+    }
+
+    index.clear();
+}
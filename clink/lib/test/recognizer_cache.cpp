@@ -0,0 +1,198 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "env_fixture.h"
+#include "fs_fixture.h"
+#include "recognizer_cache.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+static time_t s_fake_now = 0;
+static time_t fake_now() { return s_fake_now; }
+
+//------------------------------------------------------------------------------
+static void write_file(const char* name, const char* content)
+{
+    FILE* f = fopen(name, "wt");
+    REQUIRE(f);
+    fputs(content, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Recognizer cache")
+{
+    static const char* cache_fs[] = {
+        "bin/one.exe",
+        "bin/two.exe",
+        "bin/three.exe",
+        nullptr,
+    };
+
+    fs_fixture fs(cache_fs);
+
+    str<> bin(fs.get_root());
+    path::append(bin, "bin");
+    str<> one, two, three;
+    path::join(bin.c_str(), "one.exe", one);
+    path::join(bin.c_str(), "two.exe", two);
+    path::join(bin.c_str(), "three.exe", three);
+    str<> cache_file(fs.get_root());
+    path::append(cache_file, "recognizer_cache");
+
+    s_fake_now = 1000000;
+
+    str<> out;
+
+    SECTION("Keys")
+    {
+        str<> path_var(bin.c_str());
+        const char* env_desc[] = {
+            "path",     path_var.c_str(),
+            "pathext",  ".COM;.EXE;.BAT;.CMD",
+            nullptr,
+        };
+        env_fixture env(env_desc);
+
+        str<> key, other;
+
+        // Relative paths can't be saved.
+        REQUIRE(!recognizer_cache::make_key("bin\\one", fs.get_root(), key));
+        REQUIRE(!recognizer_cache::make_key("", fs.get_root(), key));
+
+        // Fully qualified paths don't depend on the current directory.
+        REQUIRE(recognizer_cache::make_key(one.c_str(), fs.get_root(), key));
+        REQUIRE(recognizer_cache::make_key(one.c_str(), bin.c_str(), other));
+        REQUIRE(key.equals(other.c_str()));
+
+        // Names are looked for in the current directory first.
+        REQUIRE(recognizer_cache::make_key("one", fs.get_root(), key));
+        REQUIRE(recognizer_cache::make_key("one", bin.c_str(), other));
+        REQUIRE(!key.equals(other.c_str()));
+
+        // Names are looked for in %PATH%.
+        REQUIRE(os::set_env("PATH", fs.get_root()));
+        REQUIRE(recognizer_cache::make_key("one", bin.c_str(), key));
+        REQUIRE(!key.equals(other.c_str()));
+    }
+
+    SECTION("Load")
+    {
+        str<> content;
+        content << "clink_recognizer_cache 2\n";
+        content << "one\t0\t*\t" << one.c_str() << "\t0\t1\n";
+        content << "bad\t0\t*\n";
+        content << "two\t0\tc:\\dir\t" << two.c_str() << "\t0\t1\n";
+        write_file(cache_file.c_str(), content.c_str());
+
+        recognizer_cache cache;
+        cache.set_file(cache_file.c_str());
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        REQUIRE(out.equals(one.c_str()));
+        REQUIRE(cache.lookup("two\t0\tc:\\dir", out));
+        REQUIRE(out.equals(two.c_str()));
+        REQUIRE(!cache.lookup("bad\t0\t*", out));
+        REQUIRE(!cache.lookup("two\t0\t*", out));
+
+        // Files from other versions are ignored.
+        write_file(cache_file.c_str(), "clink_recognizer_cache 1\none\tunused\t0\t1\n");
+        recognizer_cache old;
+        old.set_file(cache_file.c_str());
+        REQUIRE(!old.lookup("one", out));
+    }
+
+    SECTION("Save")
+    {
+        {
+            recognizer_cache cache;
+            cache.set_file(cache_file.c_str());
+            cache.update("one\t0\t*", one.c_str());
+            cache.update("two\t0\t*", two.c_str());
+            cache.remove("two\t0\t*");
+            cache.save();
+        }
+
+        recognizer_cache cache;
+        cache.set_file(cache_file.c_str());
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        REQUIRE(out.equals(one.c_str()));
+        REQUIRE(!cache.lookup("two\t0\t*", out));
+    }
+
+    SECTION("Save only changes")
+    {
+        recognizer_cache cache;
+        cache.set_clock(&fake_now);
+        cache.set_file(cache_file.c_str());
+        cache.update("one\t0\t*", one.c_str());
+        cache.save();
+        REQUIRE(os::get_path_type(cache_file.c_str()) == os::path_type_file);
+
+        // Using an entry or confirming it doesn't rewrite the file.
+        REQUIRE(os::unlink(cache_file.c_str()));
+        s_fake_now += 60;
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        cache.update("one\t0\t*", one.c_str());
+        cache.save();
+        REQUIRE(os::get_path_type(cache_file.c_str()) == os::path_type_invalid);
+
+        // Using an entry on a later day updates when it was last used.
+        s_fake_now += 60 * 60 * 24;
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        cache.save();
+        REQUIRE(os::get_path_type(cache_file.c_str()) == os::path_type_file);
+    }
+
+    SECTION("Least recently used")
+    {
+        const time_t day = 60 * 60 * 24;
+
+        {
+            recognizer_cache cache(2);
+            cache.set_clock(&fake_now);
+            cache.set_file(cache_file.c_str());
+            cache.update("one\t0\t*", one.c_str());
+            s_fake_now += day;
+            cache.update("two\t0\t*", two.c_str());
+            s_fake_now += day;
+            REQUIRE(cache.lookup("one\t0\t*", out));
+            s_fake_now += day;
+            cache.update("three\t0\t*", three.c_str());
+            cache.save();
+        }
+
+        recognizer_cache cache(2);
+        cache.set_file(cache_file.c_str());
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        REQUIRE(!cache.lookup("two\t0\t*", out));
+        REQUIRE(cache.lookup("three\t0\t*", out));
+    }
+
+    SECTION("Staleness")
+    {
+        recognizer_cache cache;
+        cache.set_file(cache_file.c_str());
+        cache.update("one\t0\t*", one.c_str());
+        REQUIRE(cache.is_fresh("one\t0\t*"));
+        REQUIRE(!cache.is_fresh("two\t0\t*"));
+
+        // Adding a file changes the directory's last write time.
+        str<> added;
+        path::join(bin.c_str(), "added.exe", added);
+        write_file(added.c_str(), "");
+        REQUIRE(!cache.is_fresh("one\t0\t*"));
+
+        // The entry is still available until the recognizer decides.
+        REQUIRE(cache.lookup("one\t0\t*", out));
+        cache.update("one\t0\t*", one.c_str());
+        REQUIRE(cache.is_fresh("one\t0\t*"));
+
+        // Deleting the file makes it stale as well.
+        REQUIRE(os::unlink(one.c_str()));
+        REQUIRE(!cache.is_fresh("one\t0\t*"));
+    }
+}
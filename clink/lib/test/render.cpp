@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "headless_terminal.h"
+#include "line_editor_tester.h"
+
+#include <core/str.h>
+#include <terminal/find_line.h>
+
+extern bool g_benchmarks;
+
+//------------------------------------------------------------------------------
+static uint64 get_thread_cpu_time()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return k.QuadPart + u.QuadPart; // 100ns units.
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Render through headless terminal")
+{
+    // Typing, cursor movement (^B, ^F, ^A, ^E), deletion (^H, ^W), and a line
+    // long enough to wrap.
+    static const struct {
+        const char* keys;
+        const char* expected;
+    } c_keystrokes[] =
+    {
+        { "echo hello world",
+          "> echo hello world" },
+        { "echo hello world\b\b\b\b\bthere",
+          "> echo hello there" },
+        { "dir /s /b \x02\x02\x02\x02x\x06\x06\x06y\x01z\x05",
+          "> zdir /sx /by" },
+        { "git log --oneline --graph --decorate --all --since=yesterday -- some/long/path/to/wrap\x17\x17more",
+          "> git log --oneline --graph --decorate --all --since=yesterday more" },
+    };
+
+    // Generous upper bounds on the average cost of each keystroke (including
+    // the initial prompt), to catch render paths that regress to redrawing
+    // the whole line.
+    static const uint32 c_max_bytes_per_key = 64;
+    static const uint32 c_max_escapes_per_key = 8;
+
+    for (const auto& test : c_keystrokes)
+    {
+        headless_terminal_out out(32, 10);
+        line_editor::desc desc(nullptr, nullptr, nullptr, nullptr);
+        desc.prompt = "> ";
+        line_editor_tester tester(desc, nullptr, nullptr, &out);
+        tester.set_input(test.keys);
+
+        out.reset_stats();
+        const uint64 cpu_begin = get_thread_cpu_time();
+        tester.run(true);
+        const uint64 cpu_elapsed = get_thread_cpu_time() - cpu_begin;
+
+        // The screen shows the prompt and the edited line, wrapped across as
+        // many rows as needed.
+        headless_screen_buffer& screen = out.get_screen();
+        const int32 row = screen.find_line(0, screen.get_rows(), desc.prompt, find_line_mode::none);
+        REQUIRE(row >= 0);
+
+        str<> shown;
+        str<> text;
+        for (int32 i = row; i < screen.get_rows() && screen.get_line_text(i, text) && !text.empty(); ++i)
+            shown.concat(text.c_str(), text.length());
+        REQUIRE(shown.equals(test.expected), [&] () {
+            printf("expected: %s\n     got: %s\n", test.expected, shown.c_str());
+        });
+
+        const render_stats& stats = out.get_stats();
+        const uint32 num_keys = uint32(strlen(test.keys));
+        REQUIRE(stats.writes > 0);
+        REQUIRE(stats.bytes <= num_keys * c_max_bytes_per_key);
+        REQUIRE(stats.escapes <= num_keys * c_max_escapes_per_key);
+
+        // Report the cost per keystroke when benchmarking.
+        if (g_benchmarks)
+        {
+            printf("render: %2u keys, %5u bytes, %4u escapes, %4u writes; per key %.1f bytes, %.1f escapes, %.1f us cpu\n",
+                   num_keys, stats.bytes, stats.escapes, stats.writes,
+                   double(stats.bytes) / num_keys, double(stats.escapes) / num_keys,
+                   double(cpu_elapsed) / 10 / num_keys);
+        }
+    }
+}
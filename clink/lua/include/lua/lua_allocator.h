@@ -0,0 +1,47 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+struct lua_alloc_stats
+{
+    size_t          small_in_use = 0;   // Requested bytes in pooled blocks.
+    size_t          small_capacity = 0; // Size class bytes in pooled blocks.
+    size_t          large_in_use = 0;   // Requested bytes in heap blocks.
+    size_t          chunk_bytes = 0;    // Bytes reserved by pool chunks.
+    uint32          chunks = 0;         // Chunks in use, including spares.
+    uint32          spare_chunks = 0;   // Empty chunks kept for reuse.
+    uint32          peak_chunks = 0;
+    uint64          allocs = 0;
+    uint64          frees = 0;
+    uint64          allocated = 0;      // Total bytes ever allocated.
+    uint64          allocated_line = 0; // Bytes allocated since the last trim.
+    uint64          freed = 0;          // Total bytes ever freed.
+    uint64          idle_freed = 0;     // Bytes freed by idle garbage collection.
+    double          idle_gc_time = 0;   // Seconds spent in idle garbage collection.
+    uint32          idle_gc_passes = 0;
+    uint32          idle_gc_cycles = 0; // Collection cycles finished at idle.
+};
+
+//------------------------------------------------------------------------------
+// Lua allocator that serves small blocks from size class pools, and larger
+// blocks from the heap.  Empty chunks are kept as spares while editing a line,
+// and trim_lua_allocator() releases them once the line is done.
+//
+// The pools and stats are global and not synchronized:  every Lua state that
+// uses lua_pool_alloc shares them, so every such Lua state must only ever be
+// used (including created and closed) on one and the same thread.  Clink only
+// runs Lua on the main thread; background threads must never call into Lua.
+//
+// When USE_MEMORY_TRACKING is defined, lua_pool_alloc() still counts stats but
+// passes blocks through to the debug heap so leak tracking sees them.
+// lua_pool_realloc() always uses the pools, and only updates the pool usage
+// stats; osize must be 0 when ptr is null.
+void* lua_pool_alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+void* lua_pool_realloc(void* ptr, size_t osize, size_t nsize);
+void trim_lua_allocator();
+void get_lua_alloc_stats(lua_alloc_stats& stats);
+void begin_lua_idle_gc();
+void end_lua_idle_gc(double elapsed, bool finished_cycle);
+void lua_allocator_diagnostics();
@@ -30,9 +30,14 @@ private:
     bool            is_enabled();
     bool            has_coroutines();
     void            resume_coroutines();
+    bool            is_gc_pending() const;
+    void            collect_garbage();
     lua_state&      m_state;
     uint32          m_iterations = 0;
     bool            m_enabled = true;
+    bool            m_gc_stepping = false;
+    uint64          m_gc_mark = 0;      // Allocation total when GC last finished.
+    uint64          m_gc_threshold;     // Allocations that start the next idle GC cycle.
 
     uint32          m_index_recognizer = -1;
     uint32          m_index_task_manager = -1;
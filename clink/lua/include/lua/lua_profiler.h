@@ -0,0 +1,119 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+struct lua_Debug;
+
+//------------------------------------------------------------------------------
+// Profiles Lua callbacks when the lua.profile setting is enabled.
+//
+//  - Callback dispatch sites in the Lua scripts bracket each callback with
+//    clink._profile_enter() and clink._profile_leave(), which measure the
+//    callback's total and self time and collect recent durations for
+//    percentiles.  The sites only make those calls while clink._profiling is
+//    set, so disabled profiling costs a table lookup per callback.
+//  - coroutine.resume() suspends the frames of a coroutine when it yields and
+//    restores them when it's resumed, so time spent suspended isn't counted.
+//  - While enabled, the Lua allocator attributes allocations and freed bytes
+//    (which is nearly all garbage collection work) to the innermost active
+//    callback.
+//  - While enabled, a count hook samples which source file is running every
+//    so many VM instructions, which also covers code outside of any callback.
+class lua_profiler
+{
+public:
+    static lua_profiler& get();
+
+                    lua_profiler();
+    bool            is_enabled() const;
+    bool            install(lua_State* L);
+    uint32          enter(lua_State* L, const char* category, int32 func_index);
+    void            leave(uint32 token);
+    uint32          resume(uint32 suspended);
+    uint32          suspend(uint32 depth, bool dead);
+    void            on_alloc(size_t osize, size_t nsize, bool had_ptr);
+
+    void            diagnostics();
+    bool            dump(const char* file);
+
+    // For tests.
+    void            set_enabled(bool enabled) { m_force_enabled = enabled; }
+    void            set_clock(double (*clock)()) { m_clock = clock; }
+    bool            get_counters(const char* category, uint32& calls, double& total, double& self) const;
+    uint32          get_depth() const { return uint32(m_stack.size()); }
+
+private:
+    enum { c_recent = 256 };
+
+    struct counters
+    {
+        uint32      calls = 0;
+        double      total = 0;          // Seconds, including nested callbacks.
+        double      self = 0;           // Seconds, excluding nested callbacks.
+        double      peak = 0;
+        uint64      allocs = 0;
+        uint64      alloc_bytes = 0;
+        uint64      freed_bytes = 0;
+        uint32      samples = 0;
+
+        void        add(const counters& other);
+    };
+
+    struct entry
+    {
+        str_moveable key;
+        str_moveable category;
+        str_moveable name;
+        str_moveable source;
+        counters    c;
+        float       recent[c_recent];   // Recent durations, in milliseconds.
+        uint32      num_recent = 0;
+        uint32      next_recent = 0;
+
+        void        percentiles(double& p50, double& p90, double& p99) const;
+    };
+
+    struct frame
+    {
+        entry*      e;
+        uint32      token;
+        double      start;              // Moves forward by time spent suspended.
+        double      children = 0;
+        double      credited = 0;       // Time already added to the parent's children.
+    };
+
+    struct suspended_frames
+    {
+        double      when;
+        std::vector<frame> frames;
+    };
+
+    static void     sample_hook(lua_State* L, lua_Debug* ar);
+    entry*          find_entry(lua_State* L, const char* category, int32 func_index);
+    void            close_frames(size_t keep, double now);
+    void            clear_frames();
+    double          now() const { return m_clock(); }
+    void            collect_sources(std::vector<std::pair<const char*, counters>>& out) const;
+
+    std::vector<std::unique_ptr<entry>> m_entries;
+    str_unordered_map<entry*> m_map;
+    str_unordered_map<uint32> m_samples;    // Keys are owned by m_sample_keys.
+    std::vector<std::unique_ptr<str_moveable>> m_sample_keys;
+    std::vector<frame> m_stack;
+    std::unordered_map<uint32, suspended_frames> m_suspended;
+    counters        m_unattributed;
+    uint32          m_total_samples = 0;
+    uint32          m_next_token = 0;
+    uint32          m_next_suspended = 0;
+    double          (*m_clock)();
+    bool            m_force_enabled = false;
+};
@@ -0,0 +1,15 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// Precompiled Lua scripts are cached on disk, keyed by the script's full path,
+// modification time, and size.  Loading a script whose cache entry is current
+// skips parsing and compiling it.  Caching is disabled until a directory is
+// set.
+void set_lua_script_cache_dir(const char* dir);
+int32 load_lua_file_cached(lua_State* L, const char* path);
+void get_lua_script_cache_stats(uint32& hits, uint32& misses);
@@ -8,6 +8,7 @@
 
 #include <functional>
 #include <list>
+#include <memory>
 
 extern "C" {
 #include <readline/readline.h>
@@ -16,6 +17,7 @@ extern "C" {
 
 struct lua_State;
 class str_base;
+class coroutine_scheduler;
 class line_state;
 class terminal_in;
 class terminal_out;
@@ -72,6 +74,7 @@ public:
     bool            do_string(const char* string, int32 length=-1, str_base* error=nullptr, const char* name=nullptr);
     bool            do_file(const char* path);
     lua_State*      get_state() const;
+    coroutine_scheduler* get_scheduler() const { return m_scheduler.get(); }
 
     static bool     push_named_function(lua_State* L, const char* func_name, str_base* error=nullptr);
 
@@ -112,6 +115,7 @@ public:
 private:
     static bool     send_event_internal(lua_State* L, const char* event_name, const char* event_mechanism, int32 nargs=0, int32 nret=0);
     lua_State*      m_state;
+    std::unique_ptr<coroutine_scheduler> m_scheduler;
 
     static bool     s_internal;
     static bool     s_interpreter;
@@ -29,6 +29,8 @@ setmetatable(_argmatcher, { __call = function (x, ...) return x._new(...) end })
 --------------------------------------------------------------------------------
 local _enable_hints
 local _delayinit_generation = 0
+local _argmatcher_revision = 0
+local _parse_memo = {}
 local _clear_onuse_coroutine = {}
 local _clear_delayinit_coroutine = {}
 
@@ -36,6 +38,7 @@ local _clear_delayinit_coroutine = {}
 clink.onbeginedit(function ()
     _enable_hints = settings.get("argmatcher.show_hints")
     _delayinit_generation = _delayinit_generation + 1
+    _parse_memo = {}
 
     -- Clear dangling coroutine references in matchers.  Otherwise if a
     -- coroutine doesn't finish before a new edit line begins, there will be
@@ -127,7 +130,9 @@ local function do_delayed_init(list, matcher, arg_index)
         c = coroutine.create(function ()
             -- Invoke the delayinit callback and add the results to the arg
             -- slot's list of matches.
+            local pt = clink._profiling and clink._profile_enter("delayinit", list.delayinit)
             local addees = list.delayinit(matcher, arg_index)
+            if pt then clink._profile_leave(pt) end
             matcher:_add(list, addees)
             -- Mark the init callback as finished.
             local mic = matcher._init_coroutine
@@ -202,7 +207,9 @@ local function do_onuse_callback(argmatcher, command_word)
     if not c then
         -- Run the delayinit callback in a coroutine so typing is responsive.
         c = coroutine.create(function ()
+            local pt = clink._profiling and clink._profile_enter("delayinit", argmatcher._delayinit_func)
             argmatcher._delayinit_func(argmatcher, command_word)
+            if pt then clink._profile_leave(pt) end
             argmatcher._onuse_coroutine = nil
             _clear_onuse_coroutine[argmatcher] = nil
             if async_delayinit then
@@ -322,7 +329,7 @@ local function break_slash(line_state, word_index, word_classifications)
     -- starting from a later word index.
     if not word_index then
         for i = 1, line_state:getwordcount() do
-            local info = line_state:getwordinfo(i)
+            local info = line_state:_getwordinfo_cached(i)
             if not info.redir then
                 if info.quoted then
                     return
@@ -415,7 +422,7 @@ function _argreader:push_line_state(extra, no_onalias)
             -- When stopping parsing, color the rest of the command as
             -- unexpected to reflect that it isn't being parsed.
             local ls = self._extra[1].line_state
-            local info = ls:getwordinfo(math.max(1, self._extra[1].word_index - 1))
+            local info = ls:_getwordinfo_cached(math.max(1, self._extra[1].word_index - 1))
             if info then
                 local offset = info.offset + info.length + (info.quoted and 1 or 0)
                 local length = ls:getrangelength() - math.max(0, offset - ls:getrangeoffset())
@@ -454,6 +461,10 @@ end
 
 --------------------------------------------------------------------------------
 function _argreader:next_word(always_last_word)
+    if self._memo == nil then
+        self:_resume()
+    end
+
 ::retry::
     if self._last_word then
         return
@@ -470,6 +481,10 @@ function _argreader:next_word(always_last_word)
         return
     end
 
+    if self._memo then
+        self:_checkpoint(word_index, word_count)
+    end
+
     self._word_index = word_index + 1
 
     if (not self._extra or self._stop_after) and word_index >= word_count then
@@ -477,7 +492,7 @@ function _argreader:next_word(always_last_word)
     end
 
     local last_word = self._last_word or false
-    local info = ls:getwordinfo(word_index)
+    local info = ls:_getwordinfo_cached(word_index)
     if info.redir and not always_last_word then
         goto retry
     end
@@ -487,13 +502,152 @@ function _argreader:next_word(always_last_word)
     return word, word_index, ls, last_word, info
 end
 
+--------------------------------------------------------------------------------
+-- Typing usually only changes the end of the line, so the reader checkpoints
+-- its state before each word, and a later parse of the same command resumes
+-- from the last word whose preceding text in the command is unchanged.  The
+-- checkpoints belong to the command at a particular offset in the line, so a
+-- different command with the same argmatcher (e.g. after "&") starts over.
+-- The generator, word break info, and command word lookup share the
+-- checkpoints.  The classifier and hinter need every word's side effects, so
+-- they always parse from the start.
+--
+-- Only the part of a parse before the first callback is checkpointed, since
+-- callbacks can have side effects or depend on state outside the line.
+function _argreader:_resume()
+    self._memo = false
+    if self._word_classifier or self._need_arginfo or self._extra or self._fromhistory_matcher then
+        return
+    end
+
+    local ls = self._line_state
+    local root = self._matcher
+    local line = ls:getline()
+    local shift = ls:_shift()
+    local offset = ls:getcommandoffset()
+    local translate = clink.translateslashes()
+
+    local memo = _parse_memo[root]
+    if not memo or
+            memo.revision ~= _argmatcher_revision or
+            memo.shift ~= shift or
+            memo.offset ~= offset or
+            memo.translate ~= translate then
+        memo = {
+            revision = _argmatcher_revision,
+            shift = shift,
+            offset = offset,
+            translate = translate,
+            checkpoints = {},
+        }
+        _parse_memo[root] = memo
+    else
+        local resume
+        for i = ls:getwordcount() - 1, self._word_index, -1 do
+            local cp = memo.checkpoints[i]
+            if cp and line:sub(offset, cp.len) == memo.line:sub(offset, cp.len) then
+                resume = i
+                break
+            end
+        end
+        for i in pairs(memo.checkpoints) do
+            if not resume or i > resume then
+                memo.checkpoints[i] = nil
+            end
+        end
+        if resume then
+            self:_restore(memo.checkpoints[resume])
+        end
+    end
+
+    memo.line = line
+    self._memo = memo
+end
+
+--------------------------------------------------------------------------------
+function _argreader:_checkpoint(word_index, word_count)
+    if self._impure or self._extra then
+        self._memo = false
+        return
+    end
+
+    -- Parsing the previous word peeks at this word, and at whether it's the
+    -- end word.  So the checkpoint depends on the text up to the next word,
+    -- and there's no checkpoint for the end word.
+    if word_index >= word_count then
+        return
+    end
+
+    local checkpoints = self._memo.checkpoints
+    if checkpoints[word_index] then
+        return
+    end
+
+    local info = self._line_state:_getwordinfo_cached(word_index + 1)
+    local stack = {}
+    for i, s in ipairs(self._stack) do
+        stack[i] = { table.unpack(s, 1, 6) }
+    end
+    checkpoints[word_index] = {
+        len = info.offset - (info.quoted and 1 or 0) - 1,
+        word_index = word_index,
+        matcher = self._matcher,
+        realmatcher = self._realmatcher,
+        arg_index = self._arg_index,
+        stack = stack,
+        user_data = self._user_data,
+        arginfo = self._arginfo,
+        noflags = self._noflags,
+        phantomposition = self._phantomposition,
+        disabled = self._disabled,
+    }
+end
+
+--------------------------------------------------------------------------------
+function _argreader:_restore(cp)
+    -- No callbacks ran before a checkpoint, so user data tables only contain
+    -- shared_user_data.  Make new ones (preserving which stack entries share
+    -- a table) since the parse that made the checkpoint may have modified
+    -- them after the checkpoint.
+    local shared_user_data = {}
+    local user_datas = {}
+    local function new_user_data(old)
+        if not old then
+            return old
+        end
+        local ud = user_datas[old]
+        if not ud then
+            ud = { shared_user_data=shared_user_data }
+            user_datas[old] = ud
+        end
+        return ud
+    end
+
+    local stack = {}
+    for i, s in ipairs(cp.stack) do
+        stack[i] = { s[1], s[2], s[3], s[4], new_user_data(s[5]), s[6] }
+    end
+
+    self._word_index = cp.word_index
+    self._matcher = cp.matcher
+    self._realmatcher = cp.realmatcher
+    self._arg_index = cp.arg_index
+    self._stack = stack
+    self._shared_user_data = shared_user_data
+    self._user_data = new_user_data(cp.user_data)
+    self._arginfo = cp.arginfo
+    self._noflags = cp.noflags
+    self._phantomposition = cp.phantomposition
+    self._disabled = cp.disabled
+end
+
 --------------------------------------------------------------------------------
 function _argreader:lookup_link(arg, arg_index, word, word_index, line_state)
     if word and arg then
         local link, forced
 
         if arg._links then
-            local info = line_state:getwordinfo(word_index)
+            local info = line_state:_getwordinfo_cached(word_index)
             if info then -- word_index may be -1 when expanding a doskey alias.
                 local pos = info.offset + info.length
                 if line_state:getline():sub(pos, pos) == "=" then
@@ -506,6 +660,7 @@ function _argreader:lookup_link(arg, arg_index, word, word_index, line_state)
         end
 
         if arg.onlink then
+            self._impure = true
             local override = arg.onlink(link, arg_index, word, word_index, line_state, self._user_data)
             if override == false then
                 link = nil
@@ -549,13 +704,14 @@ end
 --------------------------------------------------------------------------------
 function _argreader:start_chained_command(word_index, mode, expand_aliases)
     local line_state = self._line_state
+    self._impure = true
     mode = mode or "cmd"
     self._no_cmd = nil
     self._chain_command = true
     self._chain_command_expand_aliases = expand_aliases
     self._chain_command_mode = mode
     for i = word_index, line_state:getwordcount() do
-        local info = line_state:getwordinfo(i)
+        local info = line_state:_getwordinfo_cached(i)
         if not info.redir then
             if info.quoted then
                 if mode == "cmdquotes" then
@@ -654,8 +810,8 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
         local flagarg = self._matcher._flags._args[1]
         if not self:lookup_link(flagarg, 0, word, word_index, line_state) then
             -- Check if the next word is adjacent.
-            local thiswordinfo = line_state:getwordinfo(word_index)
-            local nextwordinfo = line_state:getwordinfo(word_index + 1)
+            local thiswordinfo = line_state:_getwordinfo_cached(word_index)
+            local nextwordinfo = line_state:_getwordinfo_cached(word_index + 1)
             if nextwordinfo then
                 local thisend = thiswordinfo.offset + thiswordinfo.length + (thiswordinfo.quoted and 1 or 0)
                 local nextbegin = nextwordinfo.offset - (nextwordinfo.quoted and 1 or 0)
@@ -686,6 +842,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
             local nowordbreakchars = arg.nowordbreakchars or default_flag_nowordbreakchars
             local adjusted, skip_word, len = line_state:_unbreak_word(word_index, nowordbreakchars)
             if adjusted then
+                self._impure = true
                 self._line_state = adjusted
                 line_state = adjusted
                 if self._word_classifier then
@@ -718,12 +875,14 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
             local arg = matcher._flags._args[1]
             if arg then
                 if arg.delayinit then
+                    self._impure = true
                     do_delayed_init(arg, matcher, 0)
                 end
                 if arg.onalias and
                         not last_onadvance and
                         not (self._extra and self._extra.no_onalias) and
                         self:has_more_words(word_index) then
+                    self._impure = true
                     local expanded, chain = arg.onalias(0, word, word_index, line_state, self._user_data)
                     if expanded then
                         local line_states = clink.parseline(expanded)
@@ -746,6 +905,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
                     end
                 end
                 if arg.onarg then
+                    self._impure = true
                     arg.onarg(0, word, word_index, line_state, self._user_data)
                 end
             end
@@ -778,9 +938,11 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
     local react, react_modes
     if arg and not is_flag then
         if arg.delayinit then
+            self._impure = true
             do_delayed_init(arg, realmatcher, arg_index)
         end
         if arg.onadvance then
+            self._impure = true
             if last_onadvance and self._match_builder then
                 -- If onadvance is encountered while parsing the end word then
                 -- it can influence which argmatcher and arg slot end up being
@@ -809,6 +971,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
                 not last_onadvance and
                 not (self._extra and self._extra.no_onalias) and
                 self:has_more_words(word_index) then
+            self._impure = true
             local expanded, chain = arg.onalias(arg_index, word, word_index, line_state, self._user_data)
             if expanded then
                 local line_states = clink.parseline(expanded)
@@ -844,8 +1007,8 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
     -- separates this word from the next, then don't advance to the next
     -- argument index.
     if not react and arg and arg.loopchars and arg.loopchars ~= "" and word_index < line_state:getwordcount() then
-        local thiswordinfo = line_state:getwordinfo(word_index)
-        local nextwordinfo = line_state:getwordinfo(word_index + 1)
+        local thiswordinfo = line_state:_getwordinfo_cached(word_index)
+        local nextwordinfo = line_state:_getwordinfo_cached(word_index + 1)
         local s = thiswordinfo.offset + thiswordinfo.length + (thiswordinfo.quoted and 1 or 0)
         local e = nextwordinfo.offset - 1 - (nextwordinfo.quoted and 1 or 0)
         if s == e then
@@ -928,6 +1091,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
 
     -- Run delayinit (is_flag runs it further above).
     if not is_flag and arg.delayinit then
+        self._impure = true
         do_delayed_init(arg, realmatcher, arg_index)
     end
 
@@ -954,6 +1118,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
     -- BEFORE onarg, otherwise for example onarg can change the current
     -- directory before classify_word has a chance to process the word.
     if not is_flag and arg.onarg then
+        self._impure = true
         arg.onarg(arg_index, word, word_index, line_state, self._user_data)
     end
 
@@ -961,7 +1126,8 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
     local linked, forced = self:lookup_link(arg, is_flag and 0 or arg_index, word, word_index, line_state)
     if linked then
         if not forced and is_flag and word:match("..[:=]$") then
-            local info = line_state:getwordinfo(word_index)
+            self._impure = true -- Depends on the cursor position.
+            local info = line_state:_getwordinfo_cached(word_index)
             if info and
                     line_state:getcursor() ~= info.offset + info.length and
                     line_state:getline():sub(info.offset + info.length, info.offset + info.length) == " " then
@@ -972,6 +1138,7 @@ function _argreader:update(word, word_index, last_onadvance) -- luacheck: no unu
         end
         if linked then
             if linked._delayinit_func then
+                self._impure = true
                 do_onuse_callback(linked, nil)
             end
             self:_push(linked)
@@ -1009,8 +1176,8 @@ function _argreader:classify_word(is_flag, arg_index, realmatcher, word, word_in
                     if arg._links and arg._links[word] then
                         t = arg_match_type
                     else
-                        local this_info = line_state:getwordinfo(word_index)
-                        local next_info = line_state:getwordinfo(word_index + 1)
+                        local this_info = line_state:_getwordinfo_cached(word_index)
+                        local next_info = line_state:_getwordinfo_cached(word_index + 1)
                         if this_info and next_info and this_info.offset + this_info.length == next_info.offset then
                             local combined_word = word..line_state:getword(word_index + 1)
                             for _, i in ipairs(arg) do
@@ -1028,7 +1195,7 @@ function _argreader:classify_word(is_flag, arg_index, realmatcher, word, word_in
                 end
             end
             if not matched then
-                local this_info = line_state:getwordinfo(word_index)
+                local this_info = line_state:_getwordinfo_cached(word_index)
                 local pos = this_info.offset + this_info.length
                 local line = line_state:getline()
                 if line:sub(pos, pos) == "=" then
@@ -1282,6 +1449,7 @@ end
 
 --------------------------------------------------------------------------------
 function _argmatcher:setcmdcommand()
+    _argmatcher_revision = _argmatcher_revision + 1
     self._cmd_command = true
     return self
 end
@@ -1299,6 +1467,7 @@ function _argmatcher:reset()
     if self._is_flag_matcher then
         error("Cannot reset a flag matcher (it is internal and not exposed)")
     end
+    _argmatcher_revision = _argmatcher_revision + 1
     self._args = {}
     self._flags = nil
     self._flagprefix = {}
@@ -1472,6 +1641,7 @@ end
 --- -show:  :addarg("two", "dos")       -- third arg can be two or dos
 --- -show:  :loop(2)    -- fourth arg loops back to position 2, for one or uno, and so on
 function _argmatcher:loop(index)
+    _argmatcher_revision = _argmatcher_revision + 1
     self._loop = index or -1
     return self
 end
@@ -1505,6 +1675,7 @@ end
 --- -show:  :addflags(make_flags)   -- Only a function is added, so flag prefix characters cannot be determined automatically.
 --- -show:  :setflagprefix('-')     -- Force '-' to be considered as a flag prefix character.
 function _argmatcher:setflagprefix(...)
+    _argmatcher_revision = _argmatcher_revision + 1
     for _, i in ipairs({...}) do
         if type(i) ~= "string" or #i ~= 1 then
             error("Flag prefixes must be single character strings", 2)
@@ -1525,6 +1696,7 @@ end
 --- until an argument is encountered.  Otherwise they are recognized anywhere
 --- (which is the default).
 function _argmatcher:setflagsanywhere(anywhere)
+    _argmatcher_revision = _argmatcher_revision + 1
     if anywhere then
         self._flagsanywhere = true
     else
@@ -1543,6 +1715,7 @@ end
 --- true or nil, then "<code>--</code>" is used as the end of flags string.
 --- Otherwise, the end of flags string is cleared.
 function _argmatcher:setendofflags(endofflags)
+    _argmatcher_revision = _argmatcher_revision + 1
     if endofflags == true or endofflags == nil then
         endofflags = "--"
     elseif type(endofflags) ~= "string" then
@@ -1655,6 +1828,7 @@ end
 --- generators</a>.  You can use it to "dead end" a parser and suggest no
 --- completions.
 function _argmatcher:nofiles()
+    _argmatcher_revision = _argmatcher_revision + 1
     self._no_file_generation = true
     return self
 end
@@ -1720,6 +1894,7 @@ end
 --- gets executed.  It only affects how the argmatcher performs completions
 --- and input line coloring, to help the argmatcher be accurate.
 function _argmatcher:chaincommand(modes)
+    _argmatcher_revision = _argmatcher_revision + 1
     modes = modes or ""
     self._chain_command = true
     self._chain_command_mode = "cmd"
@@ -1751,6 +1926,7 @@ end
 --- <a href="#adaptive-argmatchers">Adaptive Argmatchers</a> for more
 --- information.
 function _argmatcher:setdelayinit(func)
+    _argmatcher_revision = _argmatcher_revision + 1
     self._delayinit_func = func
     return self
 end
@@ -1862,6 +2038,7 @@ local function merge_parsers(lhs, rhs)
     if lhs == rhs then
         return
     end
+    _argmatcher_revision = _argmatcher_revision + 1
 
     -- Keep track of the merge sources.
     add_merge_source(lhs, rhs._srccreated)
@@ -1940,6 +2117,7 @@ end
 
 --------------------------------------------------------------------------------
 function _argmatcher:_add(list, addee, prefixes)
+    _argmatcher_revision = _argmatcher_revision + 1
     -- If addee is a flag like --foo= and is not linked, then link it to a
     -- default parser so its argument doesn't get confused as an arg for its
     -- parent argmatcher.
@@ -1984,6 +2162,7 @@ end
 
 --------------------------------------------------------------------------------
 function _argmatcher:_hide(list, addee)
+    _argmatcher_revision = _argmatcher_revision + 1
     -- Flatten out tables unless the table is a link
     local is_link = (getmetatable(addee) == _arglink)
     if type(addee) == "table" and not is_link and not addee.match then
@@ -2006,6 +2185,12 @@ function _argmatcher:_hide(list, addee)
     end
 end
 
+--------------------------------------------------------------------------------
+-- Maps the built in file and directory match functions to equivalents that
+-- stream the matches straight into a match builder, without building a table
+-- of tables first.  Filled in after the functions are defined.
+local native_match_funcs = {}
+
 --------------------------------------------------------------------------------
 --- -ret:   stop:bool;      When true, stop generating.
 --- -ret:   chain:bool;     When true, chain start a new command.
@@ -2059,7 +2244,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
     local hidden
 
     word_index = line_state:getwordcount()
-    local info = line_state:getwordinfo(word_index)
+    local info = line_state:_getwordinfo_cached(word_index)
     if clink.co_state.use_old_filtering then
         word = line_state:getline():sub(info.offset, line_state:getcursor() - 1)
     else
@@ -2114,13 +2299,18 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
         for _, i in ipairs(arg) do
             local t = type(i)
             if t == "function" then
-                local j = i(word, word_index, line_state, match_builder, reader._user_data)
-                if type(j) ~= "table" then
-                    return j or false
-                end
+                local native = native_match_funcs[i]
+                if native then
+                    native(match_builder, word)
+                else
+                    local j = i(word, word_index, line_state, match_builder, reader._user_data)
+                    if type(j) ~= "table" then
+                        return j or false
+                    end
 
-                apply_options_to_builder(reader, j, match_builder)
-                match_builder:addmatches(j, match_type)
+                    apply_options_to_builder(reader, j, match_builder)
+                    match_builder:addmatches(j, match_type)
+                end
             elseif t == "string" or t == "number" then
                 i = tostring(i)
                 if not hidden or not hidden[i] then
@@ -2156,7 +2346,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
     if info.redir then
         -- The word is an argument to a redirection symbol, so generate file
         -- matches.
-        match_builder:addmatches(clink.filematches(line_state:getendword()))
+        clink._add_file_matches(match_builder, line_state:getendword())
         return true
     elseif not reader._noflags and matcher._flags and matcher:_is_flag(line_state:getendword()) then
         -- Flags are always "arg" type, which helps differentiate them from
@@ -2168,7 +2358,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
     elseif reader._phantomposition then
         -- Generate file matches for phantom positions, i.e. any flag ending
         -- with : or = that does not explicitly link to another matcher.
-        match_builder:addmatches(clink.filematches(line_state:getendword()))
+        clink._add_file_matches(match_builder, line_state:getendword())
         return true
     else
         -- Generate matches for the argument position.
@@ -2410,7 +2600,25 @@ function clink.argmatcher(...)
 end
 
 --------------------------------------------------------------------------------
-local function dir_matches_impl(match_word, exact)
+-- When a builder is given, the matches are streamed into it natively instead
+-- of being collected into a table of tables.
+local function add_matches_to_builder(builder, pattern, root, dirs, flags)
+    local c, ismain = coroutine.running()
+    if not ismain and clink._is_coroutine_canceled(c) then
+        return
+    end
+    local stream = clink._file_matches(pattern, root, dirs, flags.hidden, flags.system)
+    while stream:addto(builder, not ismain) do
+        coroutine.yield()
+        if clink._is_coroutine_canceled(c) then
+            stream:close()
+            break
+        end
+    end
+end
+
+--------------------------------------------------------------------------------
+local function dir_matches_impl(match_word, exact, builder)
     local word, expanded = rl.expandtilde(match_word or "")
     local hidden = settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files")
 
@@ -2420,6 +2628,10 @@ local function dir_matches_impl(match_word, exact)
         for share, special in os.enumshares(server, hidden) do
             table.insert(matches, { match = string.format("\\\\%s\\%s\\", server, share), type = special and "dir,hidden" or "dir" })
         end
+        if builder then
+            builder:addmatches(matches)
+            return
+        end
         return matches
     end
 
@@ -2435,6 +2647,11 @@ local function dir_matches_impl(match_word, exact)
         system=settings.get("files.system"),
     }
 
+    if builder then
+        add_matches_to_builder(builder, word..(exact and "" or "*"), root, true, flags)
+        return
+    end
+
     local matches = {}
     for _, i in ipairs(os.globdirs(word..(exact and "" or "*"), true, flags)) do
         local m = path.join(root, i.name)
@@ -2447,7 +2664,7 @@ local function dir_matches_impl(match_word, exact)
 end
 
 --------------------------------------------------------------------------------
-local function file_matches_impl(match_word, exact)
+local function file_matches_impl(match_word, exact, builder)
     local word, expanded = rl.expandtilde(match_word or "")
     local hidden = settings.get("files.hidden") and rl.isvariabletrue("match-hidden-files")
 
@@ -2457,6 +2674,10 @@ local function file_matches_impl(match_word, exact)
         for share, special in os.enumshares(server, hidden) do
             table.insert(matches, { match = string.format("\\\\%s\\%s\\", server, share), type = special and "dir,hidden" or "dir" })
         end
+        if builder then
+            builder:addmatches(matches)
+            return
+        end
         return matches
     end
 
@@ -2476,6 +2697,11 @@ local function file_matches_impl(match_word, exact)
         system=settings.get("files.system"),
     }
 
+    if builder then
+        add_matches_to_builder(builder, word..(exact and "" or "*"), root, false, flags)
+        return
+    end
+
     local matches = {}
     for _, i in ipairs(os.globfiles(word..(exact and "" or "*"), true, flags)) do
         local m = path.join(root, i.name)
@@ -2558,6 +2784,21 @@ function clink.filematchesexact(match_word)
     return file_matches_impl(match_word, true)
 end
 
+--------------------------------------------------------------------------------
+function clink._add_dir_matches(match_builder, match_word, exact)
+    dir_matches_impl(match_word, exact, match_builder)
+end
+
+--------------------------------------------------------------------------------
+function clink._add_file_matches(match_builder, match_word, exact)
+    file_matches_impl(match_word, exact, match_builder)
+end
+
+native_match_funcs[clink.dirmatches] = function(builder, word) dir_matches_impl(word, false, builder) end
+native_match_funcs[clink.dirmatchesexact] = function(builder, word) dir_matches_impl(word, true, builder) end
+native_match_funcs[clink.filematches] = function(builder, word) file_matches_impl(word, false, builder) end
+native_match_funcs[clink.filematchesexact] = function(builder, word) file_matches_impl(word, true, builder) end
+
 
 
 --------------------------------------------------------------------------------
@@ -2679,23 +2920,19 @@ local function attempt_load_argmatcher(command_word, quoted, no_cmd)
     local loaded = {}
     for _,d in ipairs(dirs) do
         if d ~= "" then
-            local file = path.join(d, primary)
-            if not os.isfile(file) then
-                if not secondary then
-                    file = nil
-                else
-                    file = path.join(d, secondary)
-                    if not os.isfile(file) then
-                        file = nil
-                    end
-                end
+            -- The index avoids probing the file system in each directory.
+            local file
+            if clink._completion_script_exists(d, primary) then
+                file = path.join(d, primary)
+            elseif secondary and clink._completion_script_exists(d, secondary) then
+                file = path.join(d, secondary)
             end
             if file and not loaded[file] then
                 loaded[file] = true
                 loaded_argmatchers[command_word] = 2 -- Attempted and Loaded.
                 -- Load the file.
                 local impl = function ()
-                    local func, message = loadfile(file)
+                    local func, message = clink._loadfile(file)
                     if not func then
                         error(message)
                     end
@@ -2818,7 +3055,7 @@ local function _find_argmatcher(line_state, check_existence, lookup, no_cmd, has
 
     command_word = clink.lower(command_word:gsub("/", "\\"))
 
-    local info = not lookup and line_state:getwordinfo(command_word_index)
+    local info = not lookup and line_state:_getwordinfo_cached(command_word_index)
     if command_word_index == 1 and not lookup and info then
         if info.alias then
             local alias = os.getalias(line_state:getline():sub(info.offset, info.offset + info.length - 1))
@@ -2838,7 +3075,7 @@ local function _find_argmatcher(line_state, check_existence, lookup, no_cmd, has
                 if extra then
                     local els = extra.line_state
                     local ecwi = els:getcommandwordindex()
-                    local einfo = els:getwordinfo(ecwi)
+                    local einfo = els:_getwordinfo_cached(ecwi)
                     local eword = els:getword(ecwi)
                     local argmatcher = _has_argmatcher(eword, einfo and einfo.quoted, no_cmd)
                     if argmatcher then
@@ -3125,7 +3362,7 @@ function argmatcher_generator:getwordbreakinfo(line_state) -- luacheck: no self
                 -- the text before the break point, keeping only the text after
                 -- the break point as a word.
                 if (reader._chain_command_mode or argmatcher._chain_command_mode) == "cmd" then
-                    local info = line_state:getwordinfo(line_state:getwordcount())
+                    local info = line_state:_getwordinfo_cached(line_state:getwordcount())
                     if not info.quoted then
                         return 1, info.length - 1, true
                     end
@@ -3151,7 +3388,7 @@ function argmatcher_classifier:classify(commands) -- luacheck: no self
         local command_word_index = line_state:getcommandwordindex()
         lookup = nil -- luacheck: ignore 311
 
-        local info = line_state:getwordinfo(command_word_index)
+        local info = line_state:_getwordinfo_cached(command_word_index)
         if info then
             local command_word = line_state:getword(command_word_index) or ""
             local cw, sanitized = sanitize_command_word(command_word, info.quoted)
@@ -3171,7 +3408,7 @@ function argmatcher_classifier:classify(commands) -- luacheck: no self
                 elseif unrecognized_color or executable_color then
                     local cl
                     local line = line_state:getline()
-                    local recognized = clink._recognize_command(line, cw, info.quoted)
+                    local recognized = clink._recognize_command(line, cw, info.quoted, info.offset)
                     if recognized < 0 then
                         cl = unrecognized_color and "u" or "o"      --unrecognized
                     elseif recognized > 0 then
@@ -3321,7 +3558,7 @@ function argmatcher_hinter:gethint(line_state) -- luacheck: no self
             -- Handle cases where cursor is in the last word.
             if last_word then
                 -- Refer to tests for "Chaincommand input hints".
-                local endinfo = line_state:getwordinfo(word_index)
+                local endinfo = line_state:_getwordinfo_cached(word_index)
                 if endinfo then
                     local nextposafterendword = endinfo.offset + endinfo.length
                     if chained and endinfo.length == 0 then
@@ -3366,7 +3603,7 @@ function argmatcher_hinter:gethint(line_state) -- luacheck: no self
                     arg_index = reader._arg_index
                 end
 
-                local info = line_state:getwordinfo(word_index)
+                local info = line_state:_getwordinfo_cached(word_index)
                 if not info then
                     break
                 elseif cursorpos < info.offset then
@@ -3563,6 +3800,11 @@ function clink._diag_completions_dirs(arg)
     clink.print("", "commands searched:", attempted)
     clink.print("", "Lua scripts loaded:", loaded)
     clink.print("", "argmatchers loaded:", found)
+
+    local lookups, hits, scans = clink._get_completion_index_stats()
+    clink.print("", "index lookups:", lookups)
+    clink.print("", "index hits:", hits)
+    clink.print("", "directory scans:", scans)
 end
 
 
@@ -80,7 +80,9 @@ function clink._classify(commands)
             if classifier.classify then
                 reset_commands(commands)
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter("classifier", classifier.classify)
                 local ret = classifier:classify(commands)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, classifier)
                 if ret == true then
                     -- Remember the classifier function that stopped.
@@ -6,8 +6,11 @@
 --------------------------------------------------------------------------------
 clink = clink or {}
 local _coroutines = {}
+local _coroutine_ids = {}               -- Map from scheduler id to coroutine.
+local _next_coroutine_id = 0            -- Last scheduler id assigned.
+local _waiting = {}                     -- Coroutines waiting for a yieldguard, asyncyield, or queue.
+local _old_generation = {}              -- Coroutines kept from previous generations until their yieldguard is ready.
 local _after_coroutines = {}            -- Funcs to run after a pass resuming coroutines.
-local _coroutines_resumable = false     -- When false, coroutines will no longer run.
 local _coroutine_yieldguard = {}        -- Which coroutine is yielding inside popenyield, for a given category of coroutines.
 local _coroutine_context = nil          -- Context for queuing io.popenyield calls from a same source.
 local _coroutine_generation = 0         -- ID for current generation of coroutines.
@@ -27,6 +30,7 @@ local print = clink.print
 --
 --  Initialized by coroutine.create:
 --      coroutine:      The coroutine.
+--      id:             The id by which the native scheduler knows the coroutine.
 --      func:           The function the coroutine runs.
 --      interval:       Interval at which to schedule the coroutine.
 --      resumed:        How many times the coroutine has been resumed.
@@ -47,6 +51,16 @@ local print = clink.print
 --      queued:         Use INFINITE wait for this coroutine; it's queued inside popenyield.
 --      yieldguard:     Yielding due to io.popen, os.execute, etc.
 --      asyncyield:     Yielding due to an async_lua_task.
+--      target:         The os.clock() when the coroutine is next due, or nil while waiting.
+--
+-- The native scheduler (clink._schedule_coroutine, etc) keeps the target times
+-- in a heap, so idle processing only visits coroutines that are due.
+-- Coroutines that are waiting have no target time; they're kept in _waiting
+-- and checked whenever a pass runs, which happens when an event wakes idle
+-- processing (e.g. a yieldguard or asyncyield becoming ready).
+
+--------------------------------------------------------------------------------
+local schedule_entry
 
 --------------------------------------------------------------------------------
 local function clear_coroutines()
@@ -64,8 +78,11 @@ local function clear_coroutines()
     end
 
     _coroutines = {}
+    _coroutine_ids = {}
+    _waiting = {}
+    _old_generation = {}
     _after_coroutines = {}
-    _coroutines_resumable = false
+    clink._clear_coroutine_schedule()
     -- Don't touch _coroutine_yieldguard; it only gets cleared when the thread finishes.
     _coroutine_context = nil
     _coroutine_generation = _coroutine_generation + 1
@@ -80,7 +97,13 @@ local function clear_coroutines()
 
     for _, entry in ipairs(preserve) do
         _coroutines[entry.coroutine] = entry
-        _coroutines_resumable = true
+        _coroutine_ids[entry.id] = entry.coroutine
+        if not entry.untilcomplete then
+            _old_generation[entry.coroutine] = entry
+        end
+    end
+    for _, entry in pairs(_coroutines) do
+        schedule_entry(entry)
     end
 end
 clink.onbeginedit(clear_coroutines)
@@ -95,14 +118,8 @@ local function release_coroutine_yieldguard()
                 entry.throttleclock = os.clock()
                 entry.yieldguard = nil
                 table.insert(nil_cats, category)
-                -- TODO: This is an arbitrary order, but the dequeue order
-                -- should ideally be FIFO.
-                for _,e in pairs(_coroutines) do
-                    if e.queued and e.category == category then
-                        e.queued = nil
-                        break
-                    end
-                end
+                -- Coroutines queued behind this category stop waiting once
+                -- the category is released; see is_waiting().
             end
         end
     end
@@ -215,49 +232,63 @@ local function next_entry_target(entry, now)
 end
 
 --------------------------------------------------------------------------------
-function clink._after_coroutines(func)
-    if type(func) ~= "function" then
-        error("bad argument #1 (function expected)")
+local function is_waiting(entry)
+    if entry.queued and _coroutine_yieldguard[entry.yield_category] then
+        return true
+    elseif entry.yieldguard and not entry.yieldguard:ready() then
+        return true
+    elseif entry.asyncyield and not entry.asyncyield:ready() then
+        return true
     end
-    _after_coroutines[func] = func      -- Prevent duplicates.
 end
 
 --------------------------------------------------------------------------------
-function clink._has_coroutines()
-    return _coroutines_resumable
+-- Tells the native scheduler when the coroutine is next due, or that it's
+-- waiting for something else to make it ready.
+function schedule_entry(entry, now)
+    if is_waiting(entry) then
+        _waiting[entry.coroutine] = entry
+        entry.target = nil
+        clink._wait_coroutine(entry.id)
+    else
+        _waiting[entry.coroutine] = nil
+        entry.target = next_entry_target(entry, now or os.clock())
+        clink._schedule_coroutine(entry.id, entry.target)
+    end
 end
 
 --------------------------------------------------------------------------------
-function clink._wait_duration()
-    if _coroutines_resumable then
-        local target
-        local now = os.clock()
-        release_coroutine_yieldguard()  -- Dequeue next if necessary.
-        for _,entry in pairs(_coroutines) do
-            local this_target = next_entry_target(entry, now)
-            if entry.yieldguard or entry.queued then -- luacheck: ignore 542
-                -- Yield until output is ready; don't influence the timeout.
-            elseif entry.asyncyield and
-                    not entry.asyncyield:ready() and
-                    (not entry.asyncyield:getexpiration() or
-                     entry.asyncyield:getexpiration() > now) then -- luacheck: ignore 542
-                -- Don't resume until asyncyield says it's ready; don't
-                -- influence the timeout.
-            elseif not target or target > this_target then
-                target = this_target
-            end
-        end
-        if target then
-            return target - now
-        end
+function clink._after_coroutines(func)
+    if type(func) ~= "function" then
+        error("bad argument #1 (function expected)")
     end
+    _after_coroutines[func] = func      -- Prevent duplicates.
 end
 
+-- clink._has_coroutines() and clink._wait_duration() are implemented natively,
+-- by the scheduler.
+
 --------------------------------------------------------------------------------
 function clink._set_coroutine_context(context)
     _coroutine_context = context
 end
 
+--------------------------------------------------------------------------------
+-- UNDOCUMENTED; internal use only.
+-- Returns whether the running coroutine may yield while waiting for background
+-- work.  Otherwise it should wait synchronously, like the main coroutine.
+function clink._can_coroutine_async()
+    local c, ismain = coroutine.running()
+    if ismain then
+        return false
+    end
+    -- Prompt coroutines may not run async under certain conditions.
+    if is_prompt_coroutine(c) then
+        return settings.get("prompt.async") and not clink.istransientpromptfilter() or false
+    end
+    return true
+end
+
 --------------------------------------------------------------------------------
 function clink._set_coroutine_asyncyield(asyncyield)
     local t = coroutine.running()
@@ -270,70 +301,94 @@ end
 --------------------------------------------------------------------------------
 local _coroutines_fallback_state = {}
 function clink._resume_coroutines()
-    if not _coroutines_resumable then
+    if not clink._has_coroutines() then
         return
     end
 
     local remove
 
     -- Prepare.
-    _coroutines_resumable = false
-    _coroutines_fallback_state = {}
+    if next(_coroutines_fallback_state) then
+        _coroutines_fallback_state = {}
+    end
     clink._set_coroutine_context(nil)
 
     -- Remove dead/obsolete coroutines.  Must remove old gen coroutines first,
     -- since removing them may free up new gen coroutines to be resumable.
-    remove = {}
-    for c,entry in pairs(_coroutines) do
+    for c,entry in pairs(_old_generation) do
         if coroutine.status(c) == "dead" then
-            table.insert(remove, c)
-        elseif not check_generation(c) and (not entry.yieldguard or entry.yieldguard:ready()) then
+            clink.removecoroutine(c)
+        elseif not entry.yieldguard or entry.yieldguard:ready() then
             entry.canceled = true
-            table.insert(remove, c)
+            clink.removecoroutine(c)
         end
     end
-    for _,c in ipairs(remove) do
-        clink.removecoroutine(c)
+
+    -- Dequeue next if necessary, and schedule coroutines that are no longer
+    -- waiting.
+    release_coroutine_yieldguard()
+    local now = os.clock()
+    for _,entry in pairs(_waiting) do
+        if not is_waiting(entry) then
+            schedule_entry(entry, now)
+        end
     end
 
-    -- Protected call to resume coroutines.
+    -- Protected call to resume coroutines that are due.
     local co
-    remove = {}
+    local due = clink._take_due_coroutines()
+    local index = 0
     local impl = function()
-        for c,entry in pairs(_coroutines) do
-            co = c
-            _coroutines_resumable = true
-            local now = os.clock()
-            if next_entry_target(entry, now) <= now and
-                    (not entry.asyncyield or entry.asyncyield:ready()) then
-                if not entry.firstclock then
-                    entry.firstclock = now
-                end
-                if entry.asyncyield then
-                    entry.throttleclock = now
-                end
-                entry.resumed = entry.resumed + 1
-                clink._set_coroutine_context(entry.context)
-                local ok, ret
-                if entry.isprompt or entry.isgenerator then
-                    ok, ret = coroutine.resume(c, true--[[async]])
-                else
-                    ok, ret = coroutine.resume(c)
-                end
-                if ok then
-                    -- Use live clock so the interval excludes the execution
-                    -- time of the coroutine.
-                    entry.lastclock = os.clock()
-                else
-                    if not entry.canceled then
-                        print("")
-                        print("coroutine failed:")
-                        _co_error_handler(c, ret)
-                        entry.error = ret
-                    end
-                end
+        while index < #due do
+            index = index + 1
+            local c = _coroutine_ids[due[index]]
+            local entry = c and _coroutines[c]
+            if entry then
+                co = c
+                now = os.clock()
                 if coroutine.status(c) == "dead" then
+                    remove = remove or {}
                     table.insert(remove, c)
+                elseif is_waiting(entry) or next_entry_target(entry, now) > now then
+                    -- Throttling may have moved the target since it was
+                    -- scheduled, or it started waiting without being resumed
+                    -- by the scheduler.
+                    schedule_entry(entry, now)
+                else
+                    if not entry.firstclock then
+                        entry.firstclock = now
+                    end
+                    if entry.asyncyield then
+                        entry.throttleclock = now
+                    end
+                    entry.resumed = entry.resumed + 1
+                    clink._set_coroutine_context(entry.context)
+                    local ok, ret
+                    local pt = clink._profiling and clink._profile_enter("coroutine", entry.func)
+                    if entry.isprompt or entry.isgenerator then
+                        ok, ret = coroutine.resume(c, true--[[async]])
+                    else
+                        ok, ret = coroutine.resume(c)
+                    end
+                    if pt then clink._profile_leave(pt) end
+                    if ok then
+                        -- Use live clock so the interval excludes the execution
+                        -- time of the coroutine.
+                        entry.lastclock = os.clock()
+                    else
+                        if not entry.canceled then
+                            print("")
+                            print("coroutine failed:")
+                            _co_error_handler(c, ret)
+                            entry.error = ret
+                        end
+                    end
+                    if coroutine.status(c) == "dead" then
+                        remove = remove or {}
+                        table.insert(remove, c)
+                    elseif _coroutines[c] == entry then
+                        schedule_entry(entry)
+                    end
                 end
             end
         end
@@ -349,10 +404,25 @@ function clink._resume_coroutines()
     end
 
     -- Cleanup.
-    _coroutines_fallback_state = {}
+    if next(_coroutines_fallback_state) then
+        _coroutines_fallback_state = {}
+    end
     clink._set_coroutine_context(nil)
-    for _,c in ipairs(remove) do
-        clink.removecoroutine(c)
+    if remove then
+        for _,c in ipairs(remove) do
+            clink.removecoroutine(c)
+        end
+    end
+    if not ok then
+        -- Reschedule what was taken from the scheduler but not yet handled,
+        -- including the coroutine that failed.
+        for i = index, #due, 1 do
+            local c = _coroutine_ids[due[i]]
+            local entry = c and _coroutines[c]
+            if entry and coroutine.status(c) ~= "dead" then
+                schedule_entry(entry)
+            end
+        end
     end
     if _dead and #_dead > 20 then
         -- Trim the dead list to 20 entries.
@@ -547,9 +617,12 @@ function clink._diag_coroutines()
             end
             local res = "resumed "..str_rpad(t.resumed, max_resumed_len)
             local freq = "freq "..str_rpad(t.freq, max_freq_len)
-            -- TODO: Show next wakeup time.
+            local due = ""
+            if t.entry.target and not t.entry.status then
+                due = string.format("due %+.3f  ", t.entry.target - now)
+            end
             local src = tostring(t.entry.src)
-            print(plain.."  "..key.."  "..gen..status..res.."  "..freq.."  "..src..norm)
+            print(plain.."  "..key.."  "..gen..status..res.."  "..freq.."  "..due..src..norm)
             if t.entry.error then
                 print(plain.."  "..str_rpad("", #key + 2)..red..t.entry.error..norm)
             end
@@ -558,6 +631,7 @@ function clink._diag_coroutines()
 
     local threads = {}
     local deadthreads = {}
+    local now = os.clock()
 
     collect_diag(_coroutines, threads)
     if _dead then
@@ -566,12 +640,12 @@ function clink._diag_coroutines()
 
     -- Only list coroutines if there are any, or if there's unfinished state.
     local any_cyg = next(_coroutine_yieldguard) and true or false
-    if table_has_elements(threads) or _coroutines_resumable or any_cyg then
+    if table_has_elements(threads) or clink._has_coroutines() or any_cyg then
         clink.print(bold.."coroutines:"..norm)
         if show_gen then
             print("  generation", (mixed_gen and yellow or norm).."gen ".._coroutine_generation..norm)
         end
-        print("  resumable", _coroutines_resumable)
+        print("  resumable", clink._has_coroutines())
         print("  wait_duration", clink._wait_duration())
         for category, cyg in spairs(_coroutine_yieldguard) do
             local yg = cyg.yieldguard
@@ -681,8 +755,12 @@ function clink.addcoroutine(c, interval)
     end
 
     -- Change the interval for a coroutine.
-    if _coroutines[c] and not _coroutines[c].throttled then
-        _coroutines[c].interval = interval
+    local entry = _coroutines[c]
+    if entry and not entry.throttled then
+        entry.interval = interval
+        if entry.target then
+            schedule_entry(entry)
+        end
     end
 end
 
@@ -690,8 +768,8 @@ end
 function clink.removecoroutine(c)
     if type(c) == "thread" then
         release_coroutine_yieldguard()
+        local entry = _coroutines[c]
         if _dead then
-            local entry = _coroutines[c]
             if entry then
                 local status = coroutine.status(c)
                 -- Clear references.
@@ -706,12 +784,13 @@ function clink.removecoroutine(c)
                 table.insert(_dead, entry)
             end
         end
-        _coroutines[c] = nil
-        _coroutines_resumable = false
-        for _ in pairs(_coroutines) do -- luacheck: ignore 512
-            _coroutines_resumable = true
-            break
+        if entry then
+            clink._unschedule_coroutine(entry.id)
+            _coroutine_ids[entry.id] = nil
         end
+        _coroutines[c] = nil
+        _waiting[c] = nil
+        _old_generation[c] = nil
     elseif c ~= nil then
         error("bad argument #1 (coroutine expected)")
     end
@@ -752,7 +831,11 @@ function clink.setcoroutineinterval(c, interval)
     -- Override the interval.  The scheduler never trusts the interval, so it's
     -- ok to blindly set the interval here even if the coroutine is currently
     -- being throttled.
-    _coroutines[c].interval = interval
+    local entry = _coroutines[c]
+    entry.interval = interval
+    if entry.target then
+        schedule_entry(entry)
+    end
 end
 
 --------------------------------------------------------------------------------
@@ -885,17 +968,8 @@ end
 local in_popenyield
 function io.popenyield(command, mode)
     -- This outer wrapper is implemented in Lua so that it can yield.
-    local c, ismain = coroutine.running()
-    local can_async = false
-    if not ismain then
-        -- Prompt coroutines may not run async under certain conditions.
-        if is_prompt_coroutine(c) then
-            can_async = settings.get("prompt.async") and not clink.istransientpromptfilter()
-        else
-            can_async = true
-        end
-    end
-    if can_async then
+    local c = coroutine.running()
+    if clink._can_coroutine_async() then
         -- Yield to ensure only one yieldable API is active at a time.
         local category = _coroutines[c] and _coroutines[c].yield_category
         if _coroutine_yieldguard[category] then
@@ -1087,15 +1161,24 @@ function coroutine.create(func) -- luacheck: ignore 122
     save_coroutine_state(entry)
 
     local thread = orig_coroutine_create(func)
+    _next_coroutine_id = _next_coroutine_id + 1
     entry.coroutine = thread
+    entry.id = _next_coroutine_id
     _coroutines[thread] = entry
+    _coroutine_ids[entry.id] = thread
+    schedule_entry(entry)
 
     -- Wake up idle processing.
-    _coroutines_resumable = true
     clink.kick_idle()
     return thread
 end
 
+--------------------------------------------------------------------------------
+-- Profiler frames that were in progress in a coroutine when it yielded.  They
+-- are set aside while the coroutine is suspended, so that the time it spends
+-- suspended isn't counted.
+local _profile_suspended = setmetatable({}, { __mode = "k" })
+
 --------------------------------------------------------------------------------
 local orig_coroutine_resume = coroutine.resume
 function coroutine.resume(co, ...) -- luacheck: ignore 122
@@ -1105,7 +1188,11 @@ function coroutine.resume(co, ...) -- luacheck: ignore 122
     local old_co_state = clink.co_state
     clink.co_state = entry.co_state
 
+    local pd = clink._profiling and clink._profile_resume(_profile_suspended[co])
     local tresumed = table.pack(orig_coroutine_resume(co, ...))
+    if pd then
+        _profile_suspended[co] = clink._profile_suspend(pd, coroutine.status(co) == "dead")
+    end
 
     if tresumed and not tresumed[1] and tresumed[2] then
         local err = tostring(tresumed[2])
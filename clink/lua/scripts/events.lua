@@ -5,6 +5,11 @@
 clink = clink or {}
 clink._event_callbacks = clink._event_callbacks or {}
 
+--------------------------------------------------------------------------------
+-- Profiling is only paid for while the lua.profile setting is enabled.  The
+-- setting is applied when scripts load and when each input line begins.
+clink._profiling = clink._update_profiling() or nil
+
 --------------------------------------------------------------------------------
 local bold = "\x1b[1m"                  -- Bold (bright).
 local header = "\x1b[36m"               -- Cyan.
@@ -50,12 +55,18 @@ end
 --------------------------------------------------------------------------------
 -- Sends a named event to all registered callback handlers for it.
 function clink._send_event(event, ...)
+    if event == "onbeginedit" then
+        clink._profiling = clink._update_profiling() or nil
+    end
+
     local callbacks = clink._event_callbacks[event]
     if callbacks ~= nil then
         for _, c in ipairs_active(callbacks) do
             if c.func then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter(event, c.func)
                 c.func(...)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, c)
             end
         end
@@ -71,7 +82,9 @@ function clink._send_event_string_out(event, ...)
         for _, c in ipairs_active(callbacks) do
             if c.func then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter(event, c.func)
                 local s = c.func(...)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, c)
                 if type(s) == "string" then
                     return s
@@ -91,7 +104,9 @@ function clink._send_event_cancelable(event, ...)
         for _, c in ipairs_active(callbacks) do
             if c.func then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter(event, c.func)
                 local cancel = (c.func(...) == false)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, c)
                 if cancel then
                     return false
@@ -112,7 +127,9 @@ function clink._send_event_cancelable_string_inout(event, string)
         for _, c in ipairs_active(callbacks) do
             if c.func then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter(event, c.func)
                 local s,continue = c.func(string)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, c)
                 if s then
                     string = s
@@ -323,7 +340,9 @@ function clink._send_ondisplaymatches_event(matches, popup)
         local c = callbacks[1]
         if c and c.func then
             local tick = os.clock()
+            local pt = clink._profiling and clink._profile_enter("ondisplaymatches", c.func)
             local ret = c.func(matches, popup)
+            if pt then clink._profile_leave(pt) end
             log_cost(tick, c)
             return ret
         end
@@ -406,7 +425,9 @@ function clink._send_onfiltermatches_event(matches, completion_type, filename_co
         for _, c in ipairs_active(callbacks) do
             if c and c.func then
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter("onfiltermatches", c.func)
                 local m = c.func(matches, completion_type, filename_completion_desired)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, c)
                 if m ~= nil then
                     matches = m
@@ -89,7 +89,7 @@ end
 --------------------------------------------------------------------------------
 function file_match_generator:generate(line_state, match_builder) -- luacheck: no self
     local root = line_state:getendword()
-    match_builder:addmatches(clink.filematches(root))
+    clink._add_file_matches(match_builder, root)
     return true
 end
 
@@ -233,7 +233,9 @@ function clink._generate(line_state, line_states, match_builder, old_filtering)
         -- Run match generators.
         for _, generator in ipairs(_generators) do
             line_state:_reset_shift()
+            local pt = clink._profiling and clink._profile_enter("generator", generator.generate)
             local ret = generator:generate(line_state, match_builder)
+            if pt then clink._profile_leave(pt) end
             if ret == true then
                 -- Remember the generator function that stopped.
                 clink.generator_stopped = generator.generate
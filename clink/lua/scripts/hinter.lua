@@ -62,7 +62,9 @@ function clink._gethint(line_state)
             if hinter.gethint then
                 line_state:_reset_shift()
                 local tick = os.clock()
+                local pt = clink._profiling and clink._profile_enter("hinter", hinter.gethint)
                 local hint, pos = hinter:gethint(line_state)
+                if pt then clink._profile_leave(pt) end
                 log_cost(tick, hinter)
                 if hint then
                     if not pos then
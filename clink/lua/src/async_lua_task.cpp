@@ -281,7 +281,7 @@ void async_lua_task::cancel()
 {
     m_run_callback = false;
     if (!m_is_complete)
-        m_is_canceled = true;
+        work_item::cancel();
 }
 
 //------------------------------------------------------------------------------
@@ -302,28 +302,40 @@ void async_lua_task::wake_asyncyield() const
 //------------------------------------------------------------------------------
 void async_lua_task::start()
 {
-    auto task = shared_from_this();
-    m_thread = std::make_unique<std::thread>(&proc, std::move(task));
+    // The work pool holds a strong ref until the work finishes.
+    if (!work_pool::get().submit(work_category::task, shared_from_this()))
+        finish();
 }
 
 //------------------------------------------------------------------------------
 void async_lua_task::detach()
 {
+    // The work pool owns the work; just ask it to stop early.
     cancel();
-    if (m_thread)
-    {
-        m_thread->detach();
-        m_thread.reset();
-    }
 }
 
 //------------------------------------------------------------------------------
-void async_lua_task::proc(std::shared_ptr<async_lua_task> task)
+void async_lua_task::run()
+{
+    do_work();
+    finish();
+}
+
+//------------------------------------------------------------------------------
+void async_lua_task::skip()
 {
-    task->do_work();
-    task->m_is_complete = true;
-    task->detach();
-    SetEvent(task->m_event);
+    // Canceled before the work started.  Only tasks that have been detached
+    // get canceled, and their asyncyield may already be gone, so only signal
+    // the wait handle.
+    finish();
+}
+
+//------------------------------------------------------------------------------
+void async_lua_task::finish()
+{
+    m_is_complete = true;
+    cancel();
+    SetEvent(m_event);
     SetEvent(get_task_manager_event());
 }
 
@@ -362,7 +374,9 @@ int32 async_yield_lua::get_expiration(lua_State* state)
 //------------------------------------------------------------------------------
 int32 async_yield_lua::ready(lua_State* state)
 {
-    lua_pushboolean(state, m_ready);
+    // A task shared by several coroutines can't wake each one's asyncyield,
+    // so those asyncyields ask the task instead.
+    lua_pushboolean(state, m_ready || (m_task && m_task->is_complete()));
     return 1;
 }
 
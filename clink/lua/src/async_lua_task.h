@@ -4,11 +4,12 @@
 #include "lua_bindable.h"
 
 #include <core/str.h>
+#include <core/work_pool.h>
 
 #include <memory>
-#include <thread>
 
 class lua_state;
+class async_lua_task;
 
 //------------------------------------------------------------------------------
 struct callback_ref
@@ -28,6 +29,7 @@ public:
     bool                    is_expired() const;
     void                    set_ready() { m_ready = true; }
     void                    clear_ready() { m_ready = false; }
+    void                    set_task(const std::shared_ptr<async_lua_task>& task) { m_task = task; }
 
 protected:
     int32                   get_name(lua_State* state);
@@ -36,6 +38,7 @@ protected:
 
 private:
     str_moveable            m_name;
+    std::shared_ptr<async_lua_task> m_task;    // Ready when the task completes.
     double                  m_expiration = 0.0;
     bool                    m_ready = false;
 
@@ -45,7 +48,9 @@ private:
 };
 
 //------------------------------------------------------------------------------
-class async_lua_task : public std::enable_shared_from_this<async_lua_task>
+class async_lua_task
+    : public work_item
+    , public std::enable_shared_from_this<async_lua_task>
 {
     friend class task_manager;
 
@@ -56,7 +61,6 @@ public:
     const char*             key() const { return m_key.c_str(); }
     HANDLE                  get_wait_handle() const { return m_event; }
     bool                    is_complete() const { return m_is_complete; }
-    bool                    is_canceled() const { return m_is_canceled; }
 
     void                    set_asyncyield(async_yield_lua* asyncyield);
     void                    set_callback(const std::shared_ptr<callback_ref>& callback);
@@ -74,19 +78,19 @@ private:
     void                    start();
     void                    detach();
     bool                    is_run_until_complete() const { return m_run_until_complete; }
-    static void             proc(std::shared_ptr<async_lua_task> task);
+    void                    run() override;
+    void                    skip() override;
+    void                    finish();
 
 private:
     HANDLE                  m_event;
-    std::unique_ptr<std::thread> m_thread;
     str_moveable            m_key;
     str_moveable            m_src;
     async_yield_lua*        m_asyncyield = nullptr;
     std::shared_ptr<callback_ref> m_callback_ref;
     const bool              m_run_until_complete = false;
     bool                    m_run_callback = false;
-    bool                    m_is_complete = false;
-    volatile bool           m_is_canceled = false;
+    volatile bool           m_is_complete = false;
 };
 
 //------------------------------------------------------------------------------
@@ -8,6 +8,11 @@
 #include "line_states_lua.h"
 #include "prompt.h"
 #include "async_lua_task.h"
+#include "coroutine_scheduler.h"
+#include "lua_script_cache.h"
+#include "completion_index.h"
+#include "lua_profiler.h"
+#include "file_matches_lua.h"
 #include "command_link_dialog.h"
 #include "sessionstream.h"
 #include "../../app/src/version.h" // Ugh.
@@ -30,6 +35,7 @@
 #include <lib/cmd_tokenisers.h>
 #include <lib/reclassify.h>
 #include <lib/recognizer.h>
+#include <lib/exe_index.h>
 #include <lib/matches_lookaside.h>
 #include <lib/line_editor_integration.h>
 #include <lib/rl_integration.h>
@@ -1716,6 +1722,205 @@ static int32 kick_idle(lua_State* state)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 schedule_coroutine(lua_State* state)
+{
+    const auto id = checkinteger(state, 1);
+    const auto target = checknumber(state, 2);
+    coroutine_scheduler* scheduler = coroutine_scheduler::get(state);
+    if (!id.isnum() || !target.isnum() || !scheduler)
+        return 0;
+
+    scheduler->schedule(id, target);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 wait_coroutine(lua_State* state)
+{
+    const auto id = checkinteger(state, 1);
+    coroutine_scheduler* scheduler = coroutine_scheduler::get(state);
+    if (!id.isnum() || !scheduler)
+        return 0;
+
+    scheduler->wait(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 unschedule_coroutine(lua_State* state)
+{
+    const auto id = checkinteger(state, 1);
+    coroutine_scheduler* scheduler = coroutine_scheduler::get(state);
+    if (!id.isnum() || !scheduler)
+        return 0;
+
+    scheduler->remove(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 clear_coroutine_schedule(lua_State* state)
+{
+    if (coroutine_scheduler* scheduler = coroutine_scheduler::get(state))
+        scheduler->clear();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 take_due_coroutines(lua_State* state)
+{
+    std::vector<int32> due;
+    if (coroutine_scheduler* scheduler = coroutine_scheduler::get(state))
+        scheduler->take_due(os::clock(), due);
+
+    lua_createtable(state, int32(due.size()), 0);
+    for (size_t i = 0; i < due.size(); ++i)
+    {
+        lua_pushinteger(state, due[i]);
+        lua_rawseti(state, -2, int32(i + 1));
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 wait_duration(lua_State* state)
+{
+    double duration;
+    coroutine_scheduler* scheduler = coroutine_scheduler::get(state);
+    if (!scheduler || !scheduler->get_wait_duration(os::clock(), duration))
+        return 0;
+
+    lua_pushnumber(state, duration);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 has_coroutines(lua_State* state)
+{
+    coroutine_scheduler* scheduler = coroutine_scheduler::get(state);
+    lua_pushboolean(state, scheduler && scheduler->has_coroutines());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Like loadfile(), but uses the precompiled script cache.
+static int32 loadfile_cached(lua_State* state)
+{
+    const char* path = checkstring(state, 1);
+    if (!path)
+        return 0;
+
+    if (load_lua_file_cached(state, path) != LUA_OK)
+    {
+        lua_pushnil(state);
+        lua_insert(state, -2);
+        return 2;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Checks the completion script index for a script by the specified name in
+// the specified directory.
+static int32 completion_script_exists(lua_State* state)
+{
+    const char* dir = checkstring(state, 1);
+    const char* name = checkstring(state, 2);
+    if (!dir || !name)
+        return 0;
+
+    lua_pushboolean(state, completion_index::get().has_script(dir, name));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 get_completion_index_stats(lua_State* state)
+{
+    uint32 lookups, found, scans;
+    completion_index::get().get_stats(lookups, found, scans);
+    lua_pushinteger(state, lookups);
+    lua_pushinteger(state, found);
+    lua_pushinteger(state, scans);
+    return 3;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns a token to pass to _profile_leave, or nil when profiling is off.
+static int32 profile_enter(lua_State* state)
+{
+    const char* category = checkstring(state, 1);
+    if (!category)
+        return 0;
+
+    const uint32 token = lua_profiler::get().enter(state, category, 2);
+    if (!token)
+        return 0;
+
+    lua_pushinteger(state, token);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 profile_leave(lua_State* state)
+{
+    if (lua_isnumber(state, 1))
+        lua_profiler::get().leave(uint32(lua_tointeger(state, 1)));
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Applies the lua.profile setting.  Returns true when profiling is enabled.
+static int32 update_profiling(lua_State* state)
+{
+    lua_pushboolean(state, lua_profiler::get().install(state));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Call before resuming a coroutine, passing the value _profile_suspend
+// returned when it last yielded.  Returns a depth to pass to
+// _profile_suspend.
+static int32 profile_resume(lua_State* state)
+{
+    const uint32 suspended = lua_isnumber(state, 1) ? uint32(lua_tointeger(state, 1)) : 0;
+    lua_pushinteger(state, lua_profiler::get().resume(suspended));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Call after resuming a coroutine.  Returns a value to pass to _profile_resume
+// next time, or nil if the coroutine had no frames in progress.
+static int32 profile_suspend(lua_State* state)
+{
+    if (!lua_isnumber(state, 1))
+        return 0;
+
+    const uint32 depth = uint32(lua_tointeger(state, 1));
+    const bool dead = lua_toboolean(state, 2);
+    const uint32 suspended = lua_profiler::get().suspend(depth, dead);
+    if (!suspended)
+        return 0;
+
+    lua_pushinteger(state, suspended);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 // UNDOCUMENTED; internal use only.
 static int32 recognize_command(lua_State* state)
@@ -1723,17 +1928,86 @@ static int32 recognize_command(lua_State* state)
     const char* line = checkstring(state, 1);
     const char* word = checkstring(state, 2);
     const bool quoted = lua_toboolean(state, 3);
+    const int32 offset = optinteger(state, 4, 0) - 1;
     if (!line || !word)
         return 0;
     if (!*line || !*word)
         return 0;
 
     bool ready;
-    const recognition recognized = recognize_command(line, word, quoted, ready, nullptr/*file*/);
+    const recognition recognized = recognize_command(line, word, quoted, ready, nullptr/*file*/, offset);
     lua_pushinteger(state, int32(recognized));
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns a handle that streams file or directory matches into a builder.
+static int32 file_matches(lua_State* state)
+{
+    const char* pattern = checkstring(state, 1);
+    const char* root = checkstring(state, 2);
+    if (!pattern || !root)
+        return 0;
+
+    const bool dirs_only = lua_toboolean(state, 3);
+    const bool hidden = lua_toboolean(state, 4);
+    const bool system = lua_toboolean(state, 5);
+    if (!file_matches_lua::make_new(state, pattern, root, dirs_only, hidden, system))
+        return 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns match tables for the executable files in the %PATH% directories,
+// from the executable index.
+static int32 get_path_executables(lua_State* state)
+{
+    const bool hidden = lua_toboolean(state, 1);
+    const bool system = lua_toboolean(state, 2);
+
+    // Copy the names first, so the index isn't locked while pushing to Lua.
+    std::vector<exe_index::executable> exes;
+    exe_index::get().get_executables(exes);
+
+    lua_createtable(state, int32(exes.size()), 0);
+
+    int32 i = 1;
+    str<32> type;
+    for (const auto& exe : exes)
+    {
+        const uint32 attr = exe.attr;
+        if ((attr & FILE_ATTRIBUTE_HIDDEN) && !hidden)
+            continue;
+        if ((attr & FILE_ATTRIBUTE_SYSTEM) && !system)
+            continue;
+
+        type = "file";
+        if (attr & FILE_ATTRIBUTE_HIDDEN)
+            type.concat(",hidden");
+        if (attr & FILE_ATTRIBUTE_SYSTEM)
+            type.concat(",system");
+        if (attr & FILE_ATTRIBUTE_READONLY)
+            type.concat(",readonly");
+
+        lua_createtable(state, 0, 2);
+
+        lua_pushliteral(state, "match");
+        lua_pushlstring(state, exe.name.c_str(), exe.name.length());
+        lua_rawset(state, -3);
+
+        lua_pushliteral(state, "type");
+        lua_pushlstring(state, type.c_str(), type.length());
+        lua_rawset(state, -3);
+
+        lua_rawseti(state, -2, i++);
+    }
+
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 static str_unordered_map<int32> s_cached_path_type;
 static linear_allocator s_cached_path_store(2048);
@@ -2641,7 +2915,24 @@ void clink_lua_initialise(lua_state& lua, bool lua_interpreter)
         { 0,    "set_suggestion_result",  &set_suggestion_result },
         { 0,    "_is_suggestionlist_mode", &is_suggestionlist_mode },
         { 0,    "kick_idle",              &kick_idle },
+        { 0,    "_schedule_coroutine",    &schedule_coroutine },
+        { 0,    "_wait_coroutine",        &wait_coroutine },
+        { 0,    "_unschedule_coroutine",  &unschedule_coroutine },
+        { 0,    "_clear_coroutine_schedule", &clear_coroutine_schedule },
+        { 0,    "_take_due_coroutines",   &take_due_coroutines },
+        { 0,    "_wait_duration",         &wait_duration },
+        { 0,    "_has_coroutines",        &has_coroutines },
+        { 0,    "_loadfile",              &loadfile_cached },
+        { 0,    "_completion_script_exists", &completion_script_exists },
+        { 0,    "_get_completion_index_stats", &get_completion_index_stats },
+        { 0,    "_profile_enter",         &profile_enter },
+        { 0,    "_profile_leave",         &profile_leave },
+        { 0,    "_profile_resume",        &profile_resume },
+        { 0,    "_profile_suspend",       &profile_suspend },
+        { 0,    "_update_profiling",      &update_profiling },
         { 0,    "_recognize_command",     &recognize_command },
+        { 0,    "_get_path_executables",  &get_path_executables },
+        { 0,    "_file_matches",          &file_matches },
         { 0,    "_async_path_type",       &async_path_type },
         { 0,    "_generate_from_history", &generate_from_history },
         { 0,    "_reset_generate_matches", &api_reset_generate_matches },
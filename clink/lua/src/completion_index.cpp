@@ -0,0 +1,123 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "completion_index.h"
+
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str_transform.h>
+
+//------------------------------------------------------------------------------
+static const double c_recheck_interval = 2.0;   // Seconds.
+
+
+
+//------------------------------------------------------------------------------
+completion_index& completion_index::get()
+{
+    static completion_index s_index;
+    return s_index;
+}
+
+//------------------------------------------------------------------------------
+bool completion_index::has_script(const char* dir, const char* name)
+{
+    dir_entry* entry = find_dir(dir);
+    if (!entry)
+        return false;
+
+    const double now = os::clock();
+    if (!entry->checked || now - entry->checked >= c_recheck_interval)
+    {
+        entry->checked = now;
+        uint64 mtime = 0;
+        const bool exists = os::get_dir_mtime(entry->dir.c_str(), mtime);
+        if (exists != entry->exists || mtime != entry->mtime)
+        {
+            entry->exists = exists;
+            entry->mtime = mtime;
+            refresh(*entry);
+        }
+    }
+
+    str<> lower;
+    str_transform(name, uint32(strlen(name)), lower, transform_mode::lower);
+
+    ++m_lookups;
+    const bool found = (entry->names.find(lower.c_str()) != entry->names.end());
+    if (found)
+        ++m_found;
+    return found;
+}
+
+//------------------------------------------------------------------------------
+void completion_index::clear()
+{
+    m_dirs.clear();
+}
+
+//------------------------------------------------------------------------------
+void completion_index::get_stats(uint32& lookups, uint32& found, uint32& scans) const
+{
+    lookups = m_lookups;
+    found = m_found;
+    scans = m_scans;
+}
+
+//------------------------------------------------------------------------------
+completion_index::dir_entry* completion_index::find_dir(const char* dir)
+{
+    // Directories are compared case insensitively.
+    str<> key;
+    str_transform(dir, uint32(strlen(dir)), key, transform_mode::lower);
+    path::normalise(key);
+
+    auto iter = m_dirs.find(key.c_str());
+    if (iter != m_dirs.end())
+        return iter->second.get();
+
+    std::unique_ptr<dir_entry> entry = std::make_unique<dir_entry>();
+    entry->dir = key.c_str();
+    dir_entry* ret = entry.get();
+    m_dirs.emplace(entry->dir.c_str(), std::move(entry));
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+void completion_index::refresh(dir_entry& entry)
+{
+    entry.names.clear();
+    entry.store.clear();
+    if (!entry.exists)
+        return;
+
+    ++m_scans;
+
+    str<> pattern(entry.dir.c_str());
+    path::append(pattern, "*.lua");
+
+    globber lua_files(pattern.c_str());
+    lua_files.files(true);
+    lua_files.directories(false);
+    lua_files.hidden(true);
+    lua_files.system(true);
+    lua_files.long_names(true);
+
+    str<> file;
+    str<> lower;
+    while (lua_files.next(file, false))
+    {
+        // The "*.lua" pattern can also match longer extensions via short
+        // names, so check the extension exactly.
+        const char* ext = path::get_extension(file.c_str());
+        if (!ext || _stricmp(ext, ".lua") != 0)
+            continue;
+
+        str_transform(file.c_str(), file.length(), lower, transform_mode::lower);
+        const char* stored = entry.store.store(lower.c_str());
+        if (stored)
+            entry.names.emplace(stored);
+    }
+}
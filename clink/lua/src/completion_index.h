@@ -0,0 +1,48 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/linear_allocator.h>
+#include <core/str.h>
+#include <core/str_unordered_set.h>
+
+#include <memory>
+
+//------------------------------------------------------------------------------
+// Indexes the Lua scripts in the completions directories, so that looking for
+// a command's completion script is a hash lookup instead of probing the file
+// system in each directory for each new command word.
+//
+// A directory is rescanned when its last write time changes, which happens
+// whenever a file is added to, removed from, or renamed in the directory.  The
+// last write time is checked at most once every few seconds.
+class completion_index
+{
+public:
+    static completion_index& get();
+
+    bool            has_script(const char* dir, const char* name);
+    void            clear();
+    void            get_stats(uint32& lookups, uint32& found, uint32& scans) const;
+
+private:
+    struct dir_entry
+    {
+                    dir_entry() : store(4096) {}
+        str_moveable dir;
+        linear_allocator store;
+        str_unordered_set names;        // Lowercase names, owned by store.
+        uint64      mtime = 0;
+        double      checked = 0;
+        bool        exists = false;
+    };
+
+    dir_entry*      find_dir(const char* dir);
+    void            refresh(dir_entry& entry);
+
+    str_unordered_map<std::unique_ptr<dir_entry>> m_dirs;   // Keys are owned by the entries.
+    uint32          m_lookups = 0;
+    uint32          m_found = 0;
+    uint32          m_scans = 0;
+};
@@ -0,0 +1,150 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "coroutine_scheduler.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static const char c_registry_key[] = "clink_coroutine_scheduler";
+
+//------------------------------------------------------------------------------
+coroutine_scheduler* coroutine_scheduler::get(lua_State* L)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, c_registry_key);
+    auto* scheduler = static_cast<coroutine_scheduler*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    return scheduler;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::attach(lua_State* L)
+{
+    lua_pushlightuserdata(L, this);
+    lua_setfield(L, LUA_REGISTRYINDEX, c_registry_key);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::clear()
+{
+    m_heap.clear();
+    m_slots.clear();
+    m_waiting = 0;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::schedule(int32 id, double target)
+{
+    slot& s = m_slots[id];
+    if (s.waiting)
+    {
+        s.waiting = false;
+        --m_waiting;
+    }
+
+    // Bumping the sequence number makes any earlier node for this id stale.
+    s.seq = ++m_seq;
+    m_heap.push_back({ target, id, s.seq });
+    std::push_heap(m_heap.begin(), m_heap.end(), later);
+
+    compact();
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::wait(int32 id)
+{
+    slot& s = m_slots[id];
+    if (!s.waiting)
+    {
+        s.waiting = true;
+        ++m_waiting;
+    }
+    s.seq = ++m_seq;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::remove(int32 id)
+{
+    const auto it = m_slots.find(id);
+    if (it == m_slots.end())
+        return;
+
+    if (it->second.waiting)
+        --m_waiting;
+    m_slots.erase(it);
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::get_wait_duration(double now, double& duration)
+{
+    discard_stale();
+    if (m_heap.empty())
+        return false;
+
+    duration = m_heap.front().target - now;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::is_due(double now)
+{
+    discard_stale();
+    return !m_heap.empty() && m_heap.front().target <= now;
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::take_due(double now, std::vector<int32>& out)
+{
+    // Due coroutines come out in order of target time, and ties keep the
+    // order in which they were scheduled.
+    while (is_due(now))
+    {
+        out.push_back(m_heap.front().id);
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::later(const node& a, const node& b)
+{
+    if (a.target != b.target)
+        return a.target > b.target;
+    return a.seq > b.seq;
+}
+
+//------------------------------------------------------------------------------
+bool coroutine_scheduler::is_live(const node& n) const
+{
+    const auto it = m_slots.find(n.id);
+    return (it != m_slots.end() && it->second.seq == n.seq);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::discard_stale()
+{
+    while (!m_heap.empty() && !is_live(m_heap.front()))
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+void coroutine_scheduler::compact()
+{
+    // Rescheduling leaves stale nodes behind; rebuild the heap when they
+    // dominate it.
+    if (m_heap.size() < 64 || m_heap.size() < m_slots.size() * 4)
+        return;
+
+    m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [this](const node& n) {
+        return !is_live(n);
+    }), m_heap.end());
+    std::make_heap(m_heap.begin(), m_heap.end(), later);
+}
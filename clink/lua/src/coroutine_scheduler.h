@@ -0,0 +1,64 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// Tracks when each Lua coroutine is next due to be resumed, so idle processing
+// can find the next wakeup time and the due coroutines without visiting every
+// coroutine.  Coroutines are identified by ids assigned in coroutines.lua, and
+// times use the same clock as os.clock().  The ids belong to one Lua state, so
+// each lua_state owns its own scheduler.
+//
+// A coroutine is in one of three states:
+//  - Scheduled:  it has a target time in the heap.
+//  - Waiting:  it's waiting for an io.popenyield, asyncyield, or queue, and
+//    becomes resumable only when an event wakes idle processing and Lua finds
+//    its wait satisfied.
+//  - In flight:  take_due() returned it, and Lua has not rescheduled it yet.
+class coroutine_scheduler
+{
+public:
+    static coroutine_scheduler* get(lua_State* L);
+    void            attach(lua_State* L);
+
+    void            clear();
+    void            schedule(int32 id, double target);
+    void            wait(int32 id);
+    void            remove(int32 id);
+
+    bool            has_coroutines() const { return !m_slots.empty(); }
+    bool            has_waiting() const { return m_waiting > 0; }
+    bool            get_wait_duration(double now, double& duration);
+    bool            is_due(double now);
+    void            take_due(double now, std::vector<int32>& out);
+
+private:
+    struct node
+    {
+        double      target;
+        int32       id;
+        uint32      seq;
+    };
+
+    struct slot
+    {
+        uint32      seq = 0;
+        bool        waiting = false;
+    };
+
+    static bool     later(const node& a, const node& b);
+    bool            is_live(const node& n) const;
+    void            discard_stale();
+    void            compact();
+
+    std::vector<node> m_heap;           // Min-heap; may contain stale nodes.
+    std::unordered_map<int32, slot> m_slots;
+    uint32          m_waiting = 0;
+    uint32          m_seq = 0;
+};
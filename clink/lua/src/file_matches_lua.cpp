@@ -0,0 +1,198 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "file_matches_lua.h"
+#include "match_builder_lua.h"
+
+#include <core/path.h>
+#include <core/str_transform.h>
+#include <lib/clink_ctrlevent.h>
+#include <lib/matches.h>
+
+//------------------------------------------------------------------------------
+const char* const file_matches_lua::c_name = "file_matches_lua";
+const file_matches_lua::method file_matches_lua::c_methods[] = {
+    { "addto",                  &add_to },
+    { "close",                  &close },
+    {}
+};
+
+//------------------------------------------------------------------------------
+match_type get_globbed_match_type(const globber::extrainfo& info, str_base& parent, const char* file)
+{
+    match_type type = (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? match_type::dir : match_type::file;
+#ifdef S_ISLNK
+    if (S_ISLNK(info.st_mode))
+    {
+        type |= match_type::link;
+        const uint32 len = parent.length();
+        path::append(parent, file);
+        wstr<288> wfile(parent.c_str());
+        struct _stat64 st;
+        if (_wstat64(wfile.c_str(), &st) < 0)
+            type |= match_type::orphaned;
+        parent.truncate(len);
+    }
+#endif
+    if (info.attr & FILE_ATTRIBUTE_HIDDEN)
+        type |= match_type::hidden;
+    if (info.attr & FILE_ATTRIBUTE_SYSTEM)
+        type |= match_type::system;
+    if (info.attr & FILE_ATTRIBUTE_READONLY)
+        type |= match_type::readonly;
+    return type;
+}
+
+
+
+//------------------------------------------------------------------------------
+file_matches_lua::file_matches_lua(const char* pattern, const char* root, bool dirs_only, bool hidden, bool system)
+: m_parent(pattern)
+, m_root(root)
+, m_dirs_only(dirs_only)
+, m_hidden(hidden)
+, m_system(system)
+{
+    path::to_parent(m_parent, nullptr);
+
+    if (!use_cache(pattern))
+    {
+        m_globber = std::make_unique<globber>(pattern);
+        m_globber->files(!dirs_only);
+        m_globber->hidden(hidden);
+        m_globber->system(system);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool file_matches_lua::use_cache(const char* pattern)
+{
+    // The globber handles quotes, drive relative paths, DOS wildcards, and
+    // short names; leave those to it.
+    if (strpbrk(pattern, "\"<>~"))
+        return false;
+    if (pattern[0] && pattern[1] == ':' && !path::is_separator(pattern[2]))
+        return false;
+
+    // The globber includes . and .. when the name is exactly ".", "..", ".*",
+    // or "..*", but the cached listings don't have them.
+    const char* name = path::get_name(pattern);
+    if (name[0] == '.')
+    {
+        uint32 index = (name[1] == '.') ? 2 : 1;
+        if (name[index] == '*')
+            index++;
+        if (name[index] == '\0')
+            return false;
+    }
+
+    str<> dir;
+    path::get_directory(pattern, dir);
+    m_listing = dir_cache::get().find(dir.c_str());
+    if (!m_listing)
+        return false;
+
+    str_transform(name, uint32(strlen(name)), m_name, transform_mode::lower);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool file_matches_lua::next(str_base& out, globber::extrainfo& info)
+{
+    if (m_globber)
+        return m_globber->next(out, false, &info);
+
+    while (m_listing && m_index < m_listing->files.size())
+    {
+        const dir_cache::file& file = m_listing->files[m_index++];
+        const bool dir = !!(file.attr & FILE_ATTRIBUTE_DIRECTORY);
+        if ((file.attr & FILE_ATTRIBUTE_SYSTEM) && !m_system)
+            continue;
+        if ((file.attr & FILE_ATTRIBUTE_HIDDEN) && !m_hidden)
+            continue;
+        if (!dir && m_dirs_only)
+            continue;
+        if (!dir_cache::match_name(m_name.c_str(), file.lower))
+            continue;
+
+        out = file.name;
+        if (dir)
+            out << PATH_SEP;
+
+        memset(&info, 0, sizeof(info));
+        info.st_mode = file.st_mode;
+        info.attr = file.attr;
+        info.size = file.size;
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Adds matches to the builder.  When batch is true, it returns after a batch
+// of matches, and returns true if there may be more matches.
+int32 file_matches_lua::add_to(lua_State* state)
+{
+    match_builder_lua* builder_lua = match_builder_lua::check(state, 2);
+    match_builder* builder = builder_lua ? builder_lua->get_builder() : nullptr;
+    const bool batch = lua_toboolean(state, 3);
+    if (!builder || m_done)
+    {
+        lua_pushboolean(state, false);
+        return 1;
+    }
+
+    const DWORD ms_max = 20;
+    const uint32 num_max = 250;
+    const DWORD tick = GetTickCount();
+
+    str<288> file;
+    str<288> match;
+    globber::extrainfo info;
+    for (uint32 i = 1; true; ++i)
+    {
+        if (!next(file, info))
+        {
+            m_done = true;
+            break;
+        }
+
+        const match_type type = get_globbed_match_type(info, m_parent, file.c_str());
+
+        path::join(m_root.c_str(), file.c_str(), match);
+        match_desc desc(match.c_str(), nullptr, nullptr, type);
+        builder->add_match(desc);
+
+        if (!(i & 0x03) && clink_is_signaled())
+        {
+            m_done = true;
+            break;
+        }
+        if (batch && (i >= num_max || GetTickCount() - tick > ms_max))
+            break;
+    }
+
+    if (m_done)
+        close_source();
+
+    lua_pushboolean(state, !m_done);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int32 file_matches_lua::close(lua_State* state)
+{
+    m_done = true;
+    close_source();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void file_matches_lua::close_source()
+{
+    if (m_globber)
+        m_globber->close();
+    m_listing.reset();
+}
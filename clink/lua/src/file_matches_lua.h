@@ -0,0 +1,59 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "lua_bindable.h"
+
+#include <core/globber.h>
+#include <core/str.h>
+#include <lib/dir_cache.h>
+#include <lib/matches.h>
+
+#include <memory>
+
+//------------------------------------------------------------------------------
+// Returns the match type for a file found by a globber, including the link,
+// orphaned, hidden, system, and readonly flags.  The parent is the directory
+// containing the file; it's used temporarily to check whether a link is
+// orphaned, and is restored before returning.
+match_type get_globbed_match_type(const globber::extrainfo& info, str_base& parent, const char* file);
+
+//------------------------------------------------------------------------------
+// Streams file or directory matches from a globber straight into a match
+// builder, so that completing in a large directory doesn't need a Lua table
+// per file.  It's a handle so that Lua can yield between batches when it's
+// running in a coroutine.
+//
+// When the directory is in the dir_cache, the cached listing is used instead
+// of reading the directory again.
+class file_matches_lua
+    : public lua_bindable<file_matches_lua>
+{
+public:
+                        file_matches_lua(const char* pattern, const char* root, bool dirs_only, bool hidden, bool system);
+
+protected:
+    int32               add_to(lua_State* state);
+    int32               close(lua_State* state);
+
+private:
+    bool                use_cache(const char* pattern);
+    bool                next(str_base& out, globber::extrainfo& info);
+    void                close_source();
+
+    std::unique_ptr<globber> m_globber;
+    std::shared_ptr<const dir_cache::listing> m_listing;
+    size_t              m_index = 0;
+    str<>               m_name;             // Lowercase name pattern, for m_listing.
+    str<288>            m_parent;
+    str<288>            m_root;
+    bool                m_dirs_only;
+    bool                m_hidden;
+    bool                m_system;
+    bool                m_done = false;
+
+    friend class lua_bindable<file_matches_lua>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
@@ -0,0 +1,853 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_state.h"
+#include "async_lua_task.h"
+
+#include <core/debugheap.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_transform.h>
+#include <core/str_unordered_set.h>
+
+extern "C" {
+#include <lstate.h>
+}
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+static const uint32 c_max_results = 16;
+static const uint32 c_max_repo_dirs = 256;
+static const DWORD c_query_wait = 5000;         // Milliseconds.
+
+
+
+//------------------------------------------------------------------------------
+static FILE* open_file(const char* dir, const char* name)
+{
+    str<> file(dir);
+    path::append(file, name);
+    path::normalise(file);
+
+    wstr<280> wfile(file.c_str());
+    return _wfopen(wfile.c_str(), L"rt");
+}
+
+//------------------------------------------------------------------------------
+static bool read_first_line(const char* dir, const char* name, str_base& out)
+{
+    out.clear();
+
+    FILE* f = open_file(dir, name);
+    if (!f)
+        return false;
+
+    char buffer[1024];
+    const bool ok = !!fgets(buffer, sizeof(buffer), f);
+    fclose(f);
+    if (!ok)
+        return false;
+
+    out = buffer;
+    out.trim();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void get_common_dir(const char* git_dir, str_base& out)
+{
+    // A worktree's git dir names the main git dir in its commondir file, and
+    // that's where the shared refs and config live.
+    out = git_dir;
+
+    str<> common;
+    if (read_first_line(git_dir, "commondir", common) && !common.empty())
+    {
+        path::append(out, common.c_str());
+        path::normalise(out);
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool has_packed_ref(const char* common_dir, const char* ref)
+{
+    FILE* f = open_file(common_dir, "packed-refs");
+    if (!f)
+        return false;
+
+    // Lines are "<oid> <ref>".  Comments begin with '#' and peeled tags begin
+    // with '^', and neither has a space followed by a ref name.
+    bool found = false;
+    const size_t ref_len = strlen(ref);
+    char line[1024];
+    while (!found && fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#' || line[0] == '^')
+            continue;
+        const char* name = strchr(line, ' ');
+        if (!name)
+            continue;
+        ++name;
+        found = (strncmp(name, ref, ref_len) == 0 && (!name[ref_len] || name[ref_len] == '\r' || name[ref_len] == '\n'));
+    }
+
+    fclose(f);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+static bool has_ref(const char* common_dir, const char* ref)
+{
+    str<> file(common_dir);
+    path::append(file, ref);
+    path::normalise(file);
+    if (os::get_path_type(file.c_str()) == os::path_type_file)
+        return true;
+
+    return has_packed_ref(common_dir, ref);
+}
+
+//------------------------------------------------------------------------------
+static bool get_upstream_ref(const char* common_dir, const char* branch, str_base& out)
+{
+    // Finds the ref that tracks the branch's upstream.  For example when
+    // branch.main.remote is "origin" and branch.main.merge is "refs/heads/main"
+    // then the upstream ref is "refs/remotes/origin/main".
+    out.clear();
+
+    FILE* f = open_file(common_dir, "config");
+    if (!f)
+        return false;
+
+    str<> section;
+    section.format("[branch \"%s\"]", branch);
+
+    str<> remote;
+    str<> merge;
+    str<> line;
+    str<> key;
+    bool in_section = false;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), f))
+    {
+        line = buffer;
+        line.trim();
+        if (line[0] == '[')
+        {
+            in_section = line.equals(section.c_str());
+            continue;
+        }
+        if (!in_section)
+            continue;
+
+        const char* eq = strchr(line.c_str(), '=');
+        if (!eq)
+            continue;
+        key.clear();
+        key.concat(line.c_str(), int32(eq - line.c_str()));
+        key.trim();
+        str<> value(eq + 1);
+        value.trim();
+
+        if (key.iequals("remote"))
+            remote = value.c_str();
+        else if (key.iequals("merge"))
+            merge = value.c_str();
+    }
+
+    fclose(f);
+
+    static const char c_heads[] = "refs/heads/";
+    if (remote.empty() || strncmp(merge.c_str(), c_heads, sizeof(c_heads) - 1) != 0)
+        return false;
+
+    if (remote.equals("."))
+        out = merge.c_str();
+    else
+        out.format("refs/remotes/%s/%s", remote.c_str(), merge.c_str() + sizeof(c_heads) - 1);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void mix_stamp(uint64& stamp, const char* dir, const char* name)
+{
+    str<> file(dir);
+    path::append(file, name);
+    path::normalise(file);
+
+    // A missing file mixes in zeros, so that creating or deleting the file
+    // also changes the stamp.
+    uint64 values[2] = {};
+    wstr<280> wfile(file.c_str());
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(wfile.c_str(), GetFileExInfoStandard, &data))
+    {
+        values[0] = (uint64(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        values[1] = (uint64(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    for (uint64 value : values)
+    {
+        stamp ^= value;
+        stamp *= 0x100000001b3;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns a stamp that changes whenever the index, HEAD, the current branch,
+// its upstream, or the stash changes.  Changes in the working tree don't touch
+// any of those, which is why status results also have a maximum age.
+//
+// Commands such as "git status" may refresh the index, so results are stored
+// with the stamp taken after the command runs.
+static uint64 get_repo_stamp(const char* git_dir)
+{
+    str<> common_dir;
+    get_common_dir(git_dir, common_dir);
+
+    uint64 stamp = 0xcbf29ce484222325;
+
+    static const char* const c_git_files[] = { "HEAD", "index", "logs/HEAD", "FETCH_HEAD" };
+    for (const char* name : c_git_files)
+        mix_stamp(stamp, git_dir, name);
+
+    static const char* const c_common_files[] = { "packed-refs", "config", "refs/stash", "logs/refs/stash" };
+    for (const char* name : c_common_files)
+        mix_stamp(stamp, common_dir.c_str(), name);
+
+    static const char c_ref[] = "ref: ";
+    str<> head;
+    if (read_first_line(git_dir, "HEAD", head) && strncmp(head.c_str(), c_ref, sizeof(c_ref) - 1) == 0)
+    {
+        const char* ref = head.c_str() + sizeof(c_ref) - 1;
+        mix_stamp(stamp, common_dir.c_str(), ref);
+
+        static const char c_heads[] = "refs/heads/";
+        str<> upstream;
+        if (strncmp(ref, c_heads, sizeof(c_heads) - 1) == 0 &&
+            get_upstream_ref(common_dir.c_str(), ref + sizeof(c_heads) - 1, upstream))
+            mix_stamp(stamp, common_dir.c_str(), upstream.c_str());
+    }
+
+    return stamp;
+}
+
+//------------------------------------------------------------------------------
+static bool run_command(const char* command, const char* cwd, str_moveable& out)
+{
+    out.clear();
+
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, true };
+    HANDLE read = nullptr;
+    HANDLE write = nullptr;
+    if (!CreatePipe(&read, &write, &sa, 0))
+        return false;
+    SetHandleInformation(read, HANDLE_FLAG_INHERIT, 0);
+
+    // Some programs fail without a stdin handle.
+    HANDLE in = CreateFileW(L"nul", GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, nullptr);
+
+    HANDLE process = os::spawn_internal(command, cwd, in, write);
+    CloseHandle(write);
+    if (in != INVALID_HANDLE_VALUE)
+        CloseHandle(in);
+    if (!process)
+    {
+        CloseHandle(read);
+        return false;
+    }
+
+    char buffer[4096];
+    DWORD bytes;
+    while (ReadFile(read, buffer, sizeof(buffer), &bytes, nullptr) && bytes)
+        out.concat(buffer, int32(bytes));
+    CloseHandle(read);
+
+    WaitForSingleObject(process, INFINITE);
+    CloseHandle(process);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool get_parent(str_base& dir)
+{
+    str<> parent(dir.c_str());
+    if (!path::to_parent(parent, nullptr) || parent.empty() || parent.equals(dir.c_str()))
+        return false;
+
+    dir = parent.c_str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+inline bool is_main_coroutine(lua_State* state) { return G(state)->mainthread == state; }
+
+
+
+//------------------------------------------------------------------------------
+// Remembers, per directory, whether the directory has a .git dir or file and
+// which repo it refers to.  An entry is used only while the directory's last
+// write time is unchanged, which covers .git being added or removed.  So
+// finding the enclosing repo costs one directory stat per level, instead of
+// probing and reading .git in each level.  Rewriting a .git file or the git
+// dir's commondir or gitdir file doesn't change the directory's last write
+// time, so where a repo was found those files are checked as well.
+class repo_dirs
+{
+public:
+    struct repo
+    {
+        str_moveable    git_dir;
+        str_moveable    wks_dir;
+        str_moveable    common_dir;
+    };
+
+    bool                find(const char* dir, bool walk, repo& out, str_base& top);
+    void                get_stats(uint32& lookups, uint32& hits) const;
+
+private:
+    struct entry
+    {
+        str_moveable    key;
+        uint64          mtime;
+        uint64          files_stamp;
+        bool            found;
+        repo            info;
+    };
+
+    bool                lookup(const char* dir, repo& out);
+    static bool         probe(const char* dir, repo& out);
+    static uint64       get_files_stamp(const char* dir, const repo& info);
+    static void         copy(const repo& from, repo& to);
+
+    str_unordered_map<entry> m_map;     // Keys are owned by the entries.
+    uint32              m_lookups = 0;
+    uint32              m_hits = 0;
+};
+
+//------------------------------------------------------------------------------
+static repo_dirs s_repo_dirs;
+
+//------------------------------------------------------------------------------
+bool repo_dirs::find(const char* dir, bool walk, repo& out, str_base& top)
+{
+    top = dir;
+    do
+    {
+        if (lookup(top.c_str(), out))
+            return true;
+    }
+    while (walk && get_parent(top));
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void repo_dirs::get_stats(uint32& lookups, uint32& hits) const
+{
+    lookups = m_lookups;
+    hits = m_hits;
+}
+
+//------------------------------------------------------------------------------
+bool repo_dirs::lookup(const char* dir, repo& out)
+{
+    uint64 mtime;
+    if (!os::get_dir_mtime(dir, mtime))
+        return false;
+
+    // Directories are compared case insensitively.
+    str<> key;
+    str_transform(dir, uint32(strlen(dir)), key, transform_mode::lower);
+    path::maybe_strip_last_separator(key);
+
+    ++m_lookups;
+
+    auto iter = m_map.find(key.c_str());
+    if (iter != m_map.end() && iter->second.mtime == mtime &&
+        (!iter->second.found || get_files_stamp(dir, iter->second.info) == iter->second.files_stamp))
+    {
+        ++m_hits;
+        if (iter->second.found)
+            copy(iter->second.info, out);
+        return iter->second.found;
+    }
+
+    dbg_ignore_scope(snapshot, "git repo dirs");
+
+    if (iter == m_map.end())
+    {
+        // The entries are cheap to recreate, so simply start over when full.
+        if (m_map.size() >= c_max_repo_dirs)
+            m_map.clear();
+
+        entry e;
+        e.key = key.c_str();
+        const char* k = e.key.c_str();
+        iter = m_map.emplace(k, std::move(e)).first;
+    }
+
+    entry& e = iter->second;
+    e.mtime = mtime;
+    e.found = probe(dir, e.info);
+    e.files_stamp = e.found ? get_files_stamp(dir, e.info) : 0;
+    if (e.found)
+        copy(e.info, out);
+    return e.found;
+}
+
+//------------------------------------------------------------------------------
+bool repo_dirs::probe(const char* dir, repo& out)
+{
+    str<> dotgit(dir);
+    path::append(dotgit, ".git");
+
+    const DWORD attr = os::get_file_attributes(dotgit.c_str());
+    if (attr == INVALID_FILE_ATTRIBUTES)
+        return false;
+
+    str<> git_dir;
+    str<> wks_dir;
+    if (attr & FILE_ATTRIBUTE_DIRECTORY)
+    {
+        path::normalise(dotgit);
+        git_dir = dotgit.c_str();
+        wks_dir = dotgit.c_str();
+    }
+    else
+    {
+        // A .git file names the git dir of a worktree or submodule.  The path
+        // may be absolute or relative.
+        static const char c_gitdir[] = "gitdir: ";
+        str<> line;
+        if (!read_first_line(dir, ".git", line) || strncmp(line.c_str(), c_gitdir, sizeof(c_gitdir) - 1) != 0)
+            return false;
+
+        git_dir = dir;
+        path::append(git_dir, line.c_str() + sizeof(c_gitdir) - 1);
+        path::normalise(git_dir);
+        if (os::get_path_type(git_dir.c_str()) != os::path_type_dir)
+            return false;
+
+        // A worktree's git dir names the worktree's .git file.  Otherwise it's
+        // a submodule, and the workspace is the enclosing repo's .git dir.
+        if (!read_first_line(git_dir.c_str(), "gitdir", wks_dir) || wks_dir.empty())
+        {
+            str<> parent(dir);
+            while (true)
+            {
+                if (!get_parent(parent))
+                    return false;
+                str<> test(parent.c_str());
+                path::append(test, ".git");
+                if (os::get_path_type(test.c_str()) == os::path_type_dir)
+                {
+                    wks_dir = test.c_str();
+                    break;
+                }
+            }
+        }
+        path::normalise(wks_dir);
+    }
+
+    str<> common_dir;
+    get_common_dir(git_dir.c_str(), common_dir);
+
+    out.git_dir = git_dir.c_str();
+    out.wks_dir = wks_dir.c_str();
+    out.common_dir = common_dir.c_str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+uint64 repo_dirs::get_files_stamp(const char* dir, const repo& info)
+{
+    uint64 stamp = 0xcbf29ce484222325;
+
+    // Only a .git file; the last write time of a .git dir changes whenever
+    // git runs.
+    str<> dotgit(dir);
+    path::append(dotgit, ".git");
+    path::normalise(dotgit);
+    if (!dotgit.iequals(info.git_dir.c_str()))
+    {
+        mix_stamp(stamp, dir, ".git");
+        mix_stamp(stamp, info.git_dir.c_str(), "gitdir");
+    }
+
+    mix_stamp(stamp, info.git_dir.c_str(), "commondir");
+    return stamp;
+}
+
+//------------------------------------------------------------------------------
+void repo_dirs::copy(const repo& from, repo& to)
+{
+    to.git_dir = from.git_dir.c_str();
+    to.wks_dir = from.wks_dir.c_str();
+    to.common_dir = from.common_dir.c_str();
+}
+
+
+
+//------------------------------------------------------------------------------
+// Remembers the output of recent git commands, per repo.  A result is reused
+// as long as the repo stamp is unchanged and it isn't older than the caller's
+// maximum age.
+class git_results
+{
+    struct result
+    {
+        str_moveable    key;
+        str_moveable    output;
+        uint64          stamp;
+        double          time;
+    };
+
+public:
+    bool                find(const char* key, uint64 stamp, double max_age, str_moveable& out) const;
+    void                store(const char* key, const char* output, uint32 len, uint64 stamp);
+
+private:
+    mutable std::mutex  m_mutex;
+    str_unordered_map<result> m_map;    // Keys are owned by the results.
+};
+
+//------------------------------------------------------------------------------
+static git_results s_results;
+
+//------------------------------------------------------------------------------
+bool git_results::find(const char* key, uint64 stamp, double max_age, str_moveable& out) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto iter = m_map.find(key);
+    if (iter == m_map.end())
+        return false;
+    if (iter->second.stamp != stamp)
+        return false;
+    if (max_age > 0 && os::clock() - iter->second.time >= max_age)
+        return false;
+
+    out = iter->second.output.c_str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void git_results::store(const char* key, const char* output, uint32 len, uint64 stamp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    dbg_ignore_scope(snapshot, "git results");
+
+    auto iter = m_map.find(key);
+    if (iter == m_map.end())
+    {
+        // The results are cheap to recreate, so simply start over when full.
+        if (m_map.size() >= c_max_results)
+            m_map.clear();
+
+        result r;
+        r.key = key;
+        const char* k = r.key.c_str();
+        iter = m_map.emplace(k, std::move(r)).first;
+    }
+
+    iter->second.output.clear();
+    iter->second.output.concat(output, len);
+    iter->second.stamp = stamp;
+    iter->second.time = os::clock();
+}
+
+
+
+//------------------------------------------------------------------------------
+static std::atomic<uint32> s_query_runs(0);
+
+//------------------------------------------------------------------------------
+static bool run_query(const char* key, const char* command, const char* cwd, const char* git_dir, str_moveable& out)
+{
+    ++s_query_runs;
+    if (!run_command(command, cwd, out))
+        return false;
+
+    s_results.store(key, out.c_str(), out.length(), get_repo_stamp(git_dir));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+class git_query_async_lua_task : public async_lua_task
+{
+public:
+    git_query_async_lua_task(const char* key, const char* src, const char* command, const char* cwd, const char* git_dir)
+    // Runs until complete, so a query that spans lines still fills the cache.
+    : async_lua_task(key, src, true/*run_until_complete*/)
+    , m_command(command)
+    , m_cwd(cwd)
+    , m_git_dir(git_dir)
+    {}
+
+    bool get_output(str_moveable& out) const
+    {
+        if (!m_ok)
+            return false;
+        out = m_output.c_str();
+        return true;
+    }
+
+protected:
+    void do_work() override
+    {
+        m_ok = run_query(key(), m_command.c_str(), m_cwd.c_str(), m_git_dir.c_str(), m_output);
+    }
+
+private:
+    const str_moveable m_command;
+    const str_moveable m_cwd;
+    const str_moveable m_git_dir;
+    str_moveable m_output;
+    bool m_ok = false;
+};
+
+
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Runs a git command line in the repo's top dir and returns its output.  All
+// callers share one in-flight query per repo and command, and the output is
+// reused until the repo stamp changes or it's older than max_age seconds (0
+// means no age limit).  In a coroutine it yields until the query completes,
+// unless wait is true (e.g. when prompt.async is off); the main coroutine
+// always waits.
+static int32 git_query(lua_State* state);
+
+//------------------------------------------------------------------------------
+static int32 git_query_continue(lua_State* state)
+{
+    // Resuming from yield; remove asyncyield.
+    lua_state::push_named_function(state, "clink._set_coroutine_asyncyield");
+    lua_pushnil(state);
+    lua_state::pcall_silent(state, 1, 0);
+
+    // Start over with the original arguments.
+    lua_settop(state, 5);
+    return git_query(state);
+}
+
+//------------------------------------------------------------------------------
+static int32 git_query(lua_State* state)
+{
+    const char* git_dir = checkstring(state, 1);
+    const char* top_dir = checkstring(state, 2);
+    const char* command = checkstring(state, 3);
+    const double max_age = optnumber(state, 4, 0);
+    const bool wait = is_main_coroutine(state) || lua_toboolean(state, 5);
+    if (!git_dir || !top_dir || !command)
+        return 0;
+
+    const uint64 stamp = get_repo_stamp(git_dir);
+
+    // Repo dirs are compared case insensitively.
+    str<> lower;
+    str_transform(top_dir, uint32(strlen(top_dir)), lower, transform_mode::lower);
+    str_moveable key;
+    key.format("git||%s||%s", lower.c_str(), command);
+
+    str_moveable output;
+    if (!s_results.find(key.c_str(), stamp, max_age, output))
+    {
+        // Only a query that's still running can be shared.  A completed task
+        // stays registered until the next idle, but its output is already in
+        // s_results, which just rejected it as out of date.
+        std::shared_ptr<async_lua_task> task = find_async_lua_task(key.c_str());
+        const bool stale = task && task->is_complete();
+        if (!task)
+        {
+            str<> src;
+            get_lua_srcinfo(state, src);
+
+            dbg_ignore_scope(snapshot, "async git query");
+            task = std::make_shared<git_query_async_lua_task>(key.c_str(), src.c_str(), command, top_dir, git_dir);
+            if (!add_async_lua_task(task))
+                task.reset();   // No task manager (e.g. in the standalone Lua interpreter).
+        }
+
+        if (task && !wait)
+        {
+            // The scheduler doesn't resume the coroutine until the task
+            // completes.  A new query can't start until the next idle removes
+            // a stale task, so then simply yield until the next idle.
+            if (!stale)
+            {
+                async_yield_lua* asyncyield = async_yield_lua::make_new(state, "git.query");
+                if (!asyncyield)
+                    return 0;
+                asyncyield->set_task(task);
+
+                // Yielding; set asyncyield.
+                lua_state::push_named_function(state, "clink._set_coroutine_asyncyield");
+                lua_pushvalue(state, -2);
+                lua_state::pcall_silent(state, 1, 0);
+            }
+
+            return lua_yieldk(state, 0, 1, git_query_continue);
+        }
+
+        // Wait for the running query, but not indefinitely in case the work
+        // pool is busy; otherwise run the query here.
+        std::shared_ptr<git_query_async_lua_task> git_task;
+        if (task && !stale &&
+            (task->is_complete() ||
+             WaitForSingleObject(task->get_wait_handle(), c_query_wait) == WAIT_OBJECT_0 ||
+             task->is_complete()))
+            git_task = std::dynamic_pointer_cast<git_query_async_lua_task>(task);
+
+        if (git_task)
+        {
+            if (!git_task->get_output(output))
+                return 0;
+        }
+        else if (!run_query(key.c_str(), command, top_dir, git_dir, output))
+        {
+            return 0;
+        }
+    }
+
+    lua_pushlstring(state, output.c_str(), output.length());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 get_query_stats(lua_State* state)
+{
+    lua_pushinteger(state, s_query_runs);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Finds the repo enclosing dir (or the current directory), and returns the git
+// dir, the workspace dir, the dir where the repo was found, and the common git
+// dir.  When no_walk is true, only dir itself is checked.
+static int32 find_repo(lua_State* state)
+{
+    const char* dir = optstring(state, 1, nullptr);
+    const bool no_walk = lua_toboolean(state, 2);
+
+    str<> start;
+    if (!dir || !*dir || strcmp(dir, ".") == 0)
+    {
+        if (!os::get_current_dir(start))
+            return 0;
+    }
+    else
+    {
+        start = dir;
+    }
+
+    repo_dirs::repo info;
+    str<> top;
+    if (!s_repo_dirs.find(start.c_str(), !no_walk, info, top))
+        return 0;
+
+    lua_pushlstring(state, info.git_dir.c_str(), info.git_dir.length());
+    lua_pushlstring(state, info.wks_dir.c_str(), info.wks_dir.length());
+    lua_pushlstring(state, top.c_str(), top.length());
+    lua_pushlstring(state, info.common_dir.c_str(), info.common_dir.length());
+    return 4;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int32 get_find_repo_stats(lua_State* state)
+{
+    uint32 lookups, hits;
+    s_repo_dirs.get_stats(lookups, hits);
+    lua_pushinteger(state, lookups);
+    lua_pushinteger(state, hits);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns whether the repo has any stashes, by reading refs directly.
+static int32 has_stash(lua_State* state)
+{
+    const char* git_dir = checkstring(state, 1);
+    if (!git_dir)
+        return 0;
+
+    str<> common_dir;
+    get_common_dir(git_dir, common_dir);
+
+    lua_pushboolean(state, has_ref(common_dir.c_str(), "refs/stash"));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns the number of stashes, by counting the stash reflog entries.
+static int32 get_stash_count(lua_State* state)
+{
+    const char* git_dir = checkstring(state, 1);
+    if (!git_dir)
+        return 0;
+
+    str<> common_dir;
+    get_common_dir(git_dir, common_dir);
+
+    int32 count = 0;
+    if (FILE* f = open_file(common_dir.c_str(), "logs/refs/stash"))
+    {
+        char buffer[1024];
+        bool line_start = true;
+        while (fgets(buffer, sizeof(buffer), f))
+        {
+            if (line_start && buffer[0] != '\n')
+                ++count;
+            line_start = !!strchr(buffer, '\n');
+        }
+        fclose(f);
+    }
+
+    // Without a reflog the stash ref still refers to the latest stash.
+    if (!count && has_ref(common_dir.c_str(), "refs/stash"))
+        count = 1;
+
+    lua_pushinteger(state, count);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void git_lua_initialise(lua_state& lua)
+{
+    static const struct {
+        const char* name;
+        int32       (*method)(lua_State*);
+    } methods[] = {
+        // UNDOCUMENTED; internal use only.
+        { "_findrepo",      &find_repo },
+        { "_getfindrepostats", &get_find_repo_stats },
+        { "_query",         &git_query },
+        { "_getquerystats", &get_query_stats },
+        { "_hasstash",      &has_stash },
+        { "_getstashcount", &get_stash_count },
+    };
+
+    lua_State* state = lua.get_state();
+
+    lua_createtable(state, 0, sizeof_array(methods));
+
+    for (const auto& method : methods)
+    {
+        lua_pushstring(state, method.name);
+        lua_pushcfunction(state, method.method);
+        lua_rawset(state, -3);
+    }
+
+    lua_setglobal(state, "git");
+}
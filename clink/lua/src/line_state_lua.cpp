@@ -29,6 +29,7 @@ const line_state_lua::method line_state_lua::c_methods[] = {
     { "_unbreak_word",          &unbreak_word },
     { "_set_alias",             &set_alias },
     { "_overwrite_from",        &overwrite_from },
+    { "_getwordinfo_cached",    &get_word_info_cached },
     {}
 };
 
@@ -154,6 +155,30 @@ line_state_lua::~line_state_lua()
     delete m_copy;
 }
 
+//------------------------------------------------------------------------------
+// The word info cache lives in the userdata's uservalue, so it shares the
+// lifetime of the Lua object.  Word indices are absolute (not shifted), so
+// shifting does not invalidate the cache; only changing the underlying words
+// does.
+void line_state_lua::push_word_info_cache(lua_State* state)
+{
+    lua_getuservalue(state, LUA_SELF);
+    if (lua_isnil(state, -1))
+    {
+        lua_pop(state, 1);
+        lua_createtable(state, m_line->get_word_count(), 0);
+        lua_pushvalue(state, -1);
+        lua_setuservalue(state, LUA_SELF);
+    }
+}
+
+//------------------------------------------------------------------------------
+void line_state_lua::clear_cache(lua_State* state)
+{
+    lua_pushnil(state);
+    lua_setuservalue(state, LUA_SELF);
+}
+
 //------------------------------------------------------------------------------
 /// -name:  line_state:getline
 /// -ver:   1.0.0
@@ -283,8 +308,41 @@ int32 line_state_lua::get_word_info(lua_State* state)
     if (index >= words.size())
         return 0;
 
-    const word& word = words[index];
+    push_word_info(state, words[index]);
+    return 1;
+}
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Same as getwordinfo(), but returns the same table each time for a given word.
+// Argmatchers look at the same words many times while parsing a line, and this
+// avoids making a new table each time.  The table must not be modified.
+int32 line_state_lua::get_word_info_cached(lua_State* state)
+{
+    if (!lua_isnumber(state, LUA_SELF + 1))
+        return 0;
+
+    const std::vector<word>& words = m_line->get_words();
+    uint32 index = int32(lua_tointeger(state, LUA_SELF + 1)) - 1 + m_shift;
+    if (index >= words.size())
+        return 0;
+
+    push_word_info_cache(state);
+    lua_rawgeti(state, -1, index + 1);
+    if (lua_isnil(state, -1))
+    {
+        lua_pop(state, 1);
+        push_word_info(state, words[index]);
+        lua_pushvalue(state, -1);
+        lua_rawseti(state, -3, index + 1);
+    }
+    lua_replace(state, -2);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void line_state_lua::push_word_info(lua_State* state, const word& word)
+{
     lua_createtable(state, 0, 6);
 
     lua_pushliteral(state, "offset");
@@ -317,8 +375,6 @@ int32 line_state_lua::get_word_info(lua_State* state)
         lua_pushboolean(state, true);
         lua_rawset(state, -3);
     }
-
-    return 1;
 }
 
 //------------------------------------------------------------------------------
@@ -611,6 +667,7 @@ int32 line_state_lua::overwrite_from(lua_State* state)
 
     const bool ok = const_cast<line_state*>(m_line)->overwrite_from(from->m_line);
     assert(ok);
+    clear_cache(state);
     lua_pushboolean(state, ok);
     return 1;
 }
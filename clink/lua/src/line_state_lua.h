@@ -6,6 +6,7 @@
 #include "lua_bindable.h"
 
 class line_state;
+struct word;
 class line_state_copy;
 struct lua_State;
 
@@ -41,8 +42,13 @@ protected:
     int32               unbreak_word(lua_State* state);
     int32               overwrite_from(lua_State* state);
     int32               set_alias(lua_State* state);
+    int32               get_word_info_cached(lua_State* state);
 
 private:
+    void                push_word_info_cache(lua_State* state);
+    static void         push_word_info(lua_State* state, const word& word);
+    void                clear_cache(lua_State* state);
+
     const line_state*   m_line;
     line_state_copy*    m_copy;
     uint32              m_shift = 0;
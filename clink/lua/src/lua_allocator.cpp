@@ -0,0 +1,393 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_allocator.h"
+
+#include <core/base.h>
+#include <core/debugheap.h>
+#include <terminal/printer.h>
+
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+// Chunks are allocated with VirtualAlloc, so they're aligned to the 64KB
+// allocation granularity, and the chunk that owns a block can be found by
+// masking the block's address.
+static const size_t c_chunk_size = 64 * 1024;
+static const size_t c_granularity = 16;
+static const size_t c_max_small = 256;
+static const uint32 c_num_classes = c_max_small / c_granularity;
+static const uint32 c_max_spares = 16;
+
+//------------------------------------------------------------------------------
+struct pool_chunk
+{
+    pool_chunk*     next;           // In its class's available list, or spares.
+    pool_chunk*     prev;
+    void*           free_list;      // Free blocks in this chunk.
+    char*           bump;           // Next never used block.
+    uint32          live;
+    uint32          size_class;
+    bool            available;
+};
+
+static const size_t c_header_size = (sizeof(pool_chunk) + c_granularity - 1) & ~(c_granularity - 1);
+
+//------------------------------------------------------------------------------
+// Shared by all Lua states, which must all be used on the same thread; see
+// lua_allocator.h.
+static pool_chunk* s_available[c_num_classes];
+static pool_chunk* s_spares = nullptr;
+static lua_alloc_stats s_stats;
+static bool s_in_idle_gc = false;
+
+
+
+//------------------------------------------------------------------------------
+static inline uint32 size_class(size_t size)
+{
+    return uint32((size - 1) / c_granularity);
+}
+
+//------------------------------------------------------------------------------
+static inline size_t class_size(uint32 cls)
+{
+    return (cls + 1) * c_granularity;
+}
+
+//------------------------------------------------------------------------------
+static inline pool_chunk* chunk_from_block(void* p)
+{
+    return reinterpret_cast<pool_chunk*>(uintptr_t(p) & ~uintptr_t(c_chunk_size - 1));
+}
+
+//------------------------------------------------------------------------------
+static void link(pool_chunk*& head, pool_chunk* c)
+{
+    c->prev = nullptr;
+    c->next = head;
+    if (head)
+        head->prev = c;
+    head = c;
+}
+
+//------------------------------------------------------------------------------
+static void unlink(pool_chunk*& head, pool_chunk* c)
+{
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        head = c->next;
+    if (c->next)
+        c->next->prev = c->prev;
+    c->next = c->prev = nullptr;
+}
+
+//------------------------------------------------------------------------------
+static bool is_full(const pool_chunk* c)
+{
+    return !c->free_list && c->bump + class_size(c->size_class) > reinterpret_cast<const char*>(c) + c_chunk_size;
+}
+
+//------------------------------------------------------------------------------
+static void release_chunk(pool_chunk* c)
+{
+    VirtualFree(c, 0, MEM_RELEASE);
+    s_stats.chunks--;
+    s_stats.chunk_bytes -= c_chunk_size;
+}
+
+//------------------------------------------------------------------------------
+static pool_chunk* new_chunk(uint32 cls)
+{
+    pool_chunk* c = s_spares;
+    if (c)
+    {
+        unlink(s_spares, c);
+        s_stats.spare_chunks--;
+    }
+    else
+    {
+        c = static_cast<pool_chunk*>(VirtualAlloc(nullptr, c_chunk_size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE));
+        if (!c)
+            return nullptr;
+        assert(chunk_from_block(c) == c);
+        s_stats.chunks++;
+        s_stats.chunk_bytes += c_chunk_size;
+        s_stats.peak_chunks = max(s_stats.peak_chunks, s_stats.chunks);
+    }
+
+    c->free_list = nullptr;
+    c->bump = reinterpret_cast<char*>(c) + c_header_size;
+    c->live = 0;
+    c->size_class = cls;
+    c->available = true;
+    link(s_available[cls], c);
+    return c;
+}
+
+//------------------------------------------------------------------------------
+static void* alloc_small(size_t size)
+{
+    const uint32 cls = size_class(size);
+    pool_chunk* c = s_available[cls];
+    if (!c)
+    {
+        c = new_chunk(cls);
+        if (!c)
+            return nullptr;
+    }
+
+    void* p;
+    if (c->free_list)
+    {
+        p = c->free_list;
+        c->free_list = *static_cast<void**>(p);
+    }
+    else
+    {
+        p = c->bump;
+        c->bump += class_size(cls);
+    }
+
+    c->live++;
+    if (is_full(c))
+    {
+        unlink(s_available[cls], c);
+        c->available = false;
+    }
+
+    s_stats.small_in_use += size;
+    s_stats.small_capacity += class_size(cls);
+    return p;
+}
+
+//------------------------------------------------------------------------------
+static void free_small(void* p, size_t size)
+{
+    pool_chunk* c = chunk_from_block(p);
+    assert(c->live);
+    assert(size_class(size) == c->size_class);
+
+    *static_cast<void**>(p) = c->free_list;
+    c->free_list = p;
+    c->live--;
+
+    s_stats.small_in_use -= size;
+    s_stats.small_capacity -= class_size(c->size_class);
+
+    if (!c->live)
+    {
+        // Keep a few empty chunks so that churn while editing a line doesn't
+        // keep reserving and releasing memory.
+        if (c->available)
+            unlink(s_available[c->size_class], c);
+        if (s_stats.spare_chunks < c_max_spares)
+        {
+            link(s_spares, c);
+            s_stats.spare_chunks++;
+        }
+        else
+        {
+            release_chunk(c);
+        }
+    }
+    else if (!c->available)
+    {
+        link(s_available[c->size_class], c);
+        c->available = true;
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+void* lua_pool_realloc(void* ptr, size_t osize, size_t nsize)
+{
+    const bool was_small = (ptr && osize && osize <= c_max_small);
+    const bool is_small = (nsize && nsize <= c_max_small);
+
+    if (!nsize)
+    {
+        if (ptr)
+        {
+            if (was_small)
+                free_small(ptr, osize);
+            else
+            {
+                free(ptr);
+                s_stats.large_in_use -= osize;
+            }
+        }
+        return nullptr;
+    }
+
+    if (was_small && is_small && size_class(osize) == size_class(nsize))
+    {
+        s_stats.small_in_use += nsize;
+        s_stats.small_in_use -= osize;
+        return ptr;
+    }
+
+    if (ptr && !was_small && !is_small)
+    {
+        void* p = realloc(ptr, nsize);
+        if (p)
+        {
+            s_stats.large_in_use += nsize;
+            s_stats.large_in_use -= osize;
+        }
+        return p;
+    }
+
+    // The block is new, or moves between the pools and the heap, or between
+    // size classes.
+    void* p = is_small ? alloc_small(nsize) : malloc(nsize);
+    if (!p)
+        return nullptr;
+    if (!is_small)
+        s_stats.large_in_use += nsize;
+
+    if (ptr)
+    {
+        memcpy(p, ptr, min(osize, nsize));
+        if (was_small)
+            free_small(ptr, osize);
+        else
+        {
+            free(ptr);
+            s_stats.large_in_use -= osize;
+        }
+    }
+    return p;
+}
+
+//------------------------------------------------------------------------------
+#ifdef USE_MEMORY_TRACKING
+extern "C" DECLALLOCATOR DECLRESTRICT void* __cdecl dbgluarealloc(void* pv, size_t size);
+#endif
+
+//------------------------------------------------------------------------------
+void* lua_pool_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    // When ptr is null, osize is a type tag rather than a size.
+    if (!ptr)
+        osize = 0;
+
+    if (!ptr && nsize)
+        s_stats.allocs++;
+    else if (ptr && !nsize)
+        s_stats.frees++;
+
+    if (nsize > osize)
+    {
+        s_stats.allocated += nsize - osize;
+        s_stats.allocated_line += nsize - osize;
+    }
+    else if (osize > nsize)
+    {
+        // Nearly all frees come from the garbage collector.
+        s_stats.freed += osize - nsize;
+        if (s_in_idle_gc)
+            s_stats.idle_freed += osize - nsize;
+    }
+
+#ifdef USE_MEMORY_TRACKING
+    // Let the debug heap see every allocation, so leak tracking still works.
+    // The pools themselves are still exercised directly by the tests through
+    // lua_pool_realloc().
+    if (!nsize)
+    {
+        free(ptr);
+        return nullptr;
+    }
+    return dbgluarealloc(ptr, nsize);
+#else
+    return lua_pool_realloc(ptr, osize, nsize);
+#endif
+}
+
+//------------------------------------------------------------------------------
+void trim_lua_allocator()
+{
+    while (pool_chunk* c = s_spares)
+    {
+        unlink(s_spares, c);
+        s_stats.spare_chunks--;
+        release_chunk(c);
+    }
+    s_stats.allocated_line = 0;
+}
+
+//------------------------------------------------------------------------------
+void get_lua_alloc_stats(lua_alloc_stats& stats)
+{
+    stats = s_stats;
+}
+
+//------------------------------------------------------------------------------
+void begin_lua_idle_gc()
+{
+    assert(!s_in_idle_gc);
+    s_in_idle_gc = true;
+}
+
+//------------------------------------------------------------------------------
+void end_lua_idle_gc(double elapsed, bool finished_cycle)
+{
+    assert(s_in_idle_gc);
+    s_in_idle_gc = false;
+    s_stats.idle_gc_time += elapsed;
+    s_stats.idle_gc_passes++;
+    if (finished_cycle)
+        s_stats.idle_gc_cycles++;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator_diagnostics()
+{
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+
+    const lua_alloc_stats& stats = s_stats;
+    if (!stats.allocs && !stats.allocated)
+        return;
+
+    str<> s;
+    s.format("%slua memory:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+
+    const uint32 spacing = 16;
+    auto print_value = [&](const char* name, const char* value)
+    {
+        str<> line;
+        line.format("  %-*s  %s\n", spacing, name, value);
+        g_printer->print(line.c_str(), line.length());
+    };
+
+    s.format("%zu KB (pooled %zu KB, heap %zu KB)",
+             (stats.small_in_use + stats.large_in_use) / 1024,
+             stats.small_in_use / 1024, stats.large_in_use / 1024);
+    print_value("in use", s.c_str());
+
+    // Fragmentation counts both rounding up to the size class, and unused
+    // blocks in partly used chunks.
+    const size_t reserved = stats.chunk_bytes - stats.spare_chunks * c_chunk_size;
+    const uint32 fragmentation = reserved ? uint32(100 - (stats.small_in_use * 100) / reserved) : 0;
+    s.format("%u chunks (peak %u, %u spare), %u%% fragmentation",
+             stats.chunks, stats.peak_chunks, stats.spare_chunks, fragmentation);
+    print_value("pools", s.c_str());
+
+    // Allocation volume is what drives the garbage collector.
+    s.format("%llu allocs, %llu frees, %llu KB total, %llu KB this line",
+             stats.allocs, stats.frees, stats.allocated / 1024, stats.allocated_line / 1024);
+    print_value("gc pressure", s.c_str());
+
+    // Frees outside of idle collection happened during allocation, i.e. on
+    // the hot path while handling input.
+    s.format("%llu KB at idle (%u passes, %u cycles, %.1f ms), %llu KB on the hot path",
+             stats.idle_freed / 1024, stats.idle_gc_passes, stats.idle_gc_cycles,
+             stats.idle_gc_time * 1000, (stats.freed - stats.idle_freed) / 1024);
+    print_value("gc freed", s.c_str());
+}
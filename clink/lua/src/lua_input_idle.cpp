@@ -6,8 +6,12 @@
 #include "lua_state.h"
 #include "lua_task_manager.h"
 #include "async_lua_task.h"
+#include "coroutine_scheduler.h"
+#include "lua_allocator.h"
 
 #include <core/base.h>
+#include <core/os.h>
+#include <core/settings.h>
 #include <lib/reclassify.h>
 #include <lib/line_editor_integration.h>
 #include <lib/display_readline.h>
@@ -20,6 +24,39 @@ extern "C" {
 #include <lualib.h>
 }
 
+//------------------------------------------------------------------------------
+static setting_int g_gc_idle_budget(
+    "lua.gc_idle_budget",
+    "Milliseconds per idle garbage collection pass",
+    "While waiting for input, Clink runs the Lua garbage collector in steps for\n"
+    "up to this many milliseconds at a time, so that collection mostly happens\n"
+    "between keystrokes instead of while generating matches or classifying the\n"
+    "input line.  Set this to 0 to let Lua collect garbage on its own schedule.",
+    5);
+
+static setting_int g_gc_typing_pause(
+    "lua.gc_typing_pause",
+    "Garbage collector pause while typing",
+    "When lua.gc_idle_budget is enabled, Lua waits until memory use grows by this\n"
+    "percentage before it starts a collection cycle on its own.  Larger values\n"
+    "defer more of the collection work to idle time, at the cost of using more\n"
+    "memory.  Lua's own default is 200.",
+    400);
+
+//------------------------------------------------------------------------------
+// Idle collection starts after input pauses for c_gc_idle_delay, and runs
+// another pass every c_gc_continue_delay until the cycle finishes.  Like
+// Lua's own pause, it only starts once the bytes allocated since the last
+// cycle finished reach c_gc_idle_pause percent of the heap that survived that
+// cycle (but at least c_gc_min_threshold bytes), so a large heap isn't fully
+// traversed after every little bit of typing.
+const DWORD c_gc_idle_delay = 50;
+const DWORD c_gc_continue_delay = 5;
+const uint64 c_gc_min_threshold = 64 * 1024;
+const uint64 c_gc_idle_pause = 50;
+const int32 c_gc_step_kb = 16;
+const int32 c_gc_default_pause = 200;
+
 //------------------------------------------------------------------------------
 static lua_input_idle* s_idle = nullptr;
 
@@ -43,6 +80,7 @@ const DWORD c_terminal_resize_refilter_delay = 500;
 //------------------------------------------------------------------------------
 lua_input_idle::lua_input_idle(lua_state& state)
 : m_state(state)
+, m_gc_threshold(c_gc_min_threshold)
 {
     assert(!s_idle);
     s_idle = this;
@@ -62,6 +100,11 @@ void lua_input_idle::reset()
 
     m_enabled = true;
     m_iterations = 0;
+
+    // Defer automatic collection while typing, so that it mostly happens in
+    // idle passes instead.
+    const int32 pause = (g_gc_idle_budget.get() > 0) ? max<int32>(g_gc_typing_pause.get(), c_gc_default_pause) : c_gc_default_pause;
+    lua_gc(m_state.get_state(), LUA_GCSETPAUSE, pause);
 }
 
 //------------------------------------------------------------------------------
@@ -99,26 +142,21 @@ uint32 lua_input_idle::get_timeout()
     {
         m_iterations++;
 
-        lua_State* state = m_state.get_state();
-        save_stack_top ss(state);
-
-        // Call to Lua to check for coroutines.
-        lua_getglobal(state, "clink");
-        lua_pushliteral(state, "_wait_duration");
-        lua_rawget(state, -2);
-
-        if (m_state.pcall(state, 0, 1) == 0)
+        double sec;
+        coroutine_scheduler* scheduler = m_state.get_scheduler();
+        if (scheduler && scheduler->get_wait_duration(os::clock(), sec))
         {
-            int32 isnum;
-            double sec = lua_tonumberx(state, -1, &isnum);
-            if (isnum)
-            {
-                const DWORD t = (sec > 0) ? uint32(sec * 1000) : 0;
-                timeout = min(timeout, t);
-            }
+            const DWORD t = (sec > 0) ? uint32(sec * 1000) : 0;
+            timeout = min(timeout, t);
         }
     }
 
+    if (is_gc_pending())
+    {
+        const DWORD t = m_gc_stepping ? c_gc_continue_delay : c_gc_idle_delay;
+        timeout = min(timeout, t);
+    }
+
     return timeout;
 }
 
@@ -205,6 +243,8 @@ void lua_input_idle::on_idle()
             host_clear_input_hint_timeout();
         reclassify(reason);
     }
+
+    collect_garbage();
 }
 
 //------------------------------------------------------------------------------
@@ -255,28 +295,68 @@ void signal_terminal_resized()
 //------------------------------------------------------------------------------
 bool lua_input_idle::has_coroutines()
 {
+    coroutine_scheduler* scheduler = m_state.get_scheduler();
+    return scheduler && scheduler->has_coroutines();
+}
+
+//------------------------------------------------------------------------------
+bool lua_input_idle::is_gc_pending() const
+{
+    if (g_gc_idle_budget.get() <= 0)
+        return false;
+
+    lua_alloc_stats stats;
+    get_lua_alloc_stats(stats);
+    return stats.allocated - m_gc_mark >= m_gc_threshold;
+}
+
+//------------------------------------------------------------------------------
+void lua_input_idle::collect_garbage()
+{
+    if (!is_gc_pending())
+    {
+        m_gc_stepping = false;
+        return;
+    }
+
     lua_State* state = m_state.get_state();
-    save_stack_top ss(state);
+    const double begin = os::clock();
+    const double end = begin + double(g_gc_idle_budget.get()) / 1000;
 
-    // Call to Lua to check for coroutines.
-    lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_has_coroutines");
-    lua_rawget(state, -2);
+    bool finished = false;
+    begin_lua_idle_gc();
+    do
+    {
+        finished = !!lua_gc(state, LUA_GCSTEP, c_gc_step_kb);
+    }
+    while (!finished && os::clock() < end);
+    end_lua_idle_gc(os::clock() - begin, finished);
 
-    if (m_state.pcall(state, 0, 1) != 0)
-        return false;
+    m_gc_stepping = !finished;
+    if (finished)
+    {
+        lua_alloc_stats stats;
+        get_lua_alloc_stats(stats);
+        m_gc_mark = stats.allocated;
 
-    bool has = lua_toboolean(state, -1);
-    return has;
+        const uint64 live = (uint64(lua_gc(state, LUA_GCCOUNT, 0)) << 10) + lua_gc(state, LUA_GCCOUNTB, 0);
+        m_gc_threshold = max<uint64>(c_gc_min_threshold, live * c_gc_idle_pause / 100);
+    }
 }
 
 //------------------------------------------------------------------------------
 void lua_input_idle::resume_coroutines()
 {
+    // Only call into Lua when a coroutine is due, or when a coroutine is
+    // waiting and might have been woken by whatever woke idle processing.
+    coroutine_scheduler* scheduler = m_state.get_scheduler();
+    if (!scheduler || (!scheduler->has_waiting() && !scheduler->is_due(os::clock())))
+        return;
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
-    // Call to Lua to check for coroutines.
+    // Call to Lua to resume coroutines.
     lua_getglobal(state, "clink");
     lua_pushliteral(state, "_resume_coroutines");
     lua_rawget(state, -2);
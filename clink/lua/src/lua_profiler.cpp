@@ -0,0 +1,576 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_profiler.h"
+#include "lua_allocator.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/debugheap.h>
+#include <terminal/printer.h>
+
+#include <algorithm>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static setting_bool g_lua_profile(
+    "lua.profile",
+    "Profile Lua callbacks",
+    "When enabled, Clink measures the time, allocations, and garbage collection\n"
+    "work of each Lua callback (prompt filters, generators, classifiers, hinters,\n"
+    "suggesters, event handlers, coroutines, and delayinit functions), and samples\n"
+    "which script files are running.  The results are shown by the\n"
+    "clink-diagnostics command, and clink-diagnostics-output also writes them to\n"
+    "a clink.profile.json file.  This adds overhead, so leave it off normally.",
+    false);
+
+//------------------------------------------------------------------------------
+static const int32 c_sample_instructions = 1000;
+static const uint32 c_max_report_rows = 20;
+static const size_t c_max_depth = 256;
+static const size_t c_max_suspended = 256;
+
+
+
+//------------------------------------------------------------------------------
+static void* profiled_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    lua_profiler::get().on_alloc(osize, nsize, ptr != nullptr);
+    return lua_pool_alloc(ud, ptr, osize, nsize);
+}
+
+//------------------------------------------------------------------------------
+static void append_json_string(str_base& out, const char* s)
+{
+    out << "\"";
+    for (; *s; ++s)
+    {
+        const uint8 c = uint8(*s);
+        if (c == '"' || c == '\\')
+        {
+            const char esc[] = { '\\', char(c), '\0' };
+            out << esc;
+        }
+        else if (c < ' ')
+        {
+            str<16> tmp;
+            tmp.format("\\u%04x", c);
+            out << tmp;
+        }
+        else
+        {
+            out.concat(s, 1);
+        }
+    }
+    out << "\"";
+}
+
+//------------------------------------------------------------------------------
+static void append_json_counters(str_base& out, const char* sep, uint32 calls, double total, double self, uint64 allocs, uint64 alloc_bytes, uint64 freed_bytes, uint32 samples)
+{
+    str<> tmp;
+    tmp.format("%s\"calls\":%u,\"total_ms\":%.3f,\"self_ms\":%.3f,\"allocs\":%llu,\"alloc_bytes\":%llu,\"freed_bytes\":%llu,\"samples\":%u",
+               sep, calls, total * 1000, self * 1000, allocs, alloc_bytes, freed_bytes, samples);
+    out << tmp;
+}
+
+
+
+//------------------------------------------------------------------------------
+void lua_profiler::counters::add(const counters& other)
+{
+    calls += other.calls;
+    total += other.total;
+    self += other.self;
+    peak = max(peak, other.peak);
+    allocs += other.allocs;
+    alloc_bytes += other.alloc_bytes;
+    freed_bytes += other.freed_bytes;
+    samples += other.samples;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::entry::percentiles(double& p50, double& p90, double& p99) const
+{
+    p50 = p90 = p99 = 0;
+    if (!num_recent)
+        return;
+
+    float sorted[c_recent];
+    memcpy(sorted, recent, num_recent * sizeof(*recent));
+    std::sort(sorted, sorted + num_recent);
+
+    auto at = [&](uint32 percent) {
+        return double(sorted[min<uint32>((num_recent * percent) / 100, num_recent - 1)]);
+    };
+    p50 = at(50);
+    p90 = at(90);
+    p99 = at(99);
+}
+
+
+
+//------------------------------------------------------------------------------
+lua_profiler& lua_profiler::get()
+{
+    static lua_profiler s_profiler;
+    return s_profiler;
+}
+
+//------------------------------------------------------------------------------
+lua_profiler::lua_profiler()
+: m_clock(&os::clock)
+{
+}
+
+//------------------------------------------------------------------------------
+bool lua_profiler::is_enabled() const
+{
+    return m_force_enabled || g_lua_profile.get();
+}
+
+//------------------------------------------------------------------------------
+// Installs or removes the allocator wrapper and the sampling hook to match the
+// setting, so that disabled profiling adds no cost.  Returns whether profiling
+// is enabled.
+bool lua_profiler::install(lua_State* L)
+{
+    const bool enabled = is_enabled();
+
+    void* ud;
+    const lua_Alloc alloc = lua_getallocf(L, &ud);
+    if (enabled && alloc == lua_pool_alloc)
+        lua_setallocf(L, profiled_alloc, ud);
+    else if (!enabled && alloc == profiled_alloc)
+        lua_setallocf(L, lua_pool_alloc, ud);
+
+    // Don't displace the debugger's hook.  Coroutines inherit the hook from
+    // the thread that creates them.
+    const lua_Hook hook = lua_gethook(L);
+    if (enabled && !hook)
+        lua_sethook(L, sample_hook, LUA_MASKCOUNT, c_sample_instructions);
+    else if (!enabled && hook == sample_hook)
+        lua_sethook(L, nullptr, 0, 0);
+
+    if (!enabled)
+        clear_frames();
+    return enabled;
+}
+
+//------------------------------------------------------------------------------
+uint32 lua_profiler::enter(lua_State* L, const char* category, int32 func_index)
+{
+    if (!is_enabled())
+    {
+        clear_frames();
+        return 0;
+    }
+
+    entry* e = find_entry(L, category, func_index);
+    if (!e)
+        return 0;
+
+    // Frames abandoned by coroutines that never finish shouldn't accumulate.
+    if (m_stack.size() >= c_max_depth)
+        m_stack.clear();
+
+    if (!++m_next_token)
+        ++m_next_token;
+
+    dbg_ignore_scope(snapshot, "Lua profiler");
+    m_stack.push_back({ e, m_next_token, now() });
+    return m_next_token;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::leave(uint32 token)
+{
+    // A callback that throws an error never reaches its leave, so this also
+    // closes any frames that were abandoned above the token's frame.  If the
+    // token isn't found (e.g. profiling was turned off meanwhile), it's
+    // ignored.
+    size_t depth = m_stack.size();
+    while (depth && m_stack[depth - 1].token != token)
+        --depth;
+    if (!token || !depth)
+        return;
+
+    close_frames(depth - 1, now());
+}
+
+//------------------------------------------------------------------------------
+// Called before resuming a coroutine, with the value suspend() returned when
+// the coroutine last yielded.  Restores the coroutine's frames on top of the
+// stack, excluding the time spent suspended.  Returns the depth to pass to
+// suspend() after the coroutine yields or finishes.
+uint32 lua_profiler::resume(uint32 suspended)
+{
+    const uint32 depth = uint32(m_stack.size());
+
+    const auto it = suspended ? m_suspended.find(suspended) : m_suspended.end();
+    if (it == m_suspended.end())
+        return depth;
+
+    const double shift = now() - it->second.when;
+    dbg_ignore_scope(snapshot, "Lua profiler");
+    for (frame& f : it->second.frames)
+    {
+        f.start += shift;
+        m_stack.push_back(f);
+    }
+    m_suspended.erase(it);
+    return depth;
+}
+
+//------------------------------------------------------------------------------
+// Called after resuming a coroutine, with the depth resume() returned.  The
+// frames above depth belong to the coroutine.  If it yielded, they're set
+// aside until the next resume(), and the return value identifies them.  If it
+// finished, any frames it abandoned because of an error are closed.
+uint32 lua_profiler::suspend(uint32 depth, bool dead)
+{
+    if (depth >= m_stack.size())
+        return 0;
+
+    if (dead)
+    {
+        close_frames(depth, now());
+        return 0;
+    }
+
+    // Coroutines that are abandoned while suspended never come back.
+    if (m_suspended.size() >= c_max_suspended)
+        m_suspended.clear();
+
+    if (!++m_next_suspended)
+        ++m_next_suspended;
+
+    const double when = now();
+
+    // The outermost of the coroutine's frames has run since it was resumed,
+    // and that time belongs to the resumer's frame as well.
+    if (depth > 0)
+    {
+        frame& bottom = m_stack[depth];
+        const double portion = (when - bottom.start) - bottom.credited;
+        bottom.credited += portion;
+        m_stack[depth - 1].children += portion;
+    }
+
+    dbg_ignore_scope(snapshot, "Lua profiler");
+    suspended_frames& s = m_suspended[m_next_suspended];
+    s.when = when;
+    s.frames.assign(m_stack.begin() + depth, m_stack.end());
+    m_stack.resize(depth);
+    return m_next_suspended;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::close_frames(size_t keep, double now)
+{
+    while (m_stack.size() > keep)
+    {
+        const frame f = m_stack.back();
+        m_stack.pop_back();
+
+        const double elapsed = now - f.start;
+        entry* e = f.e;
+        e->c.calls++;
+        e->c.total += elapsed;
+        e->c.self += max<double>(elapsed - f.children, 0);
+        e->c.peak = max(e->c.peak, elapsed);
+        e->recent[e->next_recent] = float(elapsed * 1000);
+        e->next_recent = (e->next_recent + 1) % c_recent;
+        e->num_recent = min<uint32>(e->num_recent + 1, c_recent);
+
+        if (!m_stack.empty())
+            m_stack.back().children += max<double>(elapsed - f.credited, 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::clear_frames()
+{
+    m_stack.clear();
+    m_suspended.clear();
+}
+
+//------------------------------------------------------------------------------
+bool lua_profiler::get_counters(const char* category, uint32& calls, double& total, double& self) const
+{
+    calls = 0;
+    total = self = 0;
+
+    bool found = false;
+    for (const auto& e : m_entries)
+    {
+        if (e->category.equals(category))
+        {
+            calls += e->c.calls;
+            total += e->c.total;
+            self += e->c.self;
+            found = true;
+        }
+    }
+    return found;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::on_alloc(size_t osize, size_t nsize, bool had_ptr)
+{
+    if (!is_enabled())
+        return;
+
+    counters& c = m_stack.empty() ? m_unattributed : m_stack.back().e->c;
+
+    // When ptr is null, osize is a type tag rather than a size.
+    if (!had_ptr)
+        osize = 0;
+
+    if (nsize > osize)
+    {
+        c.allocs++;
+        c.alloc_bytes += nsize - osize;
+    }
+    else if (osize > nsize)
+    {
+        c.freed_bytes += osize - nsize;
+    }
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::sample_hook(lua_State* L, lua_Debug* ar)
+{
+    if (ar->event != LUA_HOOKCOUNT)
+        return;
+
+    lua_profiler& profiler = get();
+    if (!profiler.is_enabled() || !lua_getinfo(L, "S", ar))
+        return;
+
+    const char* source = (ar->source[0] == '@') ? ar->source + 1 : ar->short_src;
+
+    profiler.m_total_samples++;
+    if (!profiler.m_stack.empty())
+        profiler.m_stack.back().e->c.samples++;
+
+    auto it = profiler.m_samples.find(source);
+    if (it != profiler.m_samples.end())
+    {
+        it->second++;
+        return;
+    }
+
+    dbg_ignore_scope(snapshot, "Lua profiler");
+    profiler.m_sample_keys.emplace_back(std::make_unique<str_moveable>(source));
+    profiler.m_samples.emplace(profiler.m_sample_keys.back()->c_str(), 1);
+}
+
+//------------------------------------------------------------------------------
+lua_profiler::entry* lua_profiler::find_entry(lua_State* L, const char* category, int32 func_index)
+{
+    if (!lua_isfunction(L, func_index))
+        return nullptr;
+
+    lua_Debug ar;
+    lua_pushvalue(L, func_index);
+    if (!lua_getinfo(L, ">S", &ar))
+        return nullptr;
+
+    const char* source = (ar.source[0] == '@') ? ar.source + 1 : ar.short_src;
+
+    str<> key;
+    key.format("%s\t%s:%d", category, source, ar.linedefined);
+
+    auto it = m_map.find(key.c_str());
+    if (it != m_map.end())
+        return it->second;
+
+    dbg_ignore_scope(snapshot, "Lua profiler");
+
+    std::unique_ptr<entry> e = std::make_unique<entry>();
+    e->key = key.c_str();
+    e->category = category;
+    e->source = source;
+    e->name.format("%s:%d", path::get_name(source), ar.linedefined);
+
+    entry* raw = e.get();
+    m_entries.emplace_back(std::move(e));
+    m_map.emplace(raw->key.c_str(), raw);
+    return raw;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::collect_sources(std::vector<std::pair<const char*, counters>>& out) const
+{
+    // Sources are the union of sampled files and files that define profiled
+    // callbacks.
+    str_unordered_map<size_t> index;
+    auto lookup = [&](const char* source) -> counters& {
+        auto it = index.find(source);
+        if (it != index.end())
+            return out[it->second].second;
+        index.emplace(source, out.size());
+        out.emplace_back(source, counters());
+        return out.back().second;
+    };
+
+    for (const auto& e : m_entries)
+    {
+        counters c = e->c;
+        c.samples = 0;
+        lookup(e->source.c_str()).add(c);
+    }
+
+    for (const auto& s : m_samples)
+        lookup(s.first).samples += s.second;
+
+    std::sort(out.begin(), out.end(), [](const std::pair<const char*, counters>& a, const std::pair<const char*, counters>& b) {
+        if (a.second.samples != b.second.samples)
+            return a.second.samples > b.second.samples;
+        return a.second.self > b.second.self;
+    });
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::diagnostics()
+{
+    if (m_entries.empty() && !m_total_samples)
+        return;
+
+    static char bold[] = "\x1b[1m";
+    static char norm[] = "\x1b[m";
+    static char dark[] = "\x1b[90m";
+
+    str<> s;
+
+    s.format("%slua profile:%s\n", bold, norm);
+    g_printer->print(s.c_str(), s.length());
+    s.format("  %s%-10s %-28s %6s %9s %9s %8s %8s %8s %8s %10s%s\n",
+             dark, "category", "callback", "calls", "self ms", "total ms",
+             "p50 ms", "p90 ms", "p99 ms", "allocs", "gc freed", norm);
+    g_printer->print(s.c_str(), s.length());
+
+    std::vector<const entry*> sorted;
+    for (const auto& e : m_entries)
+        sorted.push_back(e.get());
+    std::sort(sorted.begin(), sorted.end(), [](const entry* a, const entry* b) {
+        return a->c.self > b->c.self;
+    });
+
+    for (uint32 i = 0; i < sorted.size() && i < c_max_report_rows; ++i)
+    {
+        const entry* e = sorted[i];
+        double p50, p90, p99;
+        e->percentiles(p50, p90, p99);
+        s.format("  %-10s %-28s %6u %9.2f %9.2f %8.2f %8.2f %8.2f %8llu %9lluK\n",
+                 e->category.c_str(), e->name.c_str(), e->c.calls,
+                 e->c.self * 1000, e->c.total * 1000, p50, p90, p99,
+                 e->c.allocs, e->c.freed_bytes / 1024);
+        g_printer->print(s.c_str(), s.length());
+    }
+    if (sorted.size() > c_max_report_rows)
+    {
+        s.format("  %s... %u more%s\n", dark, uint32(sorted.size() - c_max_report_rows), norm);
+        g_printer->print(s.c_str(), s.length());
+    }
+
+    std::vector<std::pair<const char*, counters>> sources;
+    collect_sources(sources);
+
+    s.format("  %s%-40s %8s %9s %8s %10s %10s%s\n",
+             dark, "script", "samples", "self ms", "allocs", "alloc", "gc freed", norm);
+    g_printer->print(s.c_str(), s.length());
+    for (uint32 i = 0; i < sources.size() && i < c_max_report_rows; ++i)
+    {
+        const counters& c = sources[i].second;
+        const uint32 percent = m_total_samples ? (c.samples * 100) / m_total_samples : 0;
+        s.format("  %-40s %5u %2u%% %9.2f %8llu %9lluK %9lluK\n",
+                 path::get_name(sources[i].first), c.samples, percent, c.self * 1000,
+                 c.allocs, c.alloc_bytes / 1024, c.freed_bytes / 1024);
+        g_printer->print(s.c_str(), s.length());
+    }
+
+    s.format("  %-40s %8s %9s %8llu %9lluK %9lluK\n", "(outside callbacks)", "", "",
+             m_unattributed.allocs, m_unattributed.alloc_bytes / 1024, m_unattributed.freed_bytes / 1024);
+    g_printer->print(s.c_str(), s.length());
+}
+
+//------------------------------------------------------------------------------
+bool lua_profiler::dump(const char* file)
+{
+    if (m_entries.empty() && !m_total_samples)
+        return false;
+
+    str_moveable out;
+    str<> tmp;
+
+    tmp.format("{\"version\":1,\"sample_instructions\":%d,\"total_samples\":%u,\n\"callbacks\":[", c_sample_instructions, m_total_samples);
+    out << tmp;
+
+    const char* sep = "\n";
+    for (const auto& e : m_entries)
+    {
+        double p50, p90, p99;
+        e->percentiles(p50, p90, p99);
+
+        out << sep << "{\"category\":";
+        append_json_string(out, e->category.c_str());
+        out << ",\"name\":";
+        append_json_string(out, e->name.c_str());
+        out << ",\"source\":";
+        append_json_string(out, e->source.c_str());
+        append_json_counters(out, ",", e->c.calls, e->c.total, e->c.self, e->c.allocs, e->c.alloc_bytes, e->c.freed_bytes, e->c.samples);
+        tmp.format(",\"peak_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f}", e->c.peak * 1000, p50, p90, p99);
+        out << tmp;
+        sep = ",\n";
+    }
+
+    out << "],\n\"sources\":[";
+
+    std::vector<std::pair<const char*, counters>> sources;
+    collect_sources(sources);
+
+    sep = "\n";
+    for (const auto& source : sources)
+    {
+        const counters& c = source.second;
+        out << sep << "{\"source\":";
+        append_json_string(out, source.first);
+        append_json_counters(out, ",", c.calls, c.total, c.self, c.allocs, c.alloc_bytes, c.freed_bytes, c.samples);
+        out << "}";
+        sep = ",\n";
+    }
+
+    out << "],\n\"unattributed\":{";
+    const counters& c = m_unattributed;
+    append_json_counters(out, "", c.calls, c.total, c.self, c.allocs, c.alloc_bytes, c.freed_bytes, c.samples);
+    out << "}}\n";
+
+    wstr<> wfile(file);
+    FILE* f = _wfopen(wfile.c_str(), L"wb");
+    if (!f)
+        return false;
+    const bool ok = (fwrite(out.c_str(), 1, out.length(), f) == out.length());
+    return (fclose(f) == 0) && ok;
+}
+
+
+
+//------------------------------------------------------------------------------
+void lua_profiler_diagnostics()
+{
+    lua_profiler::get().diagnostics();
+}
+
+//------------------------------------------------------------------------------
+bool lua_profiler_dump(const char* file)
+{
+    return lua_profiler::get().dump(file);
+}
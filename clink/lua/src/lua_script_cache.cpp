@@ -0,0 +1,231 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_script_cache.h"
+#include "../../app/src/version.h" // Ugh.
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <core/str_hash.h>
+#include <core/str_transform.h>
+
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+//------------------------------------------------------------------------------
+static setting_bool g_lua_cache_scripts(
+    "lua.cache_scripts",
+    "Cache precompiled Lua scripts",
+    "When enabled, Lua scripts are compiled once and the compiled form is saved\n"
+    "in the Clink state directory.  Later sessions load the saved form as long as\n"
+    "the script's timestamp and size are unchanged, which makes startup faster\n"
+    "when there are many or large scripts.",
+    true);
+
+
+
+//------------------------------------------------------------------------------
+static const char c_magic[8] = { 'C', 'L', 'K', 'L', 'U', 'A', 'C', '\0' };
+static const uint32 c_format = 1;
+
+//------------------------------------------------------------------------------
+struct cache_header
+{
+    char            magic[8];
+    uint32          format;
+    uint32          clink_version;
+    uint32          lua_version;
+    uint32          pointer_size;
+    uint64          mtime;
+    uint64          size;
+    uint32          path_len;       // Followed by the script's full path.
+    uint32          chunk_len;      // Followed by the compiled chunk.
+};
+
+//------------------------------------------------------------------------------
+static str_moveable s_cache_dir;
+static uint32 s_hits = 0;
+static uint32 s_misses = 0;
+
+
+
+//------------------------------------------------------------------------------
+static bool get_script_key(const char* path, str_base& full, uint64& mtime, uint64& size)
+{
+    if (!os::get_full_path_name(path, full))
+        return false;
+    path::normalise(full);
+
+    wstr<> wfull(full.c_str());
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wfull.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        return false;
+
+    mtime = (uint64(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    size = (uint64(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+    // Paths are case insensitive, so the key is too.
+    str<> lower;
+    str_transform(full.c_str(), full.length(), lower, transform_mode::lower);
+    full = lower.c_str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void get_cache_file(const char* key, str_base& out)
+{
+    str<16> name;
+    name.format("%08x.luac", str_hash(key));
+    out = s_cache_dir.c_str();
+    path::append(out, name.c_str());
+}
+
+//------------------------------------------------------------------------------
+static bool read_cache_file(const char* cache_file, const char* key, uint64 mtime, uint64 size, std::vector<char>& chunk)
+{
+    wstr<> wcache(cache_file);
+    FILE* file = _wfopen(wcache.c_str(), L"rb");
+    if (!file)
+        return false;
+
+    bool ok = false;
+    cache_header header;
+    const uint32 key_len = uint32(strlen(key));
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, c_magic, sizeof(c_magic)) == 0 &&
+        header.format == c_format &&
+        header.clink_version == CLINK_VERSION_ENCODED &&
+        header.lua_version == LUA_VERSION_NUM &&
+        header.pointer_size == sizeof(void*) &&
+        header.mtime == mtime &&
+        header.size == size &&
+        header.path_len == key_len)
+    {
+        // Different paths can hash to the same cache file, so compare the
+        // stored path as well.
+        std::vector<char> stored(key_len);
+        if (fread(stored.data(), 1, key_len, file) == key_len &&
+            memcmp(stored.data(), key, key_len) == 0)
+        {
+            chunk.resize(header.chunk_len);
+            ok = (fread(chunk.data(), 1, header.chunk_len, file) == header.chunk_len);
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static int32 chunk_writer(lua_State* L, const void* p, size_t sz, void* ud)
+{
+    auto* chunk = static_cast<std::vector<char>*>(ud);
+    const char* bytes = static_cast<const char*>(p);
+    chunk->insert(chunk->end(), bytes, bytes + sz);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void write_cache_file(lua_State* L, const char* cache_file, const char* key, uint64 mtime, uint64 size)
+{
+    // The compiled function is on top of the stack.
+    std::vector<char> chunk;
+    if (lua_dump(L, chunk_writer, &chunk) != 0 || chunk.empty())
+        return;
+
+    cache_header header;
+    memcpy(header.magic, c_magic, sizeof(c_magic));
+    header.format = c_format;
+    header.clink_version = CLINK_VERSION_ENCODED;
+    header.lua_version = LUA_VERSION_NUM;
+    header.pointer_size = sizeof(void*);
+    header.mtime = mtime;
+    header.size = size;
+    header.path_len = uint32(strlen(key));
+    header.chunk_len = uint32(chunk.size());
+
+    os::make_dir(s_cache_dir.c_str());
+
+    // Write to a temporary file and then move it into place, so that other
+    // Clink instances never see a partially written cache file.
+    str<> tmp;
+    tmp.format("%s.%u.tmp", cache_file, GetCurrentProcessId());
+    wstr<> wtmp(tmp.c_str());
+    FILE* file = _wfopen(wtmp.c_str(), L"wb");
+    if (!file)
+        return;
+
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+               fwrite(key, 1, header.path_len, file) == header.path_len &&
+               fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size());
+    ok = (fclose(file) == 0) && ok;
+
+    wstr<> wcache(cache_file);
+    if (!ok || !MoveFileExW(wtmp.c_str(), wcache.c_str(), MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(wtmp.c_str());
+}
+
+
+
+//------------------------------------------------------------------------------
+void set_lua_script_cache_dir(const char* dir)
+{
+    s_cache_dir = dir ? dir : "";
+}
+
+//------------------------------------------------------------------------------
+int32 load_lua_file_cached(lua_State* L, const char* path)
+{
+    if (s_cache_dir.empty() || !g_lua_cache_scripts.get())
+        return luaL_loadfile(L, path);
+
+    str<> key;
+    uint64 mtime;
+    uint64 size;
+    if (!get_script_key(path, key, mtime, size))
+        return luaL_loadfile(L, path);
+
+    str<> cache_file;
+    get_cache_file(key.c_str(), cache_file);
+
+    std::vector<char> chunk;
+    if (read_cache_file(cache_file.c_str(), key.c_str(), mtime, size, chunk))
+    {
+        // The chunk name matches what luaL_loadfile uses, so error messages
+        // and debug info are the same either way.
+        str<> chunkname;
+        chunkname.format("@%s", path);
+        if (luaL_loadbufferx(L, chunk.data(), chunk.size(), chunkname.c_str(), "b") == LUA_OK)
+        {
+            ++s_hits;
+            return LUA_OK;
+        }
+
+        lua_pop(L, 1);
+        wstr<> wcache(cache_file.c_str());
+        DeleteFileW(wcache.c_str());
+    }
+
+    ++s_misses;
+    const int32 err = luaL_loadfile(L, path);
+    if (err == LUA_OK)
+        write_cache_file(L, cache_file.c_str(), key.c_str(), mtime, size);
+    return err;
+}
+
+//------------------------------------------------------------------------------
+void get_lua_script_cache_stats(uint32& hits, uint32& misses)
+{
+    hits = s_hits;
+    misses = s_misses;
+}
@@ -4,7 +4,11 @@
 #include "pch.h"
 #include "lua_state.h"
 #include "lua_script_loader.h"
+#include "lua_script_cache.h"
+#include "lua_profiler.h"
+#include "lua_allocator.h"
 #include "lua_task_manager.h"
+#include "coroutine_scheduler.h"
 #include "rl_buffer_lua.h"
 #include "line_state_lua.h"
 
@@ -110,6 +114,7 @@ void settings_lua_initialise(lua_state&);
 void string_lua_initialise(lua_state&);
 void unicode_lua_initialise(lua_state&);
 void log_lua_initialise(lua_state&);
+void git_lua_initialise(lua_state&);
 
 
 
@@ -198,6 +203,16 @@ bool lua_state::s_in_onfiltermatches = false;
 bool lua_state::s_in_coroutine = false;
 #endif
 
+//------------------------------------------------------------------------------
+static int32 panic(lua_State* L)
+{
+    fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", lua_tostring(L, -1));
+    fflush(stderr);
+    return 0;
+}
+
+
+
 //------------------------------------------------------------------------------
 lua_state::lua_state(lua_state_flags flags)
 : m_state(nullptr)
@@ -223,8 +238,15 @@ void lua_state::initialise(lua_state_flags flags)
 
     s_interpreter = interpreter;
 
-    // Create a new Lua state.
-    m_state = luaL_newstate();
+    // Create a new Lua state.  The allocator pools small blocks.  The profiler
+    // wraps the allocator and hooks the state only while profiling is enabled.
+    m_state = lua_newstate(lua_pool_alloc, nullptr);
+    lua_atpanic(m_state, panic);
+    lua_profiler::get().install(m_state);
+
+    // Coroutine ids are only meaningful within this Lua state.
+    m_scheduler = std::make_unique<coroutine_scheduler>();
+    m_scheduler->attach(m_state);
 
     // Suspend collection during initialization.
     lua_gc(m_state, LUA_GCSTOP, 0);
@@ -274,6 +296,7 @@ void lua_state::initialise(lua_state_flags flags)
     string_lua_initialise(self);
     unicode_lua_initialise(self);
     log_lua_initialise(self);
+    git_lua_initialise(self);
 
     // Load the debugger.
     if (g_force_load_debugger || g_lua_debug.get())
@@ -311,6 +334,9 @@ void lua_state::shutdown()
 
     lua_close(m_state);
     m_state = nullptr;
+    m_scheduler.reset();
+
+    trim_lua_allocator();
 
     s_interpreter = false;
 }
@@ -364,7 +390,7 @@ bool lua_state::do_file(const char* path)
 
     save_stack_top ss(L);
 
-    int32 err = luaL_loadfile(L, path);
+    int32 err = load_lua_file_cached(L, path);
     if (err)
     {
         if (g_lua_debug.get())
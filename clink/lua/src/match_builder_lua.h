@@ -21,10 +21,12 @@ public:
                     ~match_builder_lua();
 
     int32           do_add_matches(lua_State* state, bool self_on_stack);
+    match_builder*  get_builder() const { return m_builder; }
 
 protected:
     int32           add_match(lua_State* state);
     int32           add_matches(lua_State* state);
+    int32           add_match_list(lua_State* state);
     int32           is_empty(lua_State* state);
     int32           set_append_character(lua_State* state);
     int32           set_suppress_append(lua_State* state);
@@ -5,6 +5,7 @@
 #include "lua_state.h"
 #include "lua_bindable.h"
 #include "yield.h"
+#include "file_matches_lua.h"
 
 #include <core/base.h>
 #include <core/globber.h>
@@ -749,14 +750,6 @@ static int32 copy(lua_State* state)
     return lua_osboolresult(state, ok);
 }
 
-//------------------------------------------------------------------------------
-static void add_type_tag(str_base& out, const char* tag)
-{
-    if (out.length())
-        out << ",";
-    out << tag;
-}
-
 //------------------------------------------------------------------------------
 static bool glob_next(lua_State* state, globber& globber, str_base& parent, int32* index, int32 extrainfo)
 {
@@ -779,28 +772,7 @@ static bool glob_next(lua_State* state, globber& globber, str_base& parent, int3
         lua_rawset(state, -3);
 
         str<32> type;
-        add_type_tag(type, (info.attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
-#ifdef S_ISLNK
-        if (S_ISLNK(info.st_mode))
-        {
-            uint32 len = parent.length();
-            path::append(parent, file.c_str());
-
-            add_type_tag(type, "link");
-            wstr<288> wfile(parent.c_str());
-            struct _stat64 st;
-            if (_wstat64(wfile.c_str(), &st) < 0)
-                add_type_tag(type, "orphaned");
-
-            parent.truncate(len);
-        }
-#endif
-        if (info.attr & FILE_ATTRIBUTE_HIDDEN)
-            add_type_tag(type, "hidden");
-        if (info.attr & FILE_ATTRIBUTE_SYSTEM)
-            add_type_tag(type, "system");
-        if (info.attr & FILE_ATTRIBUTE_READONLY)
-            add_type_tag(type, "readonly");
+        match_type_to_string(get_globbed_match_type(info, parent, file.c_str()), type);
 
         lua_pushliteral(state, "type");
         lua_pushlstring(state, type.c_str(), type.length());
@@ -8,7 +8,6 @@
 
 #include <core/os.h>
 
-#include <process.h>
 #include <assert.h>
 
 //------------------------------------------------------------------------------
@@ -22,11 +21,8 @@ yield_thread::yield_thread()
 //------------------------------------------------------------------------------
 yield_thread::~yield_thread()
 {
-    if (m_thread_handle)
-    {
-        cancel();
-        CloseHandle(m_thread_handle);
-    }
+    // The work pool holds a strong ref while the work item is queued or
+    // running, so by now the work has finished or was never submitted.
     if (m_ready_event)
         CloseHandle(m_ready_event);
 }
@@ -34,9 +30,8 @@ yield_thread::~yield_thread()
 //------------------------------------------------------------------------------
 bool yield_thread::createthread()
 {
-    assert(!m_suspended);
-    assert(!m_thread_handle);
-    assert(!m_cancelled);
+    assert(!m_created);
+    assert(!is_canceled());
     assert(!m_ready_event);
     os::get_current_dir(m_cwd);
     if (!s_wake_event)
@@ -48,33 +43,22 @@ bool yield_thread::createthread()
     m_ready_event = CreateEvent(nullptr, true, false, nullptr);
     if (!m_ready_event)
         return false;
-    m_thread_handle = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, &threadproc, this, CREATE_SUSPENDED, nullptr));
-    if (!m_thread_handle)
-        return false;
-    m_holder = shared_from_this(); // Now threadproc holds a strong ref.
-    m_suspended = true;
+    m_created = true;
     return true;
 }
 
 //------------------------------------------------------------------------------
 void yield_thread::go()
 {
-    assert(m_suspended);
-    if (m_thread_handle)
+    assert(m_created);
+    if (m_created)
     {
-        m_suspended = false;
-        ResumeThread(m_thread_handle);
+        // The work pool holds a strong ref until the work finishes.
+        if (!work_pool::get().submit(work_category::yield, shared_from_this()))
+            finish();
     }
 }
 
-//------------------------------------------------------------------------------
-void yield_thread::cancel()
-{
-    m_cancelled = true;
-    if (m_suspended) // Can only be true when there's no concurrency.
-        ResumeThread(m_thread_handle);
-}
-
 //------------------------------------------------------------------------------
 bool yield_thread::is_ready()
 {
@@ -106,35 +90,34 @@ void yield_thread::wait(uint32 timeout)
 }
 
 //------------------------------------------------------------------------------
-bool yield_thread::is_canceled() const
+const char* yield_thread::get_cwd() const
 {
-    return !!m_cancelled;
+    return m_cwd.c_str();
 }
 
 //------------------------------------------------------------------------------
-const char* yield_thread::get_cwd() const
+void yield_thread::run()
 {
-    return m_cwd.c_str();
+    // Do the work defined by the subclass.
+    do_work();
+    finish();
 }
 
 //------------------------------------------------------------------------------
-unsigned __stdcall yield_thread::threadproc(void *arg)
+void yield_thread::skip()
 {
-    yield_thread *_this = static_cast<yield_thread *>(arg);
-
-    // Do the work defined by the subclass.
-    _this->do_work();
+    // Canceled before the work started; still signal completion so nothing
+    // waits forever.
+    finish();
+}
 
+//------------------------------------------------------------------------------
+void yield_thread::finish()
+{
     // Signal completion events.
-    SetEvent(_this->m_ready_event);
-    _this->do_completion(); // Give subclass a chance to do completion processing.
+    SetEvent(m_ready_event);
+    do_completion(); // Give subclass a chance to do completion processing.
     SetEvent(s_wake_event);
-
-    // Release threadproc's strong ref.
-    _this->m_holder = nullptr;
-
-    _endthreadex(0);
-    return 0;
 }
 
 
@@ -4,13 +4,16 @@
 #pragma once
 
 #include <core/str.h>
+#include <core/work_pool.h>
 
 #include <memory>
 
 struct lua_State;
 
 //------------------------------------------------------------------------------
-struct yield_thread : public std::enable_shared_from_this<yield_thread>
+struct yield_thread
+    : public work_item
+    , public std::enable_shared_from_this<yield_thread>
 {
                     yield_thread();
     virtual         ~yield_thread();
@@ -18,7 +21,6 @@ struct yield_thread : public std::enable_shared_from_this<yield_thread>
     bool            createthread();
 
     void            go();
-    void            cancel();
 
     bool            is_ready();
     virtual HANDLE  get_ready_event();
@@ -29,23 +31,19 @@ struct yield_thread : public std::enable_shared_from_this<yield_thread>
     virtual int32   results(lua_State* state) = 0;
 
 protected:
-    bool            is_canceled() const;
     const char*     get_cwd() const;
 
 private:
     virtual void    do_work() = 0;
     virtual bool    do_completion() { return false; }
 
-    static unsigned __stdcall threadproc(void* arg);
+    void            run() override;
+    void            skip() override;
+    void            finish();
 
-    HANDLE m_thread_handle = 0;
     HANDLE m_ready_event = 0;
     str_moveable m_cwd;
-    bool m_suspended = false;
-
-    volatile long m_cancelled = false;
-
-    std::shared_ptr<yield_thread> m_holder;
+    bool m_created = false;
 };
 
 //------------------------------------------------------------------------------
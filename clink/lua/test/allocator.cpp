@@ -0,0 +1,197 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <core/os.h>
+#include <core/settings.h>
+#include <lua/lua_allocator.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_word_classifier.h>
+#include <lua/lua_script_loader.h>
+#include <lua/lua_state.h>
+
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+}
+
+extern bool g_benchmarks;
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua allocator")
+{
+    // Drives the pools directly, since lua_pool_alloc() passes everything
+    // through to the debug heap when memory tracking is enabled.
+    struct block
+    {
+        uint8*      ptr;
+        size_t      size;
+        uint8       fill;
+    };
+
+    auto verify = [] (const block& b) {
+        for (size_t i = 0; i < b.size; ++i)
+            REQUIRE(b.ptr[i] == b.fill);
+    };
+
+    lua_alloc_stats before;
+    get_lua_alloc_stats(before);
+
+    // Sizes straddle the pooled/heap boundary and several size classes.
+    std::vector<block> blocks;
+    for (uint32 i = 0; i < 2000; ++i)
+    {
+        const size_t size = 1 + (i * 37) % 600;
+        block b = { static_cast<uint8*>(lua_pool_realloc(nullptr, 0, size)), size, uint8(i) };
+        REQUIRE(b.ptr);
+        memset(b.ptr, b.fill, b.size);
+        blocks.push_back(b);
+    }
+
+    SECTION("Realloc")
+    {
+        for (uint32 i = 0; i < blocks.size(); ++i)
+        {
+            block& b = blocks[i];
+            verify(b);
+            const size_t size = 1 + (i * 53) % 600;
+            uint8* ptr = static_cast<uint8*>(lua_pool_realloc(b.ptr, b.size, size));
+            REQUIRE(ptr);
+            for (size_t j = 0; j < min(size, b.size); ++j)
+                REQUIRE(ptr[j] == b.fill);
+            b.ptr = ptr;
+            b.size = size;
+            memset(b.ptr, b.fill, b.size);
+        }
+    }
+
+    SECTION("Interleaved free")
+    {
+        for (uint32 i = 0; i < blocks.size(); i += 2)
+        {
+            verify(blocks[i]);
+            lua_pool_realloc(blocks[i].ptr, blocks[i].size, 0);
+            blocks[i].size = 0;
+        }
+        for (uint32 i = 0; i < blocks.size(); i += 2)
+        {
+            block& b = blocks[i];
+            b.size = 1 + (i * 11) % 256;
+            b.ptr = static_cast<uint8*>(lua_pool_realloc(nullptr, 0, b.size));
+            REQUIRE(b.ptr);
+            memset(b.ptr, b.fill, b.size);
+        }
+    }
+
+    for (const block& b : blocks)
+    {
+        verify(b);
+        lua_pool_realloc(b.ptr, b.size, 0);
+    }
+
+    lua_alloc_stats after;
+    get_lua_alloc_stats(after);
+    REQUIRE(after.small_in_use == before.small_in_use);
+    REQUIRE(after.small_capacity == before.small_capacity);
+    REQUIRE(after.large_in_use == before.large_in_use);
+    REQUIRE(after.chunks > 0);
+    REQUIRE(after.spare_chunks > 0);
+    REQUIRE(after.peak_chunks >= after.chunks);
+
+    trim_lua_allocator();
+    get_lua_alloc_stats(after);
+    REQUIRE(after.spare_chunks == 0);
+    REQUIRE(after.allocated_line == 0);
+
+    // lua_pool_alloc() counts what it's asked for, whether or not the pools
+    // serve it.
+    get_lua_alloc_stats(before);
+    void* p = lua_pool_alloc(nullptr, nullptr, LUA_TTABLE, 40);
+    REQUIRE(p);
+    p = lua_pool_alloc(nullptr, p, 40, 72);
+    REQUIRE(p);
+    lua_pool_alloc(nullptr, p, 72, 0);
+    get_lua_alloc_stats(after);
+    REQUIRE(after.allocs - before.allocs == 1);
+    REQUIRE(after.frees - before.frees == 1);
+    REQUIRE(after.allocated - before.allocated == 72);
+    REQUIRE(after.freed - before.freed == 72);
+    REQUIRE(after.small_in_use == before.small_in_use);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua allocator typing replay")
+{
+    // Replays typing through the generators and classifiers, and checks that
+    // the allocation and pool usage stats stay consistent.  With -b it also
+    // reports the allocation volume and pool usage per keystroke.
+    static const char* const c_lines[] =
+    {
+        "argcmd one four five six",
+        "argcmd spa" DO_COMPLETE,
+        "xyz -a abc qq -z",
+        "dir /s /b some\\path" DO_COMPLETE,
+        "echo hello & argcmd two && xyz def",
+    };
+
+    const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua); // This loads the required lua scripts.
+    lua_load_script(lua, app, cmd);
+    lua_load_script(lua, app, dir);
+    lua_word_classifier lua_classifier(lua);
+
+    settings::find("clink.colorize_input")->set("true");
+
+    const char* script = "\
+        r = clink.argmatcher():addarg('five', 'six'):loop() \
+        q = clink.argmatcher():addarg('four' .. r) \
+        s = clink.argmatcher():addarg('one', 'two') \
+        clink.argmatcher('argcmd'):addarg('one', 'two', 'three' .. q, 'spa ce' .. s) \
+        clink.argmatcher('xyz'):addarg('abc', 'def', 'qq'..clink.argmatcher():addflags('-z')):addflags('-a', '--bee') \
+    ";
+    REQUIRE_LUA_DO_STRING(lua, script);
+
+    line_editor::desc desc(nullptr, nullptr, nullptr, nullptr);
+    line_editor_tester tester(desc, "&|", nullptr);
+    tester.get_editor()->set_generator(lua_generator);
+    tester.get_editor()->set_classifier(lua_classifier);
+
+    for (const char* keys : c_lines)
+    {
+        trim_lua_allocator();
+
+        lua_alloc_stats before;
+        get_lua_alloc_stats(before);
+        const double clock_begin = os::clock();
+
+        tester.set_input(keys);
+        tester.run(true);
+
+        const double elapsed = os::clock() - clock_begin;
+        lua_alloc_stats after;
+        get_lua_alloc_stats(after);
+
+        REQUIRE(after.allocs > before.allocs);
+        REQUIRE(after.allocated_line > 0);
+        REQUIRE(after.chunks <= after.peak_chunks);
+        REQUIRE(after.spare_chunks <= after.chunks);
+
+        if (g_benchmarks)
+        {
+            const uint32 num_keys = uint32(strlen(keys));
+            printf("lua alloc: %2u keys, %6llu allocs, %6llu KB; per key %.1f allocs, %.1f KB, %.1f us; %u chunks (peak %u)\n",
+                   num_keys, after.allocs - before.allocs, after.allocated_line / 1024,
+                   double(after.allocs - before.allocs) / num_keys,
+                   double(after.allocated_line) / 1024 / num_keys,
+                   elapsed * 1000000 / num_keys, after.chunks, after.peak_chunks);
+        }
+    }
+}
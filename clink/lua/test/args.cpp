@@ -209,6 +209,52 @@ TEST_CASE("Lua arg parsers")
             tester.run();
         }
 
+        SECTION("Resume from checkpoint")
+        {
+            // Later runs can resume parsing from checkpoints left by earlier
+            // runs, but only while the text before the checkpoint matches.
+            tester.set_input("argcmd three four five six ");
+            tester.set_expected_matches("five", "six");
+            tester.run();
+
+            tester.set_input("argcmd three four five six f");
+            tester.set_expected_matches("five");
+            tester.run();
+
+            tester.set_input("argcmd \"spa ce\" t");
+            tester.set_expected_matches("two");
+            tester.run();
+
+            tester.set_input("argcmd three f");
+            tester.set_expected_matches("four");
+            tester.run();
+
+            tester.set_input("argcmd three four s");
+            tester.set_expected_matches("six");
+            tester.run();
+        }
+
+        SECTION("Resume from checkpoint: multiple commands")
+        {
+            // Checkpoints from one command aren't used by another command
+            // with the same argmatcher, even when the line begins the same.
+            tester.set_input("argcmd three four five six ");
+            tester.set_expected_matches("five", "six");
+            tester.run();
+
+            tester.set_input("argcmd three four five six & argcmd \"spa ce\" t");
+            tester.set_expected_matches("two");
+            tester.run();
+
+            tester.set_input("argcmd three four five six & argcmd three f");
+            tester.set_expected_matches("four");
+            tester.run();
+
+            tester.set_input("argcmd three four five six & argcmd three four five six & argcmd t");
+            tester.set_expected_matches("two", "three");
+            tester.run();
+        }
+
         SECTION("Separator && 1")
         {
             tester.set_input("nullcmd && argcmd t");
@@ -1329,3 +1375,58 @@ TEST_CASE("Lua arg parsers")
     translate_slashes->set();
     show_hints->set();
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua line_state word cache")
+{
+    lua_state lua;
+    lua_match_generator lua_generator(lua); // This loads the required lua scripts.
+
+    // Argmatchers revisit the same words many times while parsing long lines,
+    // so they use _getwordinfo_cached(), which makes each word's table once.
+    // getwordinfo() returns a new table each time, so changing it can't affect
+    // later calls.
+    const char* script = "\
+        local words = {} \
+        for i = 1, 500 do table.insert(words, 'word'..i) end \
+        local line = 'argcmd '..table.concat(words, ' ') \
+        \
+        local function visit(ls) \
+            for i = 1, ls:getwordcount() do \
+                ls:_getwordinfo_cached(i) \
+                ls:getword(i) \
+            end \
+        end \
+        \
+        local ls = clink.parseline(line)[1].line_state \
+        local count = ls:getwordcount() \
+        assert(count == 501) \
+        assert(ls:getwordinfo(3).offset == 14) \
+        assert(ls:getword(3) == 'word2') \
+        assert(ls:getwordinfo(count + 1) == nil) \
+        assert(ls:_getwordinfo_cached(count + 1) == nil) \
+        \
+        local info = ls:getwordinfo(3) \
+        assert(not rawequal(info, ls:getwordinfo(3))) \
+        info.offset = 99 \
+        assert(ls:getwordinfo(3).offset == 14) \
+        \
+        local cached = ls:_getwordinfo_cached(3) \
+        assert(cached.offset == 14) \
+        assert(rawequal(cached, ls:_getwordinfo_cached(3))) \
+        ls:_shift(2) \
+        assert(rawequal(cached, ls:_getwordinfo_cached(2))) \
+        assert(ls:getword(2) == 'word2') \
+        ls:_reset_shift() \
+        \
+        visit(ls) \
+        collectgarbage('stop') \
+        local before = collectgarbage('count') \
+        for _ = 1, 10 do visit(ls) end \
+        local after = collectgarbage('count') \
+        collectgarbage('restart') \
+        assert(after == before, 'allocated '..(after - before)..' KB') \
+    ";
+
+    REQUIRE_LUA_DO_STRING(lua, script);
+}
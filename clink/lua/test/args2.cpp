@@ -702,6 +702,35 @@ TEST_CASE("Lua advanced arg parsers")
         tester.run();
     }
 
+    SECTION("Native file matches")
+    {
+        const char* script = "\
+            clink.argmatcher('qqq'):addarg(clink.dirmatches):addarg(clink.filematchesexact)\
+            clink.argmatcher('rrr'):addarg(function (word, _, _, builder)\
+                clink._add_file_matches(builder, word)\
+                return true\
+            end)\
+        ";
+
+        REQUIRE_LUA_DO_STRING(lua, script);
+
+        tester.set_input("qqq ");
+        tester.set_expected_matches("dir1\\", "dir2\\");
+        tester.run();
+
+        tester.set_input("qqq dir1\\ dir1\\f");
+        tester.set_expected_matches();
+        tester.run();
+
+        tester.set_input("qqq dir1\\ dir1\\file1");
+        tester.set_expected_matches("dir1\\file1");
+        tester.run();
+
+        tester.set_input("rrr dir1\\");
+        tester.set_expected_matches("dir1\\only", "dir1\\file1", "dir1\\file2");
+        tester.run();
+    }
+
     SECTION("onarg")
     {
         const char* script = "\
@@ -0,0 +1,57 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/str.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua completion script index")
+{
+    static const char* index_fs[] = {
+        "completions/git.lua",
+        "completions/Scoop.LUA",
+        "completions/other.luax",
+        "completions/readme.txt",
+        "completions/sub.lua/file",
+        nullptr,
+    };
+
+    fs_fixture fs(index_fs);
+
+    lua_state lua;
+
+    str<> script;
+    script.format("dir = [[%s\\completions]]", fs.get_root());
+    REQUIRE_LUA_DO_STRING(lua, script.c_str());
+
+    SECTION("Found")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "assert(clink._completion_script_exists(dir, 'git.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(clink._completion_script_exists(dir, 'GIT.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(clink._completion_script_exists(dir, 'scoop.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(clink._completion_script_exists(dir:upper(), 'git.lua'))");
+    }
+
+    SECTION("Not found")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "assert(not clink._completion_script_exists(dir, 'other.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(not clink._completion_script_exists(dir, 'readme.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(not clink._completion_script_exists(dir, 'sub.lua'))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(not clink._completion_script_exists(dir..'\\\\nope', 'git.lua'))");
+    }
+
+    SECTION("Scanned once")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink._completion_script_exists(dir, 'git.lua') \
+            local _, _, scans = clink._get_completion_index_stats() \
+            for i = 1, 100 do \
+                clink._completion_script_exists(dir, 'cmd'..i..'.lua') \
+            end \
+            local lookups, hits, after = clink._get_completion_index_stats() \
+            assert(after == scans)");
+    }
+}
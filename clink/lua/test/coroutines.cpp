@@ -0,0 +1,132 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua coroutine scheduler")
+{
+    lua_state lua;
+
+    SECTION("Heap order")
+    {
+        // Due ids come out in order of target time, ties keep the order in
+        // which they were scheduled, and rescheduling replaces the earlier
+        // target.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local now = os.clock() \
+            clink._schedule_coroutine(1, now - 1) \
+            clink._schedule_coroutine(2, now - 3) \
+            clink._schedule_coroutine(3, now - 2) \
+            clink._schedule_coroutine(4, now - 2) \
+            clink._schedule_coroutine(5, now + 1000) \
+            clink._schedule_coroutine(1, now - 4) \
+            local due = clink._take_due_coroutines() \
+            assert(#due == 4, #due) \
+            assert(due[1] == 1 and due[2] == 2 and due[3] == 3 and due[4] == 4) \
+            assert(#clink._take_due_coroutines() == 0) \
+            assert(clink._wait_duration() > 900)");
+    }
+
+    SECTION("Reschedule and remove")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local now = os.clock() \
+            for i = 1, 200 do \
+                clink._schedule_coroutine(7, now - i) \
+            end \
+            clink._schedule_coroutine(8, now + 1000) \
+            local due = clink._take_due_coroutines() \
+            assert(#due == 1 and due[1] == 7) \
+            assert(clink._has_coroutines()) \
+            clink._unschedule_coroutine(8) \
+            clink._unschedule_coroutine(7) \
+            assert(clink._wait_duration() == nil) \
+            assert(not clink._has_coroutines())");
+    }
+
+    SECTION("Waiting")
+    {
+        // A waiting coroutine has no target time.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink._schedule_coroutine(9, os.clock() - 1) \
+            clink._wait_coroutine(9) \
+            assert(clink._has_coroutines()) \
+            assert(clink._wait_duration() == nil) \
+            assert(#clink._take_due_coroutines() == 0)");
+    }
+
+    SECTION("Separate Lua states")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "clink._schedule_coroutine(1, os.clock() - 1)");
+
+        // Creating another Lua state leaves this one's schedule alone, and
+        // the other state has its own.
+        lua_state other;
+        REQUIRE_LUA_DO_STRING(other, "assert(not clink._has_coroutines())");
+        REQUIRE_LUA_DO_STRING(lua, "\
+            assert(clink._has_coroutines()) \
+            local due = clink._take_due_coroutines() \
+            assert(#due == 1 and due[1] == 1)");
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua coroutine scheduling")
+{
+    lua_state lua;
+
+    REQUIRE_LUA_DO_STRING(lua, "\
+        log = '' \
+        function make(name) \
+            return coroutine.create(function() \
+                while true do \
+                    log = log..name \
+                    coroutine.yield() \
+                end \
+            end) \
+        end");
+
+    SECTION("Resume order and intervals")
+    {
+        // New coroutines are due immediately, in the order they were created.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            a = make('a') \
+            b = make('b') \
+            c = make('c') \
+            clink._resume_coroutines() \
+            assert(log == 'abc', log)");
+
+        // A long interval keeps a coroutine from being resumed again.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink.setcoroutineinterval(a, 1000) \
+            clink._resume_coroutines() \
+            assert(log == 'abcbc', log)");
+
+        // Removed coroutines are no longer resumed.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink.removecoroutine(c) \
+            clink._resume_coroutines() \
+            assert(log == 'abcbcb', log)");
+
+        // Only the long interval remains.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink.removecoroutine(b) \
+            assert(clink._has_coroutines()) \
+            assert(clink._wait_duration() > 900) \
+            clink.removecoroutine(a) \
+            assert(not clink._has_coroutines())");
+    }
+
+    SECTION("Dead coroutines")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local once = coroutine.create(function() log = log..'x' end) \
+            clink._resume_coroutines() \
+            assert(log == 'x', log) \
+            assert(coroutine.status(once) == 'dead') \
+            assert(not clink._has_coroutines())");
+    }
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/str.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua native git provider")
+{
+    static const char* git_fs[] = {
+        "repo/.git/HEAD",
+        "repo/.git/refs/heads/main",
+        "repo/.git/modules/mod/config",
+        "repo/.git/modules/other/config",
+        "repo/mod/.git",
+        "repo/sub/deeper/file",
+        "wt/.git/commondir",
+        nullptr,
+    };
+
+    fs_fixture fs(git_fs);
+
+    lua_state lua;
+
+    str<> script;
+    script.format("\
+        root = [[%s]] \
+        git_dir = root..'\\\\repo\\\\.git' \
+        function write(name, text) \
+            local f = io.open(git_dir..'\\\\'..name, 'w') \
+            f:write(text) \
+            f:close() \
+        end", fs.get_root());
+    REQUIRE_LUA_DO_STRING(lua, script.c_str());
+
+    SECTION("No stash")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "assert(not git._hasstash(git_dir))");
+        REQUIRE_LUA_DO_STRING(lua, "assert(git._getstashcount(git_dir) == 0)");
+    }
+
+    SECTION("Loose stash")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            os.mkdir(git_dir..'\\\\logs\\\\refs') \
+            write('refs\\\\stash', '1111111111111111111111111111111111111111\\n') \
+            write('logs\\\\refs\\\\stash', 'a\\nb\\nc\\n') \
+            assert(git._hasstash(git_dir)) \
+            assert(git._getstashcount(git_dir) == 3)");
+    }
+
+    SECTION("Packed stash")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            write('packed-refs', '# pack-refs with: peeled fully-peeled sorted\\n' \
+                ..'2222222222222222222222222222222222222222 refs/heads/main\\n' \
+                ..'3333333333333333333333333333333333333333 refs/stash\\n') \
+            assert(git._hasstash(git_dir)) \
+            assert(git._getstashcount(git_dir) == 1)");
+    }
+
+    SECTION("Packed refs without stash")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            write('packed-refs', '2222222222222222222222222222222222222222 refs/stashes\\n') \
+            assert(not git._hasstash(git_dir))");
+    }
+
+    SECTION("Worktree")
+    {
+        // A worktree shares the stash of its main git dir.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local f = io.open(root..'\\\\wt\\\\.git\\\\commondir', 'w') \
+            f:write('..\\\\..\\\\repo\\\\.git\\n') \
+            f:close() \
+            local wt_dir = root..'\\\\wt\\\\.git' \
+            assert(not git._hasstash(wt_dir)) \
+            write('refs\\\\stash', '1111111111111111111111111111111111111111\\n') \
+            assert(git._hasstash(wt_dir)) \
+            assert(git._getstashcount(wt_dir) == 1)");
+    }
+
+    SECTION("Find repo")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local repo = root..'\\\\repo' \
+            local g, w, t, c = git._findrepo(repo..'\\\\sub\\\\deeper') \
+            assert(g == git_dir, g) \
+            assert(w == git_dir, w) \
+            assert(t == repo, t) \
+            assert(c == git_dir, c) \
+            assert(not git._findrepo(repo..'\\\\sub', true--[[no_walk]])) \
+            assert(not git._findrepo(root))");
+    }
+
+    SECTION("Find repo again")
+    {
+        // The second lookup in the same tree uses the remembered results.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local dir = root..'\\\\repo\\\\sub\\\\deeper' \
+            assert(git._findrepo(dir)) \
+            local lookups1, hits1 = git._getfindrepostats() \
+            assert(git._findrepo(dir)) \
+            local lookups2, hits2 = git._getfindrepostats() \
+            assert(lookups2 - lookups1 == 3) \
+            assert(hits2 - hits1 == 3)");
+
+        // Adding .git changes the directory's write time, so the remembered
+        // result is no longer used.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local sub = root..'\\\\repo\\\\sub' \
+            assert(os.mkdir(sub..'\\\\.git')) \
+            local g, _, t = git._findrepo(sub..'\\\\deeper') \
+            assert(g == sub..'\\\\.git', g) \
+            assert(t == sub, t)");
+    }
+
+    SECTION("Query coalescing")
+    {
+        // A coroutine starts the query and yields until it completes.  The
+        // main coroutine shares the query instead of running the command
+        // again.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local top = root..'\\\\repo' \
+            local before = git._getquerystats() \
+            local co = coroutine.create(function() \
+                return git._query(git_dir, top, 'echo coalesce') \
+            end) \
+            local ok, output = coroutine.resume(co) \
+            assert(ok and not output) \
+            assert(coroutine.status(co) == 'suspended') \
+            output = git._query(git_dir, top, 'echo coalesce') \
+            assert(output and output:find('coalesce'), output) \
+            assert(git._query(git_dir, top, 'echo coalesce') == output) \
+            local ok2, output2 = coroutine.resume(co) \
+            assert(ok2 and output2 == output, output2) \
+            assert(git._getquerystats() - before == 1)");
+    }
+
+    SECTION("Query without async")
+    {
+        // When a coroutine can't run async (e.g. prompt.async is off), the
+        // query runs to completion without yielding.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local top = root..'\\\\repo' \
+            local co = coroutine.create(function() \
+                return git._query(git_dir, top, 'echo sync', nil, true--[[wait]]) \
+            end) \
+            local ok, output = coroutine.resume(co) \
+            assert(ok and output and output:find('sync'), output) \
+            assert(coroutine.status(co) == 'dead') \
+            assert(not clink._can_coroutine_async()) \
+            local ok2, can_async = coroutine.resume(coroutine.create(clink._can_coroutine_async)) \
+            assert(ok2 and can_async)");
+    }
+
+    SECTION("Query stamp")
+    {
+        // Changing HEAD changes the repo stamp, so the query runs again.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local top = root..'\\\\repo' \
+            local before = git._getquerystats() \
+            assert(git._query(git_dir, top, 'echo stamp')) \
+            assert(git._query(git_dir, top, 'echo stamp')) \
+            assert(git._getquerystats() - before == 1) \
+            write('HEAD', 'ref: refs/heads/other\\n') \
+            assert(git._query(git_dir, top, 'echo stamp')) \
+            assert(git._getquerystats() - before == 2) \
+            assert(git._query(git_dir, top, 'echo stamp')) \
+            assert(git._getquerystats() - before == 2)");
+    }
+
+    SECTION("Query max age")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local top = root..'\\\\repo' \
+            local before = git._getquerystats() \
+            assert(git._query(git_dir, top, 'echo age')) \
+            local start = os.clock() \
+            while os.clock() - start < 0.1 do end \
+            assert(git._query(git_dir, top, 'echo age', 1000)) \
+            assert(git._getquerystats() - before == 1) \
+            assert(git._query(git_dir, top, 'echo age', 0.05)) \
+            assert(git._getquerystats() - before == 2) \
+            assert(git._query(git_dir, top, 'echo age')) \
+            assert(git._getquerystats() - before == 2)");
+    }
+
+    SECTION("Submodule")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local mod = root..'\\\\repo\\\\mod' \
+            local f = io.open(mod..'\\\\.git', 'w') \
+            f:write('gitdir: ../.git/modules/mod\\n') \
+            f:close() \
+            local g, w, t, c = git._findrepo(mod, true--[[no_walk]]) \
+            assert(g == git_dir..'\\\\modules\\\\mod', g) \
+            assert(w == git_dir, w) \
+            assert(t == mod, t) \
+            assert(c == g, c)");
+
+        // Rewriting the .git file doesn't change the directory's write time,
+        // but the remembered result is no longer used.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local mod = root..'\\\\repo\\\\mod' \
+            local f = io.open(mod..'\\\\.git', 'w') \
+            f:write('gitdir: ../.git/modules/other\\n') \
+            f:close() \
+            local g = git._findrepo(mod, true--[[no_walk]]) \
+            assert(g == git_dir..'\\\\modules\\\\other', g)");
+    }
+
+    SECTION("Changed commondir")
+    {
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local wt = root..'\\\\wt' \
+            local function set_commondir(text) \
+                local f = io.open(wt..'\\\\.git\\\\commondir', 'w') \
+                f:write(text) \
+                f:close() \
+            end \
+            set_commondir('..\\\\..\\\\repo\\\\.git\\n') \
+            local _, _, _, c = git._findrepo(wt, true--[[no_walk]]) \
+            assert(c == git_dir, c) \
+            set_commondir('..\\\\..\\\\repo\\\\.git\\\\modules\\\\mod\\n') \
+            _, _, _, c = git._findrepo(wt, true--[[no_walk]]) \
+            assert(c == git_dir..'\\\\modules\\\\mod', c)");
+    }
+}
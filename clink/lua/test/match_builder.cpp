@@ -0,0 +1,69 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua match builder lists")
+{
+    const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua); // This loads the required lua scripts.
+
+    const char* script = "\
+        local g = clink.generator(1) \
+        function g:generate(line_state, builder) \
+            local cmd = line_state:getword(1) \
+            if cmd == 'lines' then \
+                list_result = { builder:addmatchlist('alpha\\r\\nbeta\\n\\ngamma\\nalpha', 'word') } \
+                return true \
+            elseif cmd == 'table' then \
+                list_result = { builder:addmatchlist({ 'one', 'two', 3, {}, 'two' }, 'arg') } \
+                return true \
+            elseif cmd == 'opts' then \
+                builder:addmatchlist('key=\\nname', 'arg', { appendchar=':' }) \
+                return true \
+            end \
+        end \
+    ";
+
+    REQUIRE_LUA_DO_STRING(lua, script);
+
+    line_editor::desc desc(nullptr, nullptr, nullptr, nullptr);
+    line_editor_tester tester(desc, nullptr, nullptr);
+    tester.get_editor()->set_generator(lua_generator);
+
+    SECTION("Newline delimited")
+    {
+        tester.set_input("lines ");
+        tester.set_expected_matches("alpha", "beta", "gamma");
+        tester.run();
+
+        // The duplicate "alpha" is counted as not added.
+        REQUIRE_LUA_DO_STRING(lua, "assert(list_result[1] == 3 and list_result[2] == false)");
+    }
+
+    SECTION("Table")
+    {
+        tester.set_input("table ");
+        tester.set_expected_matches("one", "two", "3");
+        tester.run();
+
+        REQUIRE_LUA_DO_STRING(lua, "assert(list_result[1] == 3 and list_result[2] == false)");
+    }
+
+    SECTION("Options")
+    {
+        tester.set_input("opts n" DO_COMPLETE);
+        tester.set_expected_output("opts name:");
+        tester.run();
+    }
+}
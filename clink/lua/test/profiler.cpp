@@ -0,0 +1,195 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_allocator.h>
+#include <lua/lua_profiler.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static double s_fake_now = 0;
+static double fake_clock() { return s_fake_now; }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua profiler frames")
+{
+    lua_state lua;
+    lua_State* L = lua.get_state();
+    REQUIRE_LUA_DO_STRING(lua, "function f() end");
+
+    lua_profiler profiler;
+    profiler.set_enabled(true);
+    profiler.set_clock(&fake_clock);
+    s_fake_now = 0;
+
+    auto enter = [&] (const char* category) {
+        lua_getglobal(L, "f");
+        const uint32 token = profiler.enter(L, category, -1);
+        lua_pop(L, 1);
+        return token;
+    };
+
+    auto check = [&] (const char* category, uint32 calls, double total, double self) {
+        uint32 c;
+        double t, s;
+        REQUIRE(profiler.get_counters(category, c, t, s));
+        REQUIRE(c == calls);
+        REQUIRE(t == total);
+        REQUIRE(s == self);
+    };
+
+    SECTION("Nesting")
+    {
+        const uint32 outer = enter("outer");
+        s_fake_now = 1;
+        const uint32 inner = enter("inner");
+        s_fake_now = 3;
+        profiler.leave(inner);
+        s_fake_now = 10;
+        profiler.leave(outer);
+
+        check("outer", 1, 10, 8);
+        check("inner", 1, 2, 2);
+        REQUIRE(profiler.get_depth() == 0);
+    }
+
+    SECTION("Abandoned frames")
+    {
+        // A callback that throws an error never reaches its leave; its frame
+        // is closed along with its parent's.
+        const uint32 outer = enter("outer");
+        s_fake_now = 1;
+        enter("inner");
+        s_fake_now = 4;
+        profiler.leave(outer);
+
+        check("outer", 1, 4, 1);
+        check("inner", 1, 3, 3);
+        REQUIRE(profiler.get_depth() == 0);
+    }
+
+    SECTION("Yield and resume")
+    {
+        // The first resume of a coroutine runs a callback that yields.
+        const uint32 first = enter("resumer");
+        const uint32 depth1 = profiler.resume(0);
+        REQUIRE(depth1 == 1);
+        s_fake_now = 1;
+        enter("callback");
+        s_fake_now = 3;
+        const uint32 suspended = profiler.suspend(depth1, false/*dead*/);
+        REQUIRE(suspended);
+        REQUIRE(profiler.get_depth() == 1);
+        s_fake_now = 4;
+        profiler.leave(first);
+
+        // The callback's frame is set aside, not closed.
+        uint32 calls;
+        double total, self;
+        REQUIRE(!profiler.get_counters("callback", calls, total, self));
+        check("resumer", 1, 4, 2);
+
+        // The time spent suspended isn't counted when the coroutine is
+        // resumed and the callback finishes.
+        s_fake_now = 100;
+        const uint32 second = enter("resumer");
+        const uint32 depth2 = profiler.resume(suspended);
+        REQUIRE(depth2 == 1);
+        REQUIRE(profiler.get_depth() == 2);
+        s_fake_now = 105;
+        REQUIRE(!profiler.suspend(depth2 + 1, true/*dead*/));
+        REQUIRE(profiler.get_depth() == 2);
+
+        // The coroutine finishes without leaving the callback's frame, so
+        // the frame is closed when the coroutine is found to be dead.
+        REQUIRE(!profiler.suspend(depth2, true/*dead*/));
+        REQUIRE(profiler.get_depth() == 1);
+        s_fake_now = 106;
+        profiler.leave(second);
+
+        check("callback", 1, 7, 7);
+        check("resumer", 2, 10, 3);
+        REQUIRE(profiler.get_depth() == 0);
+    }
+
+    SECTION("Disabled")
+    {
+        profiler.set_enabled(false);
+        REQUIRE(!profiler.is_enabled());
+        REQUIRE(!enter("outer"));
+        REQUIRE(profiler.resume(0) == 0);
+        REQUIRE(!profiler.suspend(0, false));
+        REQUIRE(profiler.get_depth() == 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua profiler gating")
+{
+    struct force_profiling
+    {
+        force_profiling() { lua_profiler::get().set_enabled(true); }
+        ~force_profiling() { lua_profiler::get().set_enabled(false); }
+    };
+
+    lua_state lua;
+    lua_State* L = lua.get_state();
+    void* ud;
+
+    // Disabled profiling leaves the allocator and the dispatch sites alone.
+    REQUIRE(!lua_profiler::get().is_enabled());
+    REQUIRE(lua_getallocf(L, &ud) == lua_pool_alloc);
+    REQUIRE_LUA_DO_STRING(lua, "assert(clink._profiling == nil)");
+
+    {
+        force_profiling force;
+
+        // The setting is applied when an input line begins.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            clink._send_event('onbeginedit') \
+            assert(clink._profiling)");
+        REQUIRE(lua_getallocf(L, &ud) != lua_pool_alloc);
+
+        // A callback in a coroutine yields.  Its frame is suspended while the
+        // coroutine is suspended.
+        REQUIRE_LUA_DO_STRING(lua, "\
+            local function callback() coroutine.yield() end \
+            local function resumer() end \
+            co = coroutine.create(function() \
+                local pt = clink._profile_enter('test_callback', callback) \
+                callback() \
+                clink._profile_leave(pt) \
+            end) \
+            function resume() \
+                local pt = clink._profile_enter('test_resumer', resumer) \
+                coroutine.resume(co) \
+                clink._profile_leave(pt) \
+            end \
+            resume()");
+
+        uint32 calls;
+        double total, self;
+        REQUIRE(lua_profiler::get().get_depth() == 0);
+        REQUIRE(!lua_profiler::get().get_counters("test_callback", calls, total, self));
+
+        REQUIRE_LUA_DO_STRING(lua, "\
+            resume() \
+            assert(coroutine.status(co) == 'dead')");
+        REQUIRE(lua_profiler::get().get_depth() == 0);
+        REQUIRE(lua_profiler::get().get_counters("test_callback", calls, total, self));
+        REQUIRE(calls == 1);
+        REQUIRE(lua_profiler::get().get_counters("test_resumer", calls, total, self));
+        REQUIRE(calls == 2);
+    }
+
+    // Turning the setting off again removes the allocator wrapper.
+    REQUIRE_LUA_DO_STRING(lua, "\
+        clink._send_event('onbeginedit') \
+        assert(clink._profiling == nil)");
+    REQUIRE(lua_getallocf(L, &ud) == lua_pool_alloc);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <core/path.h>
+#include <lua/lua_script_cache.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static void write_script(const char* file, const char* content)
+{
+    FILE* f = fopen(file, "wt");
+    REQUIRE(f);
+    fputs(content, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+static int32 load_and_run(lua_State* state, const char* file)
+{
+    REQUIRE(load_lua_file_cached(state, file) == LUA_OK);
+    REQUIRE(lua_pcall(state, 0, 1, 0) == LUA_OK);
+    const int32 ret = int32(lua_tointeger(state, -1));
+    lua_pop(state, 1);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua script cache")
+{
+    static const char* script_fs[] = {
+        "script.lua",
+        nullptr,
+    };
+
+    fs_fixture fs(script_fs);
+
+    str<> cache_dir(fs.get_root());
+    path::append(cache_dir, "cache");
+    set_lua_script_cache_dir(cache_dir.c_str());
+
+    lua_state lua;
+    lua_State* state = lua.get_state();
+
+    uint32 hits, misses;
+    uint32 hits_before, misses_before;
+    get_lua_script_cache_stats(hits_before, misses_before);
+
+    SECTION("Hit")
+    {
+        write_script("script.lua", "return 42");
+
+        REQUIRE(load_and_run(state, "script.lua") == 42);
+        get_lua_script_cache_stats(hits, misses);
+        REQUIRE(hits == hits_before);
+        REQUIRE(misses == misses_before + 1);
+
+        REQUIRE(load_and_run(state, "script.lua") == 42);
+        get_lua_script_cache_stats(hits, misses);
+        REQUIRE(hits == hits_before + 1);
+        REQUIRE(misses == misses_before + 1);
+    }
+
+    SECTION("Stale")
+    {
+        write_script("script.lua", "return 42");
+        REQUIRE(load_and_run(state, "script.lua") == 42);
+
+        // Changing the size invalidates the cached chunk.
+        write_script("script.lua", "return 42 + 1");
+        REQUIRE(load_and_run(state, "script.lua") == 43);
+        get_lua_script_cache_stats(hits, misses);
+        REQUIRE(hits == hits_before);
+        REQUIRE(misses == misses_before + 2);
+    }
+
+    SECTION("Syntax error")
+    {
+        write_script("script.lua", "return +");
+        REQUIRE(load_lua_file_cached(state, "script.lua") != LUA_OK);
+        lua_pop(state, 1);
+    }
+
+    set_lua_script_cache_dir(nullptr);
+}
@@ -161,7 +161,9 @@ private:
     bool                next_esc(int32 c);
     bool                next_esc_st(int32 c);
     bool                next_unknown(int32 c);
+    void                skip_run(uint8 run);
     str_iter            m_iter;
+    const char* const   m_end;
     ecma48_code&        m_code;
     ecma48_state&       m_state;
     int32               m_nested_cmd_str;
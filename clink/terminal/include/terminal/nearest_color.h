@@ -0,0 +1,45 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/base.h>
+
+//------------------------------------------------------------------------------
+// Maps RGB colors to the nearest of the 16 console palette colors.  Results for
+// the XTerm 256 color cube and grays are kept in a fixed table, and other RGB
+// values go through a small 4-way set associative cache.  Everything is
+// discarded whenever set_palette() receives a different palette.
+class nearest_color_cache
+{
+public:
+                    nearest_color_cache();
+    bool            set_palette(const COLORREF (&palette)[16]);
+    bool            has_palette() const { return m_has_palette; }
+    void            invalidate();
+    int32           find(const uint8 (&rgb)[3]);
+    uint32          get_hits() const { return m_hits; }
+    uint32          get_misses() const { return m_misses; }
+
+private:
+    int32           find_uncached(const uint8 (&rgb)[3]) const;
+    int32           get_xterm256_index(const uint8 (&rgb)[3]) const;
+
+    enum { c_set_bits = 6, c_ways = 4 };
+
+    struct entry
+    {
+        uint32      key;                // 0x00rrggbb, or ~0 when empty.
+        uint8       index;
+    };
+
+    COLORREF        m_palette[16];
+    double          m_l[16];            // CIELAB of m_palette, as separate
+    double          m_a[16];            // arrays so the distance loop can be
+    double          m_b[16];            // vectorized by the compiler.
+    uint8           m_xterm256[256];    // 0xff means not computed yet.
+    entry           m_hash[1 << c_set_bits][c_ways];
+    uint32          m_hits = 0;
+    uint32          m_misses = 0;
+    bool            m_has_palette = false;
+};
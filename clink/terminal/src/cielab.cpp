@@ -29,12 +29,27 @@ struct xyz
     }
 };
 
+//------------------------------------------------------------------------------
+// pow() dominates the conversion, and there are only 256 possible inputs.
+struct srgb_linear_table
+{
+    srgb_linear_table()
+    {
+        for (int32 i = 0; i < sizeof_array(linear); ++i)
+            linear[i] = xyz::SRGBtoLinear(BYTE(i));
+    }
+
+    double linear[256];
+};
+
+static const srgb_linear_table s_srgb_linear;
+
 //------------------------------------------------------------------------------
 void xyz::from_rgb(COLORREF c)
 {
-    double rLinear = SRGBtoLinear(GetRValue(c));
-    double gLinear = SRGBtoLinear(GetGValue(c));
-    double bLinear = SRGBtoLinear(GetBValue(c));
+    double rLinear = s_srgb_linear.linear[GetRValue(c)];
+    double gLinear = s_srgb_linear.linear[GetGValue(c)];
+    double bLinear = s_srgb_linear.linear[GetBValue(c)];
 
     x = rLinear * 0.4124 + gLinear * 0.3576 + bLinear * 0.1805;
     y = rLinear * 0.2126 + gLinear * 0.7152 + bLinear * 0.0722;
@@ -58,6 +58,40 @@ static bool in_range(int32 value, int32 left, int32 right)
     return (unsigned(right - value) <= unsigned(right - left));
 }
 
+//------------------------------------------------------------------------------
+// Byte class table for extending runs in bulk.  Only ASCII bytes can extend a
+// run; anything else falls back to decoding a full codepoint, so that UTF-8
+// sequences (including C1 codes encoded as U+0080..U+009F) behave exactly as
+// when iterating one codepoint at a time.
+enum : uint8
+{
+    run_char        = 1 << 0,   // 0x20..0x7f
+    run_csi_p       = 1 << 1,   // 0x30..0x3f
+    run_csi_i       = 1 << 2,   // 0x20..0x2f
+    run_cmd_str     = 1 << 3,   // 0x08..0x0d, 0x20..0x7f
+    run_char_str    = 1 << 4,   // 0x01..0x7f, except 0x1b
+};
+
+struct byte_class_table
+{
+    constexpr byte_class_table() : runs()
+    {
+        for (int32 c = 0x01; c < 0x80; ++c)
+        {
+            uint8 r = 0;
+            if (c >= 0x20)              r |= run_char|run_cmd_str;
+            if (c >= 0x30 && c <= 0x3f) r |= run_csi_p;
+            if (c >= 0x20 && c <= 0x2f) r |= run_csi_i;
+            if (c >= 0x08 && c <= 0x0d) r |= run_cmd_str;
+            if (c != 0x1b)              r |= run_char_str;
+            runs[c] = r;
+        }
+    }
+    uint8 runs[256];
+};
+
+static constexpr byte_class_table s_byte_class;
+
 //------------------------------------------------------------------------------
 static void strip_code_terminator(const char*& ptr, int32& len)
 {
@@ -277,12 +311,33 @@ bool ecma48_code::get_c1_str(str_base& out) const
 //------------------------------------------------------------------------------
 ecma48_iter::ecma48_iter(const char* s, ecma48_state& state, int32 len)
 : m_iter(s, len)
+, m_end((len >= 0) ? s + len : nullptr)
 , m_code(state.code)
 , m_state(state)
 , m_nested_cmd_str(0)
 {
 }
 
+//------------------------------------------------------------------------------
+void ecma48_iter::skip_run(uint8 run)
+{
+    const char* ptr = m_iter.get_pointer();
+    if (m_end)
+    {
+        while (ptr < m_end && (s_byte_class.runs[uint8(*ptr)] & run))
+            ++ptr;
+    }
+    else
+    {
+        // NUL is not a member of any run, so this stops at the terminator.
+        while (s_byte_class.runs[uint8(*ptr)] & run)
+            ++ptr;
+    }
+
+    if (ptr != m_iter.get_pointer())
+        m_iter = str_iter(ptr, m_end ? int32(m_end - ptr) : -1);
+}
+
 //------------------------------------------------------------------------------
 const ecma48_code& ecma48_iter::next()
 {
@@ -387,6 +442,7 @@ bool ecma48_iter::next_char(int32 c)
     }
 
     m_iter.next();
+    skip_run(run_char);
     return false;
 }
 
@@ -400,8 +456,13 @@ bool ecma48_iter::next_char_str(int32 c)
         m_state.state = ecma48_state_esc_st;
         return false;
     }
+    else if (c == 0x9c)
+    {
+        return true;
+    }
 
-    return (c == 0x9c);
+    skip_run(run_char_str);
+    return false;
 }
 
 //------------------------------------------------------------------------------
@@ -432,6 +493,7 @@ bool ecma48_iter::next_cmd_str(int32 c)
     else if (in_range(c, 0x08, 0x0d) || uint32(c) >= uint32(0x20))
     {
         m_iter.next();
+        skip_run(run_cmd_str);
         return false;
     }
 
@@ -448,6 +510,7 @@ bool ecma48_iter::next_csi_f(int32 c)
     if (in_range(c, 0x20, 0x2f))
     {
         m_iter.next();
+        skip_run(run_csi_i);
         return false;
     }
     else if (in_range(c, 0x40, 0x7e))
@@ -469,6 +532,7 @@ bool ecma48_iter::next_csi_p(int32 c)
     if (in_range(c, 0x30, 0x3f))
     {
         m_iter.next();
+        skip_run(run_csi_p);
         return false;
     }
 
@@ -540,6 +604,7 @@ bool ecma48_iter::next_unknown(int32 c)
 
     m_code.m_type = ecma48_code::type_chars;
     m_state.state = ecma48_state_char;
+    skip_run(run_char);
     return false;
 }
 
@@ -0,0 +1,167 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "nearest_color.h"
+#include "cielab.h"
+
+//------------------------------------------------------------------------------
+// attributes::color keeps 5 bits per channel, and as_888() expands them back
+// to 8 bits.  The XTerm 256 color cube and grays arrive here already expanded,
+// so the reverse lookups are built from the expanded values.
+static uint8 expand_5_to_8(uint8 val)
+{
+    val >>= 3;
+    return (val << 3) | (val & 7);
+}
+
+//------------------------------------------------------------------------------
+struct xterm256_levels
+{
+    xterm256_levels()
+    {
+        static const uint8 c_cube[] = { 0x00, 0x5f, 0x87, 0xaf, 0xd7, 0xff };
+
+        memset(cube, -1, sizeof(cube));
+        memset(gray, -1, sizeof(gray));
+        for (int32 i = 0; i < sizeof_array(c_cube); ++i)
+            cube[expand_5_to_8(c_cube[i])] = int8(i);
+        for (int32 i = 0; i < 24; ++i)
+            gray[expand_5_to_8(uint8(0x08 + i * 10))] = int8(i);
+    }
+
+    int8            cube[256];
+    int8            gray[256];
+};
+
+static const xterm256_levels s_levels;
+
+
+
+//------------------------------------------------------------------------------
+nearest_color_cache::nearest_color_cache()
+{
+    invalidate();
+}
+
+//------------------------------------------------------------------------------
+void nearest_color_cache::invalidate()
+{
+    m_has_palette = false;
+    memset(m_xterm256, 0xff, sizeof(m_xterm256));
+    memset(m_hash, 0xff, sizeof(m_hash));
+}
+
+//------------------------------------------------------------------------------
+bool nearest_color_cache::set_palette(const COLORREF (&palette)[16])
+{
+    if (m_has_palette && memcmp(m_palette, palette, sizeof(m_palette)) == 0)
+        return false;
+
+    invalidate();
+
+    memcpy(m_palette, palette, sizeof(m_palette));
+    for (int32 i = 0; i < sizeof_array(m_palette); ++i)
+    {
+        const cie::lab lab(m_palette[i]);
+        m_l[i] = lab.l;
+        m_a[i] = lab.a;
+        m_b[i] = lab.b;
+    }
+
+    m_has_palette = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int32 nearest_color_cache::find(const uint8 (&rgb)[3])
+{
+    if (!m_has_palette)
+        return -1;
+
+    const int32 xterm_idx = get_xterm256_index(rgb);
+    if (xterm_idx >= 0)
+    {
+        uint8& slot = m_xterm256[xterm_idx];
+        if (slot != 0xff)
+        {
+            ++m_hits;
+            return slot;
+        }
+
+        ++m_misses;
+        slot = uint8(find_uncached(rgb));
+        return slot;
+    }
+
+    const uint32 key = (uint32(rgb[0]) << 16) | (uint32(rgb[1]) << 8) | rgb[2];
+    entry* const set = m_hash[(key * 2654435761u) >> (32 - c_set_bits)];
+
+    // Entries are kept in most recently used order.
+    int32 way = 0;
+    for (; way < c_ways - 1; ++way)
+        if (set[way].key == key)
+            break;
+
+    entry e = set[way];
+    memmove(set + 1, set, sizeof(*set) * way);
+
+    if (e.key == key)
+    {
+        ++m_hits;
+    }
+    else
+    {
+        ++m_misses;
+        e.key = key;
+        e.index = uint8(find_uncached(rgb));
+    }
+
+    set[0] = e;
+    return e.index;
+}
+
+//------------------------------------------------------------------------------
+int32 nearest_color_cache::get_xterm256_index(const uint8 (&rgb)[3]) const
+{
+    const int32 r = s_levels.cube[rgb[0]];
+    const int32 g = s_levels.cube[rgb[1]];
+    const int32 b = s_levels.cube[rgb[2]];
+    if (r >= 0 && g >= 0 && b >= 0)
+        return 16 + (r * 36) + (g * 6) + b;
+
+    if (rgb[0] == rgb[1] && rgb[1] == rgb[2])
+    {
+        const int32 gray = s_levels.gray[rgb[0]];
+        if (gray >= 0)
+            return 232 + gray;
+    }
+
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int32 nearest_color_cache::find_uncached(const uint8 (&rgb)[3]) const
+{
+    const cie::lab target(RGB(rgb[0], rgb[1], rgb[2]));
+
+    // Keep this loop free of branches so it vectorizes.
+    double deltaE[16];
+    for (int32 i = 0; i < 16; ++i)
+    {
+        const double l = target.l - m_l[i];
+        const double a = target.a - m_a[i];
+        const double b = target.b - m_b[i];
+        deltaE[i] = (l * l) + (a * a) + (b * b);
+    }
+
+    // Ties go to the higher index, the same as get_nearest_color().
+    int32 best_idx = 15;
+    for (int32 i = 15; i--;)
+    {
+        if (deltaE[best_idx] > deltaE[i])
+            best_idx = i;
+    }
+
+    return best_idx;
+}
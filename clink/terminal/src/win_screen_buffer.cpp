@@ -235,6 +235,8 @@ void win_screen_buffer::begin()
     if (m_ready > 1)
         return;
 
+    m_palette_stale = true;
+
     static bool s_detect_native_ansi_handler = true;
     const bool detect_native_ansi_handler = s_detect_native_ansi_handler;
 
@@ -861,7 +863,7 @@ void win_screen_buffer::set_attributes(attributes attr)
 }
 
 //------------------------------------------------------------------------------
-static bool get_nearest_color(void* handle, const uint8 (&rgb)[3], uint8& attr)
+static bool get_console_palette(void* handle, nearest_color_cache& cache)
 {
     static HMODULE hmod = GetModuleHandle("kernel32.dll");
     static FARPROC proc = GetProcAddress(hmod, "GetConsoleScreenBufferInfoEx");
@@ -873,7 +875,14 @@ static bool get_nearest_color(void* handle, const uint8 (&rgb)[3], uint8& attr)
     if (!GCSBIEx(proc)(handle, &infoex))
         return false;
 
-    const int32 best_idx = get_nearest_color(infoex, rgb);
+    cache.set_palette(infoex.ColorTable);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool get_nearest_color(nearest_color_cache& cache, const uint8 (&rgb)[3], uint8& attr)
+{
+    const int32 best_idx = cache.find(rgb);
     if (best_idx < 0)
         return false;
 
@@ -887,12 +896,24 @@ bool win_screen_buffer::get_nearest_color(attributes& attr) const
 {
     const attributes::color fg = attr.get_fg().value;
     const attributes::color bg = attr.get_bg().value;
+    if (!fg.is_rgb && !bg.is_rgb)
+        return true;
+
+    // The palette is read at most once per begin()/end() pair; the cache
+    // discards its results if the palette differs from last time.
+    if (m_palette_stale || !m_ready)
+    {
+        if (!get_console_palette(m_handle, m_nearest))
+            return false;
+        m_palette_stale = false;
+    }
+
     if (fg.is_rgb)
     {
         uint8 val;
         uint8 rgb[3];
         fg.as_888(rgb);
-        if (!::get_nearest_color(m_handle, rgb, val))
+        if (!::get_nearest_color(m_nearest, rgb, val))
             return false;
         attr.set_fg(val);
     }
@@ -901,7 +922,7 @@ bool win_screen_buffer::get_nearest_color(attributes& attr) const
         uint8 val;
         uint8 rgb[3];
         bg.as_888(rgb);
-        if (!::get_nearest_color(m_handle, rgb, val))
+        if (!::get_nearest_color(m_nearest, rgb, val))
             return false;
         attr.set_bg(val);
     }
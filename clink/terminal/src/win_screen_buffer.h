@@ -4,6 +4,7 @@
 #pragma once
 
 #include "screen_buffer.h"
+#include "nearest_color.h"
 
 class str_base;
 enum find_line_mode : int32;
@@ -65,6 +66,9 @@ private:
     mutable WORD*   m_attrs = nullptr;
     mutable SHORT   m_attrs_capacity = 0;
 
+    mutable nearest_color_cache m_nearest;
+    mutable bool    m_palette_stale = true;
+
     mutable WCHAR*  m_chars = nullptr;
     mutable SHORT   m_chars_capacity = 0;
 
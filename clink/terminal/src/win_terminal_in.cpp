@@ -1059,15 +1059,20 @@ void win_terminal_in::read_console(input_idle* callback, DWORD _timeout, bool pe
 
             fix_console_input_mode();
 
+            // Honor whichever timeout comes first, so the callback still gets
+            // idle time (e.g. for garbage collection) during a timed wait.
             DWORD timeout = callback ? callback->get_timeout() : INFINITE;
+            bool caller_timeout = false;
             if (_timeout != INFINITE)
             {
                 const DWORD now = GetTickCount();
                 const DWORD elapsed = now - started;
-                if (elapsed < _timeout)
-                    timeout = _timeout - elapsed;
-                else
-                    timeout = 0;
+                const DWORD remaining = (elapsed < _timeout) ? _timeout - elapsed : 0;
+                if (remaining <= timeout)
+                {
+                    timeout = remaining;
+                    caller_timeout = true;
+                }
             }
 
             const DWORD waited = WaitForMultipleObjects(count, handles, false, timeout);
@@ -1100,7 +1105,7 @@ void win_terminal_in::read_console(input_idle* callback, DWORD _timeout, bool pe
             if (has_mode)
                 fix_console_output_mode(m_stdout, modeExpected);
 
-            if (!callback && waited == WAIT_TIMEOUT)
+            if (waited == WAIT_TIMEOUT && (!callback || caller_timeout))
                 return;
         }
 
@@ -446,3 +446,54 @@ TEST_CASE("ecma48 osc envvar")
         REQUIRE(code->get_length() == 2);
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 bounded runs")
+{
+    const ecma48_code* code;
+
+    // A length limit must end runs of chars and CSI params mid-way.
+    ecma48_iter iter("abcdef", g_state, 4);
+    code = &iter.next();
+    REQUIRE(*code);
+    REQUIRE(code->get_type() == ecma48_code::type_chars);
+    REQUIRE(code->get_length() == 4);
+    REQUIRE(!iter.next());
+
+    new (&iter) ecma48_iter("\x1b[38;2;1;2;3m", g_state, 8);
+    REQUIRE(!iter.next());
+
+    // Non-ASCII chars inside a run are still decoded as codepoints.
+    new (&iter) ecma48_iter("a\xe2\x94\x80" "b\xc2\x9b" "1m", g_state);
+    code = &iter.next();
+    REQUIRE(*code);
+    REQUIRE(code->get_type() == ecma48_code::type_chars);
+    REQUIRE(code->get_length() == 5);
+    code = &iter.next();
+    REQUIRE(*code);
+    REQUIRE(code->get_type() == ecma48_code::type_c1);
+    REQUIRE(code->get_code() == ecma48_code::c1_csi);
+    REQUIRE(code->get_length() == 4);
+    REQUIRE(!iter.next());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 large colored output")
+{
+    // Resembles a colored directory listing; run with -t to see timing.
+    str_moveable in;
+    str_moveable expected;
+    for (uint32 i = 0; i < 20000; ++i)
+    {
+        str<> name;
+        name.format("file_name_%05u.txt", i);
+        in << "\x1b[38;2;12;34;56m" << name.c_str() << "\x1b[m \x1b]8;;x\x07\xe2\x94\x80\x1b]8;;\x07\r\n";
+        expected << name.c_str() << " \xe2\x94\x80\r\n";
+    }
+
+    str_moveable out;
+    uint32 cells = 0;
+    ecma48_processor(in.c_str(), &out, &cells, ecma48_processor_flags::plaintext);
+    REQUIRE(out.equals(expected.c_str()));
+    REQUIRE(cells == cell_count(expected.c_str()));
+}
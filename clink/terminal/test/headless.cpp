@@ -0,0 +1,129 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "headless_terminal.h"
+
+#include <terminal/find_line.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("headless terminal")
+{
+    headless_terminal_out out(10, 4);
+    headless_screen_buffer& screen = out.get_screen();
+    str<> line;
+
+    SECTION("wrap")
+    {
+        out.write("0123456789");
+        REQUIRE(screen.get_cursor_column() == 9);
+        REQUIRE(screen.get_cursor_row() == 0);
+
+        out.write("ab");
+        REQUIRE(screen.get_cursor_column() == 2);
+        REQUIRE(screen.get_cursor_row() == 1);
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.equals("0123456789"));
+        REQUIRE(screen.get_line_text(1, line));
+        REQUIRE(line.equals("ab"));
+    }
+
+    SECTION("deferred wrap is cancelled by cursor movement")
+    {
+        out.write("0123456789\r");
+        out.write("x");
+        REQUIRE(screen.get_cursor_row() == 0);
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.equals("x123456789"));
+    }
+
+    SECTION("cursor and erase")
+    {
+        out.write("abcdef\x1b[3D\x1b[K");
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.equals("abc"));
+
+        out.write("\x1b[2;5Hxy\x1b[1D\x1b[1P");
+        REQUIRE(screen.get_line_text(1, line));
+        REQUIRE(line.equals("    x"));
+
+        out.write("\x1b[1;2H\x1b[2@");
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.equals("a  bc"));
+
+        out.write("\x1b[H\x1b[2J");
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.empty());
+        REQUIRE(screen.get_line_text(1, line));
+        REQUIRE(line.empty());
+    }
+
+    SECTION("scroll")
+    {
+        out.write("1\n2\n3\n4\n5");
+        REQUIRE(screen.get_scrolled_lines() == 1);
+        REQUIRE(screen.get_line_text(0, line));
+        REQUIRE(line.equals("2"));
+        REQUIRE(screen.get_line_text(3, line));
+        REQUIRE(line.equals("5"));
+    }
+
+    SECTION("sgr")
+    {
+        out.write("a\x1b[31mb\x1b[m");
+        REQUIRE(screen.is_line_default_color(0) == false);
+        REQUIRE(screen.get_cell_attributes(1, 0).get_fg()->value != screen.get_cell_attributes(0, 0).get_fg()->value);
+
+        out.write("\x1b[2K");
+        REQUIRE(screen.is_line_default_color(0) == true);
+    }
+
+    SECTION("line_has_color")
+    {
+        // Console attributes:  red is 0x04, default is grey on black.
+        const BYTE red = 0x04;
+        const BYTE grey = 0x07;
+        const BYTE red_on_blue = 0x14;
+
+        out.write("a\x1b[31mb\x1b[m\n\x1b[1;44mc\x1b[m");
+        REQUIRE(screen.line_has_color(0, &red, 1) == true);
+        REQUIRE(screen.line_has_color(0, &grey, 1) == true);
+        REQUIRE(screen.line_has_color(0, &red_on_blue, 1) == false);
+        REQUIRE(screen.line_has_color(0, &red_on_blue, 1, 0x0f) == true);
+        REQUIRE(screen.line_has_color(1, &red, 1) == false);
+
+        const BYTE bright_on_blue = 0x1f;
+        REQUIRE(screen.line_has_color(1, &bright_on_blue, 1) == true);
+        REQUIRE(screen.line_has_color(4, &grey, 1) == -1);
+    }
+
+    SECTION("find_line")
+    {
+        const BYTE green = 0x02;
+
+        out.write("alpha\nBeta \x1b[32mgamma\x1b[m\ndelta");
+        REQUIRE(screen.find_line(0, 4, "gamma", find_line_mode::none) == 1);
+        REQUIRE(screen.find_line(3, -4, "alpha", find_line_mode::none) == 0);
+        REQUIRE(screen.find_line(0, 4, "BETA", find_line_mode::none) == -1);
+        REQUIRE(screen.find_line(0, 4, "BETA", find_line_mode::ignore_case) == 1);
+        REQUIRE(screen.find_line(0, 4, "^d.l", find_line_mode::use_regex) == 2);
+        REQUIRE(screen.find_line(0, 4, "zeta", find_line_mode::none) == -1);
+        REQUIRE(screen.find_line(2, -1, "alpha", find_line_mode::none) == -1);
+        REQUIRE(screen.find_line(4, 1, "alpha", find_line_mode::none) == 0);
+
+        // Attributes are only checked within the matched text.
+        REQUIRE(screen.find_line(0, 4, "gamma", find_line_mode::none, &green, 1) == 1);
+        REQUIRE(screen.find_line(0, 4, "Beta", find_line_mode::none, &green, 1) == -1);
+        REQUIRE(screen.find_line(0, 4, nullptr, find_line_mode::none, &green, 1) == 1);
+    }
+
+    SECTION("stats")
+    {
+        out.reset_stats();
+        out.write("ab\x1b[31mc\x1b[m\r\n");
+        REQUIRE(out.get_stats().writes == 1);
+        REQUIRE(out.get_stats().bytes == 13);
+        REQUIRE(out.get_stats().escapes == 2);
+        REQUIRE(out.get_stats().controls == 2);
+    }
+}
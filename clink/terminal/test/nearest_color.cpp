@@ -0,0 +1,306 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_tokeniser.h>
+#include <terminal/attributes.h>
+#include <terminal/nearest_color.h>
+#include <terminal/terminal_helpers.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static const COLORREF c_campbell[16] =
+{
+    RGB(0x0c,0x0c,0x0c), RGB(0x00,0x37,0xda), RGB(0x13,0xa1,0x0e), RGB(0x3a,0x96,0xdd),
+    RGB(0xc5,0x0f,0x1f), RGB(0x88,0x17,0x98), RGB(0xc1,0x9c,0x00), RGB(0xcc,0xcc,0xcc),
+    RGB(0x76,0x76,0x76), RGB(0x3b,0x78,0xff), RGB(0x16,0xc6,0x0c), RGB(0x61,0xd6,0xd6),
+    RGB(0xe7,0x48,0x56), RGB(0xb4,0x00,0x9e), RGB(0xf9,0xf1,0xa5), RGB(0xf2,0xf2,0xf2),
+};
+
+static const COLORREF c_legacy[16] =
+{
+    RGB(0x00,0x00,0x00), RGB(0x00,0x00,0x80), RGB(0x00,0x80,0x00), RGB(0x00,0x80,0x80),
+    RGB(0x80,0x00,0x00), RGB(0x80,0x00,0x80), RGB(0x80,0x80,0x00), RGB(0xc0,0xc0,0xc0),
+    RGB(0x80,0x80,0x80), RGB(0x00,0x00,0xff), RGB(0x00,0xff,0x00), RGB(0x00,0xff,0xff),
+    RGB(0xff,0x00,0x00), RGB(0xff,0x00,0xff), RGB(0xff,0xff,0x00), RGB(0xff,0xff,0xff),
+};
+
+//------------------------------------------------------------------------------
+struct rgb_color
+{
+    uint8 rgb[3];
+};
+
+//------------------------------------------------------------------------------
+static void add_color(uint8 r, uint8 g, uint8 b, std::vector<rgb_color>& out)
+{
+    // Produces the RGB values the way win_screen_buffer sees them, after
+    // they've been through attributes::color.
+    attributes attr;
+    attr.set_fg(r, g, b);
+
+    rgb_color color;
+    attr.get_fg().value.as_888(color.rgb);
+    out.push_back(color);
+}
+
+//------------------------------------------------------------------------------
+static void add_xterm256_color(int32 idx, std::vector<rgb_color>& out)
+{
+    static const uint8 c_cube[] = { 0x00, 0x5f, 0x87, 0xaf, 0xd7, 0xff };
+
+    // The first 16 are the console palette itself, so there's nothing to find.
+    if (idx < 16 || idx > 255)
+        return;
+
+    if (idx >= 232)
+    {
+        const uint8 gray = 0x08 + (idx - 232) * 10;
+        add_color(gray, gray, gray, out);
+    }
+    else
+    {
+        idx -= 16;
+        add_color(c_cube[idx / 36], c_cube[(idx / 6) % 6], c_cube[idx % 6], out);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void add_sgr_colors(const char* params, std::vector<rgb_color>& out)
+{
+    std::vector<int32> values;
+    str<16> token;
+    str_tokeniser tokens(params, ";");
+    while (tokens.next(token))
+        values.push_back(atoi(token.c_str()));
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i] != 38 && values[i] != 48)
+            continue;
+        if (i + 2 < values.size() && values[i + 1] == 5)
+        {
+            add_xterm256_color(values[i + 2], out);
+            i += 2;
+        }
+        else if (i + 4 < values.size() && values[i + 1] == 2)
+        {
+            add_color(uint8(values[i + 2]), uint8(values[i + 3]), uint8(values[i + 4]), out);
+            i += 4;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Collects the RGB and XTerm256 colors a .clinktheme file uses.  Named colors
+// are console palette colors and don't need a nearest color search.
+static bool load_theme_colors(const char* file, std::vector<rgb_color>& out)
+{
+    FILE* f = fopen(file, "rt");
+    if (!f)
+        return false;
+
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), f))
+    {
+        str<> line(buffer);
+        line.trim();
+        if (line.empty() || line.c_str()[0] == '#' || line.c_str()[0] == '[')
+            continue;
+
+        const char* value = strchr(line.c_str(), '=');
+        if (!value)
+            continue;
+
+        bool sgr = false;
+        str<> token;
+        str_tokeniser tokens(value + 1, " ");
+        while (tokens.next(token))
+        {
+            if (sgr)
+            {
+                add_sgr_colors(token.c_str(), out);
+                sgr = false;
+            }
+            else if (token.equals("sgr"))
+            {
+                sgr = true;
+            }
+            else if (token.c_str()[0] == '#' && token.length() == 7)
+            {
+                const uint32 rgb = strtoul(token.c_str() + 1, nullptr, 16);
+                add_color(uint8(rgb >> 16), uint8(rgb >> 8), uint8(rgb), out);
+            }
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool find_themes_dir(const char* start, str_base& out)
+{
+    // The tests run from somewhere inside the repo, e.g. the root or the
+    // build output directory.
+    str<> dir(start);
+    while (true)
+    {
+        out = dir.c_str();
+        path::append(out, "clink\\app\\themes");
+        if (os::get_path_type(out.c_str()) == os::path_type_dir)
+            return true;
+        if (!path::to_parent(dir, nullptr))
+            return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+static int32 reference_nearest_color(const COLORREF (&palette)[16], const uint8 (&rgb)[3])
+{
+    CONSOLE_SCREEN_BUFFER_INFOEX csbix = { sizeof(csbix) };
+    memcpy(csbix.ColorTable, palette, sizeof(csbix.ColorTable));
+    return get_nearest_color(csbix, rgb);
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("nearest color : matches uncached search")
+{
+    const COLORREF (*palettes[])[16] = { &c_campbell, &c_legacy };
+    for (auto palette : palettes)
+    {
+        nearest_color_cache cache;
+        REQUIRE(cache.find({ 0, 0, 0 }) < 0);
+        REQUIRE(cache.set_palette(*palette));
+
+        // Every color attributes::color can represent, twice so the second
+        // pass is served from the caches.
+        for (int32 pass = 0; pass < 2; ++pass)
+        {
+            for (uint32 i = 0; i < 0x8000; ++i)
+            {
+                attributes attr;
+                attr.set_fg(uint8((i >> 10) << 3), uint8(((i >> 5) & 0x1f) << 3), uint8((i & 0x1f) << 3));
+
+                uint8 rgb[3];
+                attr.get_fg().value.as_888(rgb);
+                REQUIRE(cache.find(rgb) == reference_nearest_color(*palette, rgb));
+            }
+        }
+
+        // Arbitrary RGB values that aren't quantized.
+        for (uint32 i = 0; i < 0x1000; ++i)
+        {
+            const uint32 value = i * 0x10101 * 7 + 0x123;
+            const uint8 rgb[3] = { uint8(value >> 16), uint8(value >> 8), uint8(value) };
+            REQUIRE(cache.find(rgb) == reference_nearest_color(*palette, rgb));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("nearest color : palette changes")
+{
+    nearest_color_cache cache;
+    REQUIRE(cache.set_palette(c_legacy));
+
+    const uint8 rgb[3] = { 0xe0, 0x10, 0x10 };
+    REQUIRE(cache.find(rgb) == 12);
+    REQUIRE(cache.get_misses() == 1);
+
+    // Same palette keeps the cached results.
+    REQUIRE(!cache.set_palette(c_legacy));
+    REQUIRE(cache.find(rgb) == 12);
+    REQUIRE(cache.get_hits() == 1);
+
+    // Different palette discards them.
+    COLORREF palette[16];
+    memcpy(palette, c_legacy, sizeof(palette));
+    palette[4] = RGB(0xe0, 0x10, 0x10);
+    REQUIRE(cache.set_palette(palette));
+    REQUIRE(cache.find(rgb) == 4);
+    REQUIRE(cache.get_misses() == 2);
+
+    cache.invalidate();
+    REQUIRE(!cache.has_palette());
+    REQUIRE(cache.find(rgb) < 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("nearest color : bundled themes")
+{
+    static const char* const c_themes[] =
+    {
+        "4-bit Enhanced Defaults",
+        "Clink Dark",
+        "Clink Light",
+        "Dracula",
+        "Enhanced Defaults",
+        "Plain",
+        "Solarized Dark",
+        "Solarized Light",
+        "Tomorrow Night Blue",
+        "Tomorrow Night Bright",
+        "Tomorrow Night Eighties",
+        "Tomorrow Night",
+        "Tomorrow",
+    };
+
+    str<> themes_dir;
+    {
+        str<> start;
+        wchar_t module[MAX_PATH];
+        const DWORD len = GetModuleFileNameW(nullptr, module, sizeof_array(module));
+        if (len && len < sizeof_array(module))
+        {
+            start = module;
+            path::to_parent(start, nullptr);
+        }
+        if (!find_themes_dir(start.c_str(), themes_dir))
+        {
+            os::get_current_dir(start);
+            REQUIRE(find_themes_dir(start.c_str(), themes_dir));
+        }
+    }
+
+    // Simulates repainting a prompt and input line that use each theme's colors
+    // many times, comparing the cache against searching the palette each time.
+    const uint32 c_repaints = 200;
+
+    for (const char* theme : c_themes)
+    {
+        str<> file(themes_dir.c_str());
+        path::append(file, theme);
+        file.concat(".clinktheme");
+
+        std::vector<rgb_color> colors;
+        REQUIRE(load_theme_colors(file.c_str(), colors), [&] () {
+            printf("file: %s\n", file.c_str());
+        });
+
+        std::vector<int32> expected;
+        for (const auto& c : colors)
+            expected.push_back(reference_nearest_color(c_campbell, c.rgb));
+
+        nearest_color_cache cache;
+        cache.set_palette(c_campbell);
+        for (uint32 n = c_repaints; n--;)
+        {
+            std::vector<int32> actual;
+            for (const auto& c : colors)
+                actual.push_back(cache.find(c.rgb));
+            REQUIRE(actual == expected);
+        }
+
+        // Each distinct color is searched for at most once.
+        REQUIRE(cache.get_misses() <= colors.size());
+        REQUIRE(cache.get_misses() + cache.get_hits() == c_repaints * colors.size());
+    }
+}
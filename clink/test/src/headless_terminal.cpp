@@ -0,0 +1,557 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "headless_terminal.h"
+
+#include <core/base.h>
+#include <core/str_transform.h>
+#include <terminal/find_line.h>
+#include <terminal/wcwidth.h>
+
+#include <memory>
+#include <regex>
+
+//------------------------------------------------------------------------------
+headless_screen_buffer::headless_screen_buffer(int32 columns, int32 rows)
+: m_columns(max<int32>(columns, 1))
+, m_rows(max<int32>(rows, 1))
+, m_attr(attributes::defaults)
+{
+    m_cells.resize(m_columns * m_rows);
+    fill(0, 0, m_columns * m_rows);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::fill(int32 column, int32 row, int32 count)
+{
+    cell* c = &at(column, row);
+    cell* const end = m_cells.data() + m_cells.size();
+    for (; count > 0 && c < end; --count, ++c)
+    {
+        c->text[0] = ' ';
+        c->len = 1;
+        c->attr = m_attr;
+    }
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::line_feed()
+{
+    m_pending_wrap = false;
+    m_cursor_x = 0;
+    if (m_cursor_y + 1 < m_rows)
+    {
+        ++m_cursor_y;
+        return;
+    }
+
+    m_cells.erase(m_cells.begin(), m_cells.begin() + m_columns);
+    m_cells.resize(m_columns * m_rows);
+    fill(0, m_rows - 1, m_columns);
+    ++m_scrolled;
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::put(const char* text, uint32 len, int32 width)
+{
+    if (m_pending_wrap || m_cursor_x + width > m_columns)
+        line_feed();
+
+    cell& c = at(m_cursor_x, m_cursor_y);
+    len = min<uint32>(len, sizeof(c.text));
+    memcpy(c.text, text, len);
+    c.len = uint8(len);
+    c.attr = m_attr;
+
+    for (int32 i = 1; i < width; ++i)
+    {
+        cell& cont = at(m_cursor_x + i, m_cursor_y);
+        cont.len = 0;
+        cont.attr = m_attr;
+    }
+
+    m_cursor_x += width;
+    if (m_cursor_x >= m_columns)
+    {
+        m_cursor_x = m_columns - 1;
+        m_pending_wrap = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::write(const char* data, int32 length)
+{
+    if (length < 0)
+        length = int32(strlen(data));
+
+    wcwidth_iter iter(data, length);
+    while (const char32_t c = iter.next())
+    {
+        if (c == '\n')
+        {
+            line_feed();
+        }
+        else if (c == '\t')
+        {
+            const int32 stop = min<int32>(m_columns - 1, (m_cursor_x + 8) & ~7);
+            while (m_cursor_x < stop)
+                put(" ", 1, 1);
+        }
+        else if (iter.character_wcwidth_signed() > 0)
+        {
+            put(iter.character_pointer(), iter.character_length(), iter.character_wcwidth_signed());
+        }
+        else if (iter.character_wcwidth_signed() == 0 && m_cursor_x > 0)
+        {
+            // Append combining marks to the preceding cell.
+            cell& prev = at(m_pending_wrap ? m_cursor_x : m_cursor_x - 1, m_cursor_y);
+            const uint32 len = iter.character_length();
+            if (prev.len && prev.len + len <= sizeof(prev.text))
+            {
+                memcpy(prev.text + prev.len, iter.character_pointer(), len);
+                prev.len += uint8(len);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool headless_screen_buffer::get_line_text(int32 line, str_base& out) const
+{
+    out.clear();
+    if (line < 0 || line >= m_rows)
+        return false;
+
+    for (int32 x = 0; x < m_columns; ++x)
+    {
+        const cell& c = at(x, line);
+        out.concat(c.text, c.len);
+    }
+
+    int32 len = out.length();
+    while (len > 0 && out.c_str()[len - 1] == ' ')
+        --len;
+    out.truncate(len);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::clear(clear_type type)
+{
+    switch (type)
+    {
+    case clear_type_all:
+        fill(0, 0, m_columns * m_rows);
+        break;
+    case clear_type_before:
+        fill(0, 0, m_cursor_y * m_columns + m_cursor_x + 1);
+        break;
+    case clear_type_after:
+        fill(m_cursor_x, m_cursor_y, (m_rows - m_cursor_y) * m_columns - m_cursor_x);
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::clear_line(clear_type type)
+{
+    switch (type)
+    {
+    case clear_type_all:
+        fill(0, m_cursor_y, m_columns);
+        break;
+    case clear_type_before:
+        fill(0, m_cursor_y, m_cursor_x + 1);
+        break;
+    case clear_type_after:
+        fill(m_cursor_x, m_cursor_y, m_columns - m_cursor_x);
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::set_horiz_cursor(int32 column)
+{
+    m_pending_wrap = false;
+    m_cursor_x = clamp(column, 0, m_columns - 1);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::set_cursor(int32 column, int32 row)
+{
+    m_pending_wrap = false;
+    m_cursor_x = clamp(column, 0, m_columns - 1);
+    m_cursor_y = clamp(row, 0, m_rows - 1);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::move_cursor(int32 dx, int32 dy)
+{
+    m_pending_wrap = false;
+    m_cursor_x = clamp(m_cursor_x + dx, 0, m_columns - 1);
+    m_cursor_y = clamp(m_cursor_y + dy, 0, m_rows - 1);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::save_cursor()
+{
+    m_saved_x = m_cursor_x;
+    m_saved_y = m_cursor_y;
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::restore_cursor()
+{
+    if (m_saved_x >= 0 && m_saved_y >= 0)
+        set_cursor(m_saved_x, m_saved_y);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::insert_chars(int32 count)
+{
+    count = min<int32>(count, m_columns - m_cursor_x);
+    if (count <= 0)
+        return;
+
+    cell* const row = &at(0, m_cursor_y);
+    memmove(row + m_cursor_x + count, row + m_cursor_x, (m_columns - m_cursor_x - count) * sizeof(cell));
+    fill(m_cursor_x, m_cursor_y, count);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::delete_chars(int32 count)
+{
+    count = min<int32>(count, m_columns - m_cursor_x);
+    if (count <= 0)
+        return;
+
+    cell* const row = &at(0, m_cursor_y);
+    memmove(row + m_cursor_x, row + m_cursor_x + count, (m_columns - m_cursor_x - count) * sizeof(cell));
+    fill(m_columns - count, m_cursor_y, count);
+}
+
+//------------------------------------------------------------------------------
+void headless_screen_buffer::set_attributes(const attributes attr)
+{
+    m_attr = attributes::merge(m_attr, attr);
+}
+
+//------------------------------------------------------------------------------
+int32 headless_screen_buffer::is_line_default_color(int32 line) const
+{
+    if (line < 0 || line >= m_rows)
+        return -1;
+
+    const attributes defaults(attributes::defaults);
+    for (int32 x = 0; x < m_columns; ++x)
+    {
+        attributes attr = at(x, line).attr;
+        if (attr != defaults)
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+attributes headless_screen_buffer::get_cell_attributes(int32 column, int32 row) const
+{
+    column = clamp(column, 0, m_columns - 1);
+    row = clamp(row, 0, m_rows - 1);
+    return at(column, row).attr;
+}
+
+//------------------------------------------------------------------------------
+// Reports a cell's attributes the way a console would:  foreground in the low
+// nibble, background in the high nibble, intensity from bold.  RGB and 256
+// color values have no console equivalent here and read as the default.
+BYTE headless_screen_buffer::get_console_attr(int32 column, int32 row) const
+{
+    auto to_console = [] (const attributes::attribute<attributes::color>& c, int32 dflt) {
+        if (!c || c.is_default || c->is_rgb || c->value > 15)
+            return dflt;
+        const int32 rgbi = c->value;
+        return (rgbi & 0x0a) | ((rgbi & 0x01) << 2) | !!(rgbi & 0x04);
+    };
+
+    const attributes attr = at(column, row).attr;
+    int32 fg = to_console(attr.get_fg(), 0x07);
+    int32 bg = to_console(attr.get_bg(), 0x00);
+
+    const auto bold = attr.get_bold();
+    if (bold && bold.value)
+        fg |= 0x08;
+
+    const auto reverse = attr.get_reverse();
+    if (reverse && reverse.value)
+        std::swap(fg, bg);
+
+    return BYTE((bg << 4) | fg);
+}
+
+//------------------------------------------------------------------------------
+bool headless_screen_buffer::has_console_attr(int32 row, int32 column, int32 count, const BYTE* attrs, int32 num_attrs, BYTE mask) const
+{
+    const BYTE* end_attrs = attrs + num_attrs;
+    for (int32 x = max<int32>(column, 0); x < m_columns && x < column + count; ++x)
+    {
+        const BYTE attr = get_console_attr(x, row);
+        for (const BYTE* find_attr = attrs; find_attr < end_attrs; find_attr++)
+            if ((attr & mask) == (*find_attr & mask))
+                return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+int32 headless_screen_buffer::line_has_color(int32 line, const BYTE* attrs, int32 num_attrs, BYTE mask) const
+{
+    if (line < 0 || line >= m_rows)
+        return -1;
+
+    return has_console_attr(line, 0, m_columns, attrs, num_attrs, mask);
+}
+
+//------------------------------------------------------------------------------
+int32 headless_screen_buffer::find_line(int32 starting_line, int32 distance, const char* text, find_line_mode mode, const BYTE* attrs, int32 num_attrs, BYTE mask) const
+{
+    wstr_moveable find;
+    wstr_moveable tmp;
+    std::unique_ptr<std::wregex> regex;
+    if (text && *text)
+    {
+        find = text;
+
+        if (mode & find_line_mode::use_regex)
+        {
+            std::regex_constants::syntax_option_type syntax = std::regex_constants::ECMAScript;
+            if (mode & find_line_mode::ignore_case)
+                syntax |= std::regex_constants::icase;
+
+            try
+            {
+                regex = std::make_unique<std::wregex>(find.c_str(), syntax);
+            }
+            catch (std::regex_error ex)
+            {
+                return -1;
+            }
+        }
+        else if (mode & find_line_mode::ignore_case)
+        {
+            str_transform(find.c_str(), find.length(), tmp, transform_mode::lower);
+            find = std::move(tmp);
+        }
+    }
+
+    // Maps each UTF16 character in a line's text back to its column, so that
+    // attributes can be checked for just the matched text.
+    wstr_moveable line_text;
+    std::vector<int32> columns;
+
+    while (distance != 0)
+    {
+        if (starting_line < 0 || starting_line >= m_rows)
+            return 0;
+
+        int32 start_found = 0;
+        int32 len_found = m_columns;
+
+        bool found_text = true;
+        if (text)
+        {
+            line_text.clear();
+            columns.clear();
+            for (int32 x = 0; x < m_columns; ++x)
+            {
+                const cell& c = at(x, starting_line);
+                if (!c.len)
+                    continue;
+
+                wstr<16> w;
+                str_iter iter(c.text, c.len);
+                to_utf16(w, iter);
+                line_text.concat(w.c_str(), w.length());
+                columns.insert(columns.end(), w.length(), x);
+            }
+
+            int32 len = line_text.length();
+            while (len > 0 && iswspace(line_text.c_str()[len - 1]))
+                len--;
+            line_text.truncate(len);
+            columns.push_back(len ? columns[len - 1] + 1 : 0);
+
+            if (!regex && (mode & find_line_mode::ignore_case))
+            {
+                str_transform(line_text.c_str(), line_text.length(), tmp, transform_mode::lower);
+                line_text = std::move(tmp);
+            }
+
+            int32 found_index = -1;
+            int32 found_length = 0;
+            if (regex)
+            {
+                std::wcmatch matches;
+                try
+                {
+                    std::regex_search(line_text.c_str(), line_text.c_str() + line_text.length(), matches, *regex, std::regex_constants::match_default);
+                }
+                catch (std::regex_error ex)
+                {
+                    return -2;
+                }
+
+                if (matches.size() > 0)
+                {
+                    found_index = int32(matches.position(0));
+                    found_length = int32(matches.length(0));
+                }
+            }
+            else
+            {
+                // Presume that str_transform preserved the alignment between
+                // text and columns.
+                const wchar_t* found = wcsstr(line_text.c_str(), find.c_str());
+                if (found)
+                {
+                    found_index = int32(found - line_text.c_str());
+                    found_length = find.length();
+                }
+            }
+
+            found_text = (found_index >= 0);
+            if (found_text)
+            {
+                const int32 last = min<int32>(found_index + found_length, int32(columns.size()) - 1);
+                start_found = columns[min<int32>(found_index, last)];
+                len_found = columns[last] - start_found;
+            }
+        }
+
+        bool found_attr = true;
+        if (attrs && num_attrs)
+            found_attr = has_console_attr(starting_line, start_found, len_found, attrs, num_attrs, mask);
+
+        if (found_text && found_attr)
+            return starting_line;
+
+        if (distance > 0)
+        {
+            starting_line++;
+            distance--;
+        }
+        else
+        {
+            starting_line--;
+            distance++;
+        }
+    }
+
+    return -1;
+}
+
+
+
+//------------------------------------------------------------------------------
+headless_terminal_out::headless_terminal_out(int32 columns, int32 rows)
+: m_screen(columns, rows)
+{
+    m_terminal = terminal_create(&m_screen);
+}
+
+//------------------------------------------------------------------------------
+headless_terminal_out::~headless_terminal_out()
+{
+    terminal_destroy(m_terminal);
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::open()
+{
+    m_terminal.out->open();
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::begin()
+{
+    m_terminal.out->begin();
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::end()
+{
+    m_terminal.out->end();
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::close()
+{
+    m_terminal.out->close();
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::write(const char* chars, int32 length)
+{
+    if (length < 0)
+        length = int32(strlen(chars));
+
+    ++m_stats.writes;
+    m_stats.bytes += length;
+
+    ecma48_iter iter(chars, m_state, length);
+    while (const ecma48_code& code = iter.next())
+    {
+        switch (code.get_type())
+        {
+        case ecma48_code::type_c0:  ++m_stats.controls; break;
+        case ecma48_code::type_c1:
+        case ecma48_code::type_icf: ++m_stats.escapes; break;
+        }
+    }
+
+    m_terminal.out->write(chars, length);
+}
+
+//------------------------------------------------------------------------------
+void headless_terminal_out::flush()
+{
+    m_terminal.out->flush();
+}
+
+//------------------------------------------------------------------------------
+int32 headless_terminal_out::get_columns() const
+{
+    return m_terminal.out->get_columns();
+}
+
+//------------------------------------------------------------------------------
+int32 headless_terminal_out::get_rows() const
+{
+    return m_terminal.out->get_rows();
+}
+
+//------------------------------------------------------------------------------
+bool headless_terminal_out::get_line_text(int32 line, str_base& out) const
+{
+    return m_terminal.out->get_line_text(line, out);
+}
+
+//------------------------------------------------------------------------------
+int32 headless_terminal_out::is_line_default_color(int32 line) const
+{
+    return m_terminal.out->is_line_default_color(line);
+}
+
+//------------------------------------------------------------------------------
+int32 headless_terminal_out::line_has_color(int32 line, const BYTE* attrs, int32 num_attrs, BYTE mask) const
+{
+    return m_terminal.out->line_has_color(line, attrs, num_attrs, mask);
+}
+
+//------------------------------------------------------------------------------
+int32 headless_terminal_out::find_line(int32 starting_line, int32 distance, const char* text, find_line_mode mode, const BYTE* attrs, int32 num_attrs, BYTE mask) const
+{
+    return m_terminal.out->find_line(starting_line, distance, text, mode, attrs, num_attrs, mask);
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2026 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <terminal/ecma48_iter.h>
+#include <terminal/screen_buffer.h>
+#include <terminal/terminal.h>
+#include <terminal/terminal_out.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Emulates the subset of VT behavior Clink relies on, entirely in memory, so
+// that rendering can be verified and measured without a console.  Wrapping
+// uses deferred (xterm style) semantics:  writing into the last column leaves
+// the cursor there until the next printable character is written.
+class headless_screen_buffer
+    : public screen_buffer
+{
+public:
+                    headless_screen_buffer(int32 columns=80, int32 rows=25);
+    virtual void    open() override {}
+    virtual void    begin() override {}
+    virtual void    end() override {}
+    virtual void    close() override {}
+    virtual void    write(const char* data, int32 length) override;
+    virtual void    flush() override {}
+    virtual int32   get_columns() const override { return m_columns; }
+    virtual int32   get_rows() const override { return m_rows; }
+    virtual bool    get_line_text(int32 line, str_base& out) const override;
+    virtual bool    has_native_vt_processing() const override { return false; }
+    virtual void    clear(clear_type type) override;
+    virtual void    clear_line(clear_type type) override;
+    virtual void    set_horiz_cursor(int32 column) override;
+    virtual void    set_cursor(int32 column, int32 row) override;
+    virtual void    move_cursor(int32 dx, int32 dy) override;
+    virtual void    save_cursor() override;
+    virtual void    restore_cursor() override;
+    virtual void    insert_chars(int32 count) override;
+    virtual void    delete_chars(int32 count) override;
+    virtual void    set_attributes(const attributes attr) override;
+    virtual bool    get_nearest_color(attributes& attr) const override { return true; }
+    virtual int32   is_line_default_color(int32 line) const override;
+    virtual int32   line_has_color(int32 line, const BYTE* attrs, int32 num_attrs, BYTE mask=0xff) const override;
+    virtual int32   find_line(int32 starting_line, int32 distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int32 num_attrs=0, BYTE mask=0xff) const override;
+
+    int32           get_cursor_column() const { return m_cursor_x; }
+    int32           get_cursor_row() const { return m_cursor_y; }
+    attributes      get_cell_attributes(int32 column, int32 row) const;
+    uint32          get_scrolled_lines() const { return m_scrolled; }
+
+private:
+    struct cell
+    {
+        char        text[16];
+        uint8       len;                // Zero means continuation of a wide char.
+        attributes  attr;
+    };
+
+    cell&           at(int32 column, int32 row) { return m_cells[row * m_columns + column]; }
+    const cell&     at(int32 column, int32 row) const { return m_cells[row * m_columns + column]; }
+    void            fill(int32 column, int32 row, int32 count);
+    void            line_feed();
+    void            put(const char* text, uint32 len, int32 width);
+    BYTE            get_console_attr(int32 column, int32 row) const;
+    bool            has_console_attr(int32 row, int32 column, int32 count, const BYTE* attrs, int32 num_attrs, BYTE mask) const;
+    const int32     m_columns;
+    const int32     m_rows;
+    std::vector<cell> m_cells;
+    attributes      m_attr;
+    int32           m_cursor_x = 0;
+    int32           m_cursor_y = 0;
+    int32           m_saved_x = -1;
+    int32           m_saved_y = -1;
+    bool            m_pending_wrap = false;
+    uint32          m_scrolled = 0;
+};
+
+//------------------------------------------------------------------------------
+struct render_stats
+{
+    uint32          writes = 0;         // Number of write() calls.
+    uint32          bytes = 0;          // Total bytes written.
+    uint32          escapes = 0;        // ESC and C1 sequences (CSI, OSC, etc).
+    uint32          controls = 0;       // C0 control characters.
+};
+
+//------------------------------------------------------------------------------
+// A terminal_out that renders into a headless_screen_buffer through the same
+// ecma48 processing used for real consoles, and counts what was written.
+class headless_terminal_out
+    : public terminal_out
+{
+public:
+                    headless_terminal_out(int32 columns=80, int32 rows=25);
+                    ~headless_terminal_out();
+    headless_screen_buffer& get_screen() { return m_screen; }
+    const render_stats& get_stats() const { return m_stats; }
+    void            reset_stats() { m_stats = render_stats(); }
+
+    virtual void    open() override;
+    virtual void    begin() override;
+    virtual void    end() override;
+    virtual void    close() override;
+    using           terminal_out::write;
+    virtual void    write(const char* chars, int32 length) override;
+    virtual void    flush() override;
+    virtual int32   get_columns() const override;
+    virtual int32   get_rows() const override;
+    virtual bool    get_line_text(int32 line, str_base& out) const override;
+    virtual int32   is_line_default_color(int32 line) const override;
+    virtual int32   line_has_color(int32 line, const BYTE* attrs, int32 num_attrs, BYTE mask=0xff) const override;
+    virtual int32   find_line(int32 starting_line, int32 distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int32 num_attrs=0, BYTE mask=0xff) const override;
+
+private:
+    headless_screen_buffer m_screen;
+    terminal        m_terminal;
+    ecma48_state    m_state;
+    render_stats    m_stats;
+};
@@ -132,7 +132,7 @@ line_editor_tester::line_editor_tester()
 }
 
 //------------------------------------------------------------------------------
-line_editor_tester::line_editor_tester(const line_editor::desc& _desc, const char* command_delims, const char* word_delims)
+line_editor_tester::line_editor_tester(const line_editor::desc& _desc, const char* command_delims, const char* word_delims, terminal_out* render_output)
 {
     line_editor::desc desc(_desc);
 
@@ -148,23 +148,27 @@ line_editor_tester::line_editor_tester(const line_editor::desc& _desc, const cha
     desc.command_tokeniser = m_command_tokeniser;
     desc.word_tokeniser = m_word_tokeniser;
 
-    create_line_editor(&desc);
+    create_line_editor(&desc, render_output);
 }
 
 //------------------------------------------------------------------------------
-void line_editor_tester::create_line_editor(const line_editor::desc* desc)
+void line_editor_tester::create_line_editor(const line_editor::desc* desc, terminal_out* render_output)
 {
     // Create a line editor.
     line_editor::desc inner_desc(nullptr, nullptr, nullptr, nullptr);
     if (desc != nullptr)
         inner_desc = *desc;
 
-    m_printer = new printer(m_terminal_out);
+    // The output in the desc is ignored; callers opt in to rendering somewhere
+    // else, e.g. into a headless_terminal_out, by passing render_output.
+    terminal_out* output = render_output ? render_output : &m_terminal_out;
 
-    m_printer_context = new printer_context(&m_terminal_out, m_printer);
+    m_printer = new printer(*output);
+
+    m_printer_context = new printer_context(output, m_printer);
 
     inner_desc.input = &m_terminal_in;
-    inner_desc.output = &m_terminal_out;
+    inner_desc.output = output;
     inner_desc.printer = m_printer;
 
     m_editor = line_editor_create(inner_desc);
@@ -62,7 +62,7 @@ class line_editor_tester
 {
 public:
                                 line_editor_tester();
-                                line_editor_tester(const line_editor::desc& desc, const char* command_delims, const char* word_delims);
+                                line_editor_tester(const line_editor::desc& desc, const char* command_delims, const char* word_delims, terminal_out* render_output=nullptr);
                                 ~line_editor_tester();
     line_editor*                get_editor() const;
     void                        set_input(const char* input);
@@ -78,7 +78,7 @@ public:
     void                        run(bool expectationless=false);
 
 private:
-    void                        create_line_editor(const line_editor::desc* desc=nullptr);
+    void                        create_line_editor(const line_editor::desc* desc=nullptr, terminal_out* render_output=nullptr);
     void                        expected_matches_impl(int32 dummy, ...);
     void                        expected_words_impl(int32 dummy, ...);
     bool                        get_line(str_base& line);
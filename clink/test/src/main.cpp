@@ -29,6 +29,7 @@ void set_noasync_recognizer();
 void set_test_harness();
 extern bool g_force_load_debugger;
 extern bool g_force_break_on_error;
+bool g_benchmarks = false;
 
 //------------------------------------------------------------------------------
 // NOTE:  If you get a linker error about these being "already defined", then
@@ -92,11 +93,16 @@ int32 main(int32 argc, char** argv)
         {
             puts("Options:\n"
                  "  -?        Show this help.\n"
+                 "  -b        Report benchmark measurements.\n"
                  "  -d        Load Lua debugger.\n"
                  "  -dd       Force break on Lua errors.\n"
                  "  -t        Show individual test times.");
             return 1;
         }
+        else if (!strcmp(argv[0], "-b"))
+        {
+            g_benchmarks = true;
+        }
         else if (!strcmp(argv[0], "-d"))
         {
             d_flag++;